@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2014-2021 Kevin Huck
+ * Copyright (c) 2014-2021 University of Oregon
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include "adaptive_sampling.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace apex {
+
+void sample_statistics::add(double sample) {
+    _count++;
+    double delta = sample - _mean;
+    _mean += delta / (double)_count;
+    _m2 += delta * (sample - _mean);
+}
+
+double sample_statistics::variance(void) const {
+    if (_count < 2) { return 0.0; }
+    return _m2 / (double)(_count - 1);
+}
+
+double sample_statistics::half_width(void) const {
+    /* Student's t for a two sided 95% interval, by degrees of freedom,
+     * and the normal quantile past the end of the table. */
+    static const double t95[] = { 0.0, 12.706, 4.303, 3.182, 2.776, 2.571,
+        2.447, 2.365, 2.306, 2.262, 2.228, 2.201, 2.179, 2.160, 2.145,
+        2.131, 2.120, 2.110, 2.101, 2.093, 2.086 };
+    static const size_t entries = sizeof(t95) / sizeof(t95[0]);
+    if (_count < 2) { return 0.0; }
+    size_t dof = _count - 1;
+    double t = dof < entries ? t95[dof] : 1.960;
+    return t * std::sqrt(variance() / (double)_count);
+}
+
+adaptive_sampler::adaptive_sampler(size_t min_samples, size_t max_samples,
+    double precision) : _min_samples(std::max((size_t)1, min_samples)),
+    _max_samples(std::max(min_samples, max_samples)), _precision(precision),
+    _have_incumbent(false), _cost(0.0), _samples(0), _candidates(0),
+    _discarded(0) {}
+
+/* Does the current configuration have enough samples? */
+bool adaptive_sampler::enough(void) {
+    size_t n = _current.count();
+    if (n < _min_samples) { return false; }
+    if (n >= _max_samples) { return true; }
+    double mean = _current.mean();
+    double half = _current.half_width();
+    if (_have_incumbent) {
+        double best = _incumbent.mean();
+        double best_half = _incumbent.half_width();
+        // clearly worse, don't spend any more time on it
+        if (mean - half > best + best_half) {
+            _discarded++;
+            return true;
+        }
+        // clearly better
+        if (mean + half < best - best_half) { return true; }
+    }
+    // within the noise, unless the interval is narrow already
+    return half <= _precision * std::fabs(mean);
+}
+
+bool adaptive_sampler::add(double sample) {
+    _samples++;
+    _current.add(sample);
+    if (!enough()) { return false; }
+    _cost = _current.mean();
+    if (!_have_incumbent || _cost < _incumbent.mean()) {
+        _incumbent = _current;
+        _have_incumbent = true;
+    }
+    _current.reset();
+    _candidates++;
+    return true;
+}
+
+} // apex
+
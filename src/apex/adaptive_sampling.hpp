@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2014-2021 Kevin Huck
+ * Copyright (c) 2014-2021 University of Oregon
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+
+/* Adaptive sampling of the metric of a tuning request.
+ *
+ * The in-tree strategies take one sample of the metric every time the
+ * request is triggered.  With adaptive sampling, the same configuration is
+ * measured again until the sampler decides it has enough samples, and the
+ * strategy is given their mean.  The sampler races every configuration
+ * against the best one so far (the incumbent), with a 95% confidence
+ * interval of the mean:
+ *
+ *  - a configuration that is clearly worse than the incumbent (the
+ *    intervals don't overlap) is discarded right away,
+ *  - one that is clearly better is accepted right away,
+ *  - one that is within the noise of the incumbent is sampled again, until
+ *    its interval is narrow (relative to its mean) or it has the most
+ *    samples allowed.
+ *
+ * So stable metrics need few samples, and noisy ones get more only when it
+ * matters for the choice of the best configuration.
+ */
+
+#include <stddef.h>
+
+namespace apex {
+
+/* The mean and variance of a stream of samples (Welford's algorithm) */
+class sample_statistics {
+private:
+    size_t _count;
+    double _mean;
+    double _m2;
+public:
+    sample_statistics(void) : _count(0), _mean(0.0), _m2(0.0) {}
+    void add(double sample);
+    void reset(void) { _count = 0; _mean = 0.0; _m2 = 0.0; }
+    size_t count(void) const { return _count; }
+    double mean(void) const { return _mean; }
+    double variance(void) const;
+    /* Half the width of the 95% confidence interval of the mean */
+    double half_width(void) const;
+};
+
+class adaptive_sampler {
+private:
+    size_t _min_samples;
+    size_t _max_samples;
+    double _precision; // the relative half width that is narrow enough
+    sample_statistics _current;
+    sample_statistics _incumbent;
+    bool _have_incumbent;
+    double _cost;
+    size_t _samples;
+    size_t _candidates;
+    size_t _discarded;
+    bool enough(void);
+public:
+    /* With the defaults, every sample is a whole evaluation, as without
+     * adaptive sampling. */
+    adaptive_sampler(size_t min_samples = 1, size_t max_samples = 1,
+        double precision = 0.05);
+    bool enabled(void) const { return _max_samples > 1; }
+    /* Add a sample of the current configuration.  Returns true when the
+     * configuration has enough samples, cost() is then its cost, and the
+     * next sample is of the next configuration. */
+    bool add(double sample);
+    double cost(void) const { return _cost; }
+    size_t samples(void) const { return _samples; }
+    size_t candidates(void) const { return _candidates; }
+    /* The configurations that were discarded as clearly worse */
+    size_t discarded(void) const { return _discarded; }
+};
+
+} // apex
+
@@ -9,7 +9,13 @@
 #include "address_resolution.hpp"
 #include <sstream>
 #include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <algorithm>
 #include <unordered_map>
+#include <string.h>
+#include <unistd.h>
+#include "utils.hpp"
 
 #ifdef __APPLE__
 #include <dlfcn.h>
@@ -17,6 +23,9 @@
 #if defined(TAU_HAVE_CORESYMBOLICATION)
 #include "CoreSymbolication.h"
 #endif
+#else
+#include <link.h>
+#include <elf.h>
 #endif /* __APPLE__ */
 
 using namespace std;
@@ -27,28 +36,34 @@ namespace apex {
   address_resolution * address_resolution::_instance = nullptr;
   shared_mutex_type address_resolution::_bfd_mutex;
 
-  /* Map a function address to a name and/or source location */
-  string * lookup_address(uintptr_t ip, bool withFileInfo) {
-    address_resolution * ar = address_resolution::instance();
+  /* Build the printable location string for a resolved address */
+  static void set_location(address_resolution::my_hash_node * node) {
     stringstream location;
-    address_resolution::my_hash_node * node = nullptr;
-    std::unordered_map<uintptr_t, address_resolution::my_hash_node*>::const_iterator it;
-    {
-        read_lock_type l(ar->_bfd_mutex);
-        it = ar->my_hash_table.find(ip);
+    if (node->info.demangled) {
+      location << node->info.demangled ;
+    } else if (node->info.funcname) {
+      location << node->info.funcname ;
     }
-    // address not found? We need to resolve it.
-    if (it == ar->my_hash_table.end()) {
-      // only one thread should resolve it.
-      write_lock_type l(ar->_bfd_mutex);
-      // now that we have the lock, did someone else resolve it?
-      const std::unordered_map<uintptr_t,
-            address_resolution::my_hash_node*>::const_iterator it2 =
-            ar->my_hash_table.find(ip);
-      if (it2 == ar->my_hash_table.end()) {
-        // ...no - so go get it!
-        node = new address_resolution::my_hash_node();
+    if (apex_options::use_source_location()) {
+        location << " [{" ;
+        if (node->info.filename) {
+        location << node->info.filename ;
+        }
+        location << "} {" << node->info.lineno << ",0}]";
+    } else {
+        if (node->info.lineno != 0) {
+            // to disambiguate C++ functions
+            location << ":" << node->info.lineno;
+        }
+    }
+    node->location = new string(location.str());
+  }
+
+  /* Resolve a single address, using the on-disk cache if we can. */
+  static void resolve_one(address_resolution * ar, uintptr_t ip,
+    address_resolution::my_hash_node * node) {
 #if defined(__APPLE__)
+    APEX_UNUSED(ar);
 #if defined(APEX_HAVE_CORESYMBOLICATION)
       static CSSymbolicatorRef symbolicator = CSSymbolicatorCreateWithPid(getpid());
       CSSourceInfoRef source_info = CSSymbolicatorGetSourceInfoWithAddressAtTime(symbolicator, (vm_address_t)ip, kCSNow);
@@ -73,27 +88,35 @@ namespace apex {
       }
 #endif
 #else
+    if (!ar->read_cache(ip, node)) {
         Apex_bfd_resolveBfdInfo(ar->my_bfd_unit_handle, ip, node->info);
+        ar->write_cache(ip, node);
+    }
 #endif
+  }
 
-        if (node->info.demangled) {
-          location << node->info.demangled ;
-        } else if (node->info.funcname) {
-          location << node->info.funcname ;
-        }
-        if (apex_options::use_source_location()) {
-            location << " [{" ;
-            if (node->info.filename) {
-            location << node->info.filename ;
-            }
-            location << "} {" << node->info.lineno << ",0}]";
-        } else {
-            if (node->info.lineno != 0) {
-                // to disambiguate C++ functions
-                location << ":" << node->info.lineno;
-            }
-        }
-        node->location = new string(location.str());
+  /* Map a function address to a name and/or source location */
+  string * lookup_address(uintptr_t ip, bool withFileInfo) {
+    address_resolution * ar = address_resolution::instance();
+    address_resolution::my_hash_node * node = nullptr;
+    std::unordered_map<uintptr_t, address_resolution::my_hash_node*>::const_iterator it;
+    {
+        read_lock_type l(ar->_bfd_mutex);
+        it = ar->my_hash_table.find(ip);
+    }
+    // address not found? We need to resolve it.
+    if (it == ar->my_hash_table.end()) {
+      // only one thread should resolve it.
+      write_lock_type l(ar->_bfd_mutex);
+      // now that we have the lock, did someone else resolve it?
+      const std::unordered_map<uintptr_t,
+            address_resolution::my_hash_node*>::const_iterator it2 =
+            ar->my_hash_table.find(ip);
+      if (it2 == ar->my_hash_table.end()) {
+        // ...no - so go get it!
+        node = new address_resolution::my_hash_node();
+        resolve_one(ar, ip, node);
+        set_location(node);
         ar->my_hash_table[ip] = node;
       } else {
         node = it2->second;
@@ -111,4 +134,211 @@ namespace apex {
       }
     }
   }
+
+  void resolve_addresses(std::vector<uintptr_t> addresses) {
+    address_resolution * ar = address_resolution::instance();
+    std::sort(addresses.begin(), addresses.end());
+    addresses.erase(std::unique(addresses.begin(), addresses.end()),
+        addresses.end());
+    write_lock_type l(ar->_bfd_mutex);
+    // skip anything already resolved or in the on-disk cache
+    std::vector<unsigned long> todo;
+    for (auto ip : addresses) {
+        if (ar->my_hash_table.find(ip) != ar->my_hash_table.end()) {
+            continue;
+        }
+        address_resolution::my_hash_node * node =
+            new address_resolution::my_hash_node();
+        if (ar->read_cache(ip, node)) {
+            set_location(node);
+            ar->my_hash_table[ip] = node;
+        } else {
+            delete node;
+            todo.push_back(ip);
+        }
+    }
+    if (todo.size() == 0) { return; }
+#if defined(__APPLE__)
+    for (auto ip : todo) {
+        address_resolution::my_hash_node * node =
+            new address_resolution::my_hash_node();
+        resolve_one(ar, ip, node);
+        set_location(node);
+        ar->my_hash_table[ip] = node;
+    }
+#else
+    std::vector<ApexBfdInfo> infos(todo.size());
+    Apex_bfd_resolveBfdInfoBatch(ar->my_bfd_unit_handle, todo.data(),
+        infos.data(), todo.size());
+    for (size_t i = 0 ; i < todo.size() ; i++) {
+        address_resolution::my_hash_node * node =
+            new address_resolution::my_hash_node();
+        // take ownership of the strings, so they aren't freed twice
+        node->info.probeAddr = infos[i].probeAddr;
+        node->info.filename = infos[i].filename;
+        node->info.funcname = infos[i].funcname;
+        node->info.demangled = infos[i].demangled;
+        node->info.lineno = infos[i].lineno;
+        node->info.discriminator = infos[i].discriminator;
+        infos[i].funcname = nullptr;
+        infos[i].demangled = nullptr;
+        ar->write_cache(todo[i], node);
+        set_location(node);
+        ar->my_hash_table[todo[i]] = node;
+    }
+#endif
+  }
+
+#if !defined(__APPLE__)
+  static int find_build_ids(struct dl_phdr_info * info, size_t size,
+    void * data) {
+    APEX_UNUSED(size);
+    std::vector<symbol_cache_module> * modules =
+        (std::vector<symbol_cache_module>*)(data);
+    symbol_cache_module m;
+    bool first = true;
+    for (int j = 0 ; j < info->dlpi_phnum ; j++) {
+        const ElfW(Phdr) & phdr = info->dlpi_phdr[j];
+        if (phdr.p_type == PT_LOAD) {
+            uintptr_t lo = info->dlpi_addr + phdr.p_vaddr;
+            uintptr_t hi = lo + phdr.p_memsz;
+            if (first || lo < m.start) { m.start = lo; }
+            if (first || hi > m.end) { m.end = hi; }
+            first = false;
+        } else if (phdr.p_type == PT_NOTE) {
+            // walk the notes, looking for the GNU build-id
+            const char * note = (const char*)(info->dlpi_addr + phdr.p_vaddr);
+            const char * note_end = note + phdr.p_memsz;
+            while (note + sizeof(ElfW(Nhdr)) <= note_end) {
+                const ElfW(Nhdr) * nhdr = (const ElfW(Nhdr)*)(note);
+                const char * name = note + sizeof(ElfW(Nhdr));
+                const unsigned char * desc = (const unsigned char*)
+                    (name + ((nhdr->n_namesz + 3) & ~3));
+                if (nhdr->n_type == NT_GNU_BUILD_ID &&
+                    nhdr->n_namesz == 4 && memcmp(name, "GNU", 4) == 0) {
+                    stringstream ss;
+                    ss << hex << setfill('0');
+                    for (size_t i = 0 ; i < nhdr->n_descsz ; i++) {
+                        ss << setw(2) << (int)(desc[i]);
+                    }
+                    m.build_id = ss.str();
+                }
+                note = (const char*)(desc) + ((nhdr->n_descsz + 3) & ~3);
+            }
+        }
+    }
+    if (!first && m.build_id.size() > 0) {
+        m.base = info->dlpi_addr;
+        modules->push_back(m);
+    }
+    return 0;
+  }
+#endif
+
+  void address_resolution::find_cache_modules(void) {
+    if (strlen(apex_options::symbol_cache_path()) == 0) { return; }
+#if !defined(__APPLE__)
+    dl_iterate_phdr(find_build_ids, &cache_modules);
+#endif
+  }
+
+  symbol_cache_module * address_resolution::find_cache_module(uintptr_t ip) {
+    for (auto& m : cache_modules) {
+        if (ip >= m.start && ip < m.end) {
+            if (!m.loaded) { m.load(); }
+            return &m;
+        }
+    }
+    return nullptr;
+  }
+
+  bool address_resolution::read_cache(uintptr_t ip, my_hash_node * node) {
+    symbol_cache_module * m = find_cache_module(ip);
+    if (m == nullptr) { return false; }
+    auto it = m->entries.find(ip - m->base);
+    if (it == m->entries.end()) { return false; }
+    const symbol_cache_module::entry& e = it->second;
+    node->info.probeAddr = ip;
+    node->info.lineno = e.lineno;
+    node->info.funcname = e.funcname.size() > 0 ?
+        strdup(e.funcname.c_str()) : nullptr;
+    node->info.demangled = e.demangled.size() > 0 ?
+        strdup(e.demangled.c_str()) : nullptr;
+    node->info.filename = e.filename.size() > 0 ?
+        strdup(e.filename.c_str()) : nullptr;
+    return true;
+  }
+
+  void address_resolution::write_cache(uintptr_t ip, my_hash_node * node) {
+    symbol_cache_module * m = find_cache_module(ip);
+    if (m == nullptr) { return; }
+    symbol_cache_module::entry e;
+    e.lineno = node->info.lineno;
+    e.funcname = node->info.funcname ? node->info.funcname : "";
+    // don't store the same string twice
+    e.demangled = (node->info.demangled &&
+        node->info.demangled != node->info.funcname) ?
+        node->info.demangled : "";
+    e.filename = node->info.filename ? node->info.filename : "";
+    m->entries[ip - m->base] = e;
+    m->dirty = true;
+  }
+
+  std::string symbol_cache_module::filename(void) {
+    stringstream ss;
+    ss << apex_options::symbol_cache_path() << filesystem_separator()
+       << build_id << ".symbols";
+    return ss.str();
+  }
+
+  /* The cache file is one line per address:
+   * offset, line number, function name, demangled name, file name,
+   * separated by tabs.  Existing entries are not overwritten, so this
+   * is also used to merge with the file before saving it. */
+  void symbol_cache_module::load(void) {
+    loaded = true;
+    std::ifstream in(filename());
+    if (!in.is_open()) { return; }
+    std::string line;
+    while (std::getline(in, line)) {
+        std::vector<std::string> fields;
+        size_t pos = 0;
+        size_t next;
+        while ((next = line.find('\t', pos)) != std::string::npos) {
+            fields.push_back(line.substr(pos, next - pos));
+            pos = next + 1;
+        }
+        fields.push_back(line.substr(pos));
+        if (fields.size() != 5) { continue; }
+        entry e;
+        uintptr_t offset = strtoull(fields[0].c_str(), nullptr, 16);
+        e.lineno = atoi(fields[1].c_str());
+        e.funcname = fields[2];
+        e.demangled = fields[3];
+        e.filename = fields[4];
+        entries.insert(std::make_pair(offset, e));
+    }
+  }
+
+  void symbol_cache_module::save(void) {
+    if (!dirty) { return; }
+    // pick up anything written by other processes since we loaded it
+    load();
+    // write to a temporary file and rename it, so that readers never
+    // see a partial file.
+    stringstream tmpname;
+    tmpname << filename() << "." << getpid();
+    std::ofstream out(tmpname.str());
+    if (!out.is_open()) { return; }
+    for (auto& kv : entries) {
+        out << hex << kv.first << dec << "\t" << kv.second.lineno << "\t"
+            << kv.second.funcname << "\t" << kv.second.demangled << "\t"
+            << kv.second.filename << "\n";
+    }
+    out.close();
+    if (rename(tmpname.str().c_str(), filename().c_str()) != 0) {
+        remove(tmpname.str().c_str());
+    }
+    dirty = false;
+  }
 }
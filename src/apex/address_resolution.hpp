@@ -23,19 +23,50 @@
 #include <mutex>
 #include "apex_cxx_shared_lock.hpp"
 #include <unordered_map>
+#include <vector>
 
 namespace apex {
 
+  /* On-disk cache of resolved symbols for one loaded object (the
+   * executable or a shared library).  Entries are keyed by the offset from
+   * the object's load address, and the file is named by the ELF build-id,
+   * so a later run of the same binary can skip BFD entirely. */
+  class symbol_cache_module {
+    public:
+      struct entry {
+        int lineno;
+        std::string funcname;
+        std::string demangled;
+        std::string filename;
+      };
+      uintptr_t start;
+      uintptr_t end;
+      uintptr_t base;
+      std::string build_id;
+      bool loaded;
+      bool dirty;
+      std::unordered_map<uintptr_t, entry> entries;
+      symbol_cache_module() : start(0), end(0), base(0), build_id(""),
+        loaded(false), dirty(false) {}
+      std::string filename(void);
+      void load(void);
+      void save(void);
+  };
+
   class address_resolution {
       private:
         static address_resolution * _instance;
         address_resolution(void) {
           my_bfd_unit_handle = Apex_bfd_registerUnit();
+          find_cache_modules();
         };
         // copy constructor is private
         address_resolution(address_resolution const&);
         // assignment operator is private
         address_resolution& operator=(address_resolution const& a);
+        std::vector<symbol_cache_module> cache_modules;
+        void find_cache_modules(void);
+        symbol_cache_module * find_cache_module(uintptr_t ip);
       public:
         static shared_mutex_type _bfd_mutex;
 
@@ -47,6 +78,9 @@ namespace apex {
         std::string * location;
       };
 
+      bool read_cache(uintptr_t ip, my_hash_node * node);
+      void write_cache(uintptr_t ip, my_hash_node * node);
+
       static address_resolution * instance() {
           if (_instance == nullptr) {
               // only one thread should instantiate it!
@@ -64,6 +98,9 @@ namespace apex {
       ~address_resolution(void) {
         // call apex::finalize() just in case!
         finalize();
+        for (auto& m : cache_modules) {
+          m.save();
+        }
         for ( std::unordered_map<uintptr_t,
               my_hash_node*>::iterator it = my_hash_table.begin();
               it != my_hash_table.end(); ++it ) {
@@ -81,6 +118,10 @@ namespace apex {
   };
 
   std::string * lookup_address(uintptr_t ip, bool withFileInfo);
+  /* Resolve a set of addresses at once (e.g. all of the timer addresses
+   * at dump time), so that later calls to lookup_address are just hash
+   * table hits. */
+  void resolve_addresses(std::vector<uintptr_t> addresses);
 
 }
 
@@ -43,6 +43,12 @@
 #include "tau_listener.hpp"
 #include "profiler_listener.hpp"
 #include "trace_event_listener.hpp"
+#include "flight_recorder_listener.hpp"
+#include "critical_path_listener.hpp"
+#include "record_listener.hpp"
+#include "queue_wait.hpp"
+#include "pool_allocator.hpp"
+#include "policy_rules.hpp"
 #if defined(APEX_DEBUG) || defined(APEX_ERROR_HANDLING)
 // #define APEX_DEBUG_disabled
 #include "apex_error_handling.hpp"
@@ -112,6 +118,17 @@ std::atomic<apex*> apex::m_pInstance(nullptr);
 
 std::atomic<bool> _notify_listeners(true);
 std::atomic<bool> _measurement_stopped(false);
+
+/* With APEX_TRACE_WINDOWS, the tracing listeners only see the timers that
+ * started inside a trace window, and the samples and messages that happen
+ * inside one. */
+inline bool outside_trace_window(event_listener * listener, profiler * p) {
+    return listener->in_trace_windows && (p == nullptr || !p->traced);
+}
+inline bool outside_trace_window(event_listener * listener) {
+    return listener->in_trace_windows &&
+        !profiler::in_trace_window(profiler::now_ns());
+}
 profiler * top_level_timer() {
     static APEX_NATIVE_TLS profiler * top_level_timer = nullptr;
     return top_level_timer;
@@ -277,6 +294,10 @@ void apex::_initialize()
     }
     {
         //write_lock_type l(listener_mutex);
+        // with trace windows, nothing is traced until a window is opened
+        if (apex_options::use_trace_windows()) {
+            profiler::trace_window_end().store(0);
+        }
         this->the_profiler_listener = new profiler_listener();
         // this is always the first listener!
         listeners.push_back(the_profiler_listener);
@@ -288,14 +309,30 @@ void apex::_initialize()
         if (apex_options::use_otf2())
         {
             the_otf2_listener = new otf2_listener();
+            the_otf2_listener->in_trace_windows =
+                apex_options::use_trace_windows();
             listeners.push_back(the_otf2_listener);
         }
 #endif
         if (apex_options::use_trace_event())
         {
             the_trace_event_listener = new trace_event_listener();
+            the_trace_event_listener->in_trace_windows =
+                apex_options::use_trace_windows();
             listeners.push_back(the_trace_event_listener);
         }
+        if (apex_options::use_flight_recorder())
+        {
+            listeners.push_back(new flight_recorder_listener());
+        }
+        if (apex_options::use_critical_path())
+        {
+            listeners.push_back(new critical_path_listener());
+        }
+        if (apex_options::use_record_events())
+        {
+            listeners.push_back(new record_listener());
+        }
 
 /* For the Jupyter support, always enable the concurrency handler. */
         if (apex_options::use_jupyter_support() ||
@@ -459,6 +496,7 @@ uint64_t init(const char * thread_name, uint64_t comm_rank,
         apex_options::throttle_concurrency() ) {
       setup_power_cap_throttling();
     }
+    policy_rules::initialize();
     // this code should be absorbed from "new node" event to "on_startup" event.
     node_event_data node_data(comm_rank, thread_instance::get_id());
     if (_notify_listeners) {
@@ -500,28 +538,27 @@ inline std::shared_ptr<task_wrapper> _new_task(
     const uint64_t task_id,
     const std::shared_ptr<task_wrapper> parent_task, apex* instance) {
     APEX_UNUSED(instance);
-    std::shared_ptr<task_wrapper> tt_ptr = make_shared<task_wrapper>();
+    std::shared_ptr<task_wrapper> tt_ptr =
+        std::allocate_shared<task_wrapper>(pool_allocator<task_wrapper>());
     tt_ptr->task_id = id;
-    // if not tracking dependencies, don't save the parent
-    /* Why?
-    if ((!apex_options::use_taskgraph_output()) &&
-         !apex_options::use_otf2()) {
-        tt_ptr->parent = task_wrapper::get_apex_main_wrapper();
-    // was a parent passed in?
-    } else */ if (parent_task != nullptr) {
-        tt_ptr->parent_guid = parent_task->guid;
-        tt_ptr->parent = parent_task;
-    // if not, is there a current timer?
-    } else {
+    // was a parent passed in? if not, is there a current timer?
+    std::shared_ptr<task_wrapper> parent = parent_task;
+    if (parent == nullptr) {
         profiler * p = thread_instance::instance().get_current_profiler();
-        if (p != nullptr) {
-            tt_ptr->parent_guid = p->guid;
-            tt_ptr->parent = p->tt_ptr;
+        if (p != nullptr && p->tt_ptr != nullptr) {
+            parent = p->tt_ptr;
         } else {
-            tt_ptr->parent = task_wrapper::get_apex_main_wrapper();
-            // tt_ptr->parent_guid is 0 by default
+            parent = task_wrapper::get_apex_main_wrapper();
         }
     }
+    // keep only what we need from the parent, so that long chains of
+    // tasks don't keep all of their ancestors alive
+    tt_ptr->parent_guid = parent->guid;
+    tt_ptr->parent_task_id = parent->get_task_id();
+    tt_ptr->parent_tree_node = parent->tree_node;
+    if (apex_options::use_critical_path()) {
+        tt_ptr->parent = parent;
+    }
     if (apex_options::use_tasktree_output()) {
         tt_ptr->assign_heritage();
     }
@@ -536,26 +573,27 @@ inline std::shared_ptr<task_wrapper> _new_task(
     return tt_ptr;
 }
 
-profiler* start(const std::string &timer_name)
-{
-    in_apex prevent_deadlocks;
-    // if APEX is disabled, do nothing.
-    if (apex_options::disable() == true) {
-        APEX_UTIL_REF_COUNT_DISABLED_START
-        return nullptr;
+/* Tasks created by the runtime wait in a queue until they are started. */
+inline void _mark_task_creation(std::shared_ptr<task_wrapper> &tt_ptr) {
+    if (apex_options::use_queue_wait()) {
+        tt_ptr->create_ns = profiler::now_ns();
+        tt_ptr->create_thread = thread_instance::get_id();
     }
-    //printf("%lu: %s\n", thread_instance::get_id(), timer_name.c_str());
-    //fflush(stdout);
+}
+
+/* Don't time our own events (queue scrubbing tasks), or filtered events */
+static bool _exclude_timer(const std::string &timer_name) {
     static const std::string apex_internal("apex_internal");
     if (starts_with(timer_name, apex_internal)) {
         APEX_UTIL_REF_COUNT_APEX_INTERNAL_START
-        // don't process our own events - queue scrubbing tasks.
-        return profiler::get_disabled_profiler();
-    }
-    // don't time filtered events
-    if (event_filter::instance().have_filter && event_filter::exclude(timer_name)) {
-        return profiler::get_disabled_profiler();
+        return true;
     }
+    return event_filter::instance().have_filter &&
+        event_filter::exclude(timer_name);
+}
+
+/* Start a timer that has passed the checks of its name */
+static profiler* _start(task_identifier * task_id, bool internal) {
     apex* instance = apex::instance(); // get the Apex static instance
     // protect against calls after finalization
     if (!instance || _exited) {
@@ -571,17 +609,19 @@ profiler* start(const std::string &timer_name)
     profiler * new_profiler = nullptr;
     if (_notify_listeners) {
         bool success = true;
-        task_identifier * id = task_identifier::get_task_id(timer_name);
-        tt_ptr = _new_task(id, UINTMAX_MAX, null_task_wrapper, instance);
+        tt_ptr = _new_task(task_id, UINTMAX_MAX, null_task_wrapper, instance);
         APEX_UTIL_REF_COUNT_TASK_WRAPPER
         //read_lock_type l(instance->listener_mutex);
-        //cout << thread_instance::get_id() << " Start : " << id->get_name() <<
-        //endl; fflush(stdout);
+        //cout << thread_instance::get_id() << " Start : " <<
+        //task_id->get_name() << endl; fflush(stdout);
         for (unsigned int i = 0 ; i < instance->listeners.size() ; i++) {
+            if (outside_trace_window(instance->listeners[i], tt_ptr->prof)) {
+                continue;
+            }
             success = instance->listeners[i]->on_start(tt_ptr);
             if (!success && i == 0) {
                 //cout << thread_instance::get_id() << " *** Not success! " <<
-                //id->get_name() << endl; fflush(stdout);
+                //task_id->get_name() << endl; fflush(stdout);
                 APEX_UTIL_REF_COUNT_FAILED_START
                 return profiler::get_disabled_profiler();
             }
@@ -592,8 +632,7 @@ profiler* start(const std::string &timer_name)
             thread_instance::instance().clear_current_profiler();
         }
     }
-    static std::string apex_process_profile_str("apex::process_profiles");
-    if (timer_name.compare(apex_process_profile_str) == 0) {
+    if (internal) {
         APEX_UTIL_REF_COUNT_APEX_INTERNAL_START
     } else {
         APEX_UTIL_REF_COUNT_START
@@ -604,54 +643,57 @@ profiler* start(const std::string &timer_name)
     return thread_instance::instance().restore_children_profilers(tt_ptr);
 }
 
-profiler* start(const apex_function_address function_address) {
+profiler* start(const std::string &timer_name)
+{
     in_apex prevent_deadlocks;
     // if APEX is disabled, do nothing.
     if (apex_options::disable() == true) {
         APEX_UTIL_REF_COUNT_DISABLED_START
         return nullptr;
     }
-    apex* instance = apex::instance(); // get the Apex static instance
-    // protect against calls after finalization
-    if (!instance || _exited) {
+    //printf("%lu: %s\n", thread_instance::get_id(), timer_name.c_str());
+    //fflush(stdout);
+    if (_exclude_timer(timer_name)) {
+        return profiler::get_disabled_profiler();
+    }
+    // protect against calls after finalization, before the lookup
+    if (!apex::instance() || _exited) {
         APEX_UTIL_REF_COUNT_START_AFTER_FINALIZE
         return nullptr;
     }
-    // if APEX is suspended, do nothing.
-    if (apex_options::suspend() == true) {
-        APEX_UTIL_REF_COUNT_SUSPENDED_START
-        return profiler::get_disabled_profiler();
+    static std::string apex_process_profile_str("apex::process_profiles");
+    return _start(task_identifier::get_task_id(timer_name),
+        timer_name.compare(apex_process_profile_str) == 0);
+}
+
+profiler* start(const apex_function_address function_address) {
+    in_apex prevent_deadlocks;
+    // if APEX is disabled, do nothing.
+    if (apex_options::disable() == true) {
+        APEX_UTIL_REF_COUNT_DISABLED_START
+        return nullptr;
     }
-    std::shared_ptr<task_wrapper> tt_ptr(nullptr);
-    profiler * new_profiler = nullptr;
-    if (_notify_listeners) {
-        bool success = true;
-        task_identifier * id = task_identifier::get_task_id(function_address);
-        tt_ptr = _new_task(id, UINTMAX_MAX, null_task_wrapper, instance);
-        APEX_UTIL_REF_COUNT_TASK_WRAPPER
-        //cout << thread_instance::get_id() << " Start : " << id->get_name() <<
-        //endl; fflush(stdout);
-        //read_lock_type l(instance->listener_mutex);
-        for (unsigned int i = 0 ; i < instance->listeners.size() ; i++) {
-            success = instance->listeners[i]->on_start(tt_ptr);
-            if (!success && i == 0) {
-                //cout << thread_instance::get_id() << " *** Not success! " <<
-                //id->get_name() << endl; fflush(stdout);
-                APEX_UTIL_REF_COUNT_FAILED_START
-                return profiler::get_disabled_profiler();
-            }
-        }
-        // If we are allowing untied timers, clear the timer stack on this thread
-        if (apex_options::untied_timers() == true) {
-            new_profiler = thread_instance::instance().get_current_profiler();
-            thread_instance::instance().clear_current_profiler();
-        }
+    // protect against calls after finalization, before the lookup
+    if (!apex::instance() || _exited) {
+        APEX_UTIL_REF_COUNT_START_AFTER_FINALIZE
+        return nullptr;
     }
-    APEX_UTIL_REF_COUNT_START
-    if (apex_options::untied_timers() == true) {
-        return new_profiler;
+    return _start(task_identifier::get_task_id(function_address), false);
+}
+
+profiler* start(task_identifier * task_id) {
+    in_apex prevent_deadlocks;
+    // if APEX is disabled, do nothing.
+    if (apex_options::disable() == true) {
+        APEX_UTIL_REF_COUNT_DISABLED_START
+        return nullptr;
     }
-    return thread_instance::instance().restore_children_profilers(tt_ptr);
+    // a timer without a name, or a name that isn't timed
+    if (task_id == nullptr ||
+        (task_id->has_name && _exclude_timer(task_id->name))) {
+        return profiler::get_disabled_profiler();
+    }
+    return _start(task_id, false);
 }
 
 void debug_print(const char * event, std::shared_ptr<task_wrapper> tt_ptr) {
@@ -703,12 +745,22 @@ void start(std::shared_ptr<task_wrapper> tt_ptr) {
         tt_ptr->prof = profiler::get_disabled_profiler();
         return;
     }
+    // the first start of a task ends its wait in the queue
+    if (tt_ptr->create_ns != 0) {
+        uint64_t now = profiler::now_ns();
+        if (now > tt_ptr->create_ns) {
+            queue_wait_add(tt_ptr->get_task_id(), now - tt_ptr->create_ns);
+        }
+    }
     if (_notify_listeners) {
         bool success = true;
         //cout << thread_instance::get_id() << " Start : " <<tt_ptr->task_id->get_name() <<
         //endl; fflush(stdout);
         //read_lock_type l(instance->listener_mutex);
         for (unsigned int i = 0 ; i < instance->listeners.size() ; i++) {
+            if (outside_trace_window(instance->listeners[i], tt_ptr->prof)) {
+                continue;
+            }
             success = instance->listeners[i]->on_start(tt_ptr);
             tt_ptr->prof = thread_instance::instance().get_current_profiler();
             if (!success && i == 0) {
@@ -716,6 +768,7 @@ void start(std::shared_ptr<task_wrapper> tt_ptr) {
                 //id->get_name() << endl; fflush(stdout);
                 APEX_UTIL_REF_COUNT_FAILED_START
                 tt_ptr->prof = profiler::get_disabled_profiler();
+                tt_ptr->create_ns = 0;
                 return;
             }
         }
@@ -724,6 +777,8 @@ void start(std::shared_ptr<task_wrapper> tt_ptr) {
             thread_instance::instance().clear_current_profiler();
         }
     }
+    // the listeners have seen the creation time, now it's a restart
+    tt_ptr->create_ns = 0;
     APEX_UTIL_REF_COUNT_START
     thread_instance::instance().restore_children_profilers(tt_ptr);
     return;
@@ -764,6 +819,9 @@ profiler* resume(const std::string &timer_name) {
         try {
             //read_lock_type l(instance->listener_mutex);
             for (unsigned int i = 0 ; i < instance->listeners.size() ; i++) {
+                if (outside_trace_window(instance->listeners[i], tt_ptr->prof)) {
+                    continue;
+                }
                 instance->listeners[i]->on_resume(tt_ptr);
             }
         } catch (disabled_profiler_exception &e) {
@@ -806,6 +864,9 @@ profiler* resume(const apex_function_address function_address) {
         try {
             //read_lock_type l(instance->listener_mutex);
             for (unsigned int i = 0 ; i < instance->listeners.size() ; i++) {
+                if (outside_trace_window(instance->listeners[i], tt_ptr->prof)) {
+                    continue;
+                }
                 instance->listeners[i]->on_resume(tt_ptr);
             }
         } catch (disabled_profiler_exception &e) {
@@ -845,6 +906,9 @@ profiler* resume(profiler * p) {
             // skip the profiler_listener - we are restoring a child timer
             // for a parent that was yielded.
             for (unsigned int i = 1 ; i < instance->listeners.size() ; i++) {
+                if (outside_trace_window(instance->listeners[i], p)) {
+                    continue;
+                }
                 instance->listeners[i]->on_resume(p->tt_ptr);
             }
         } catch (disabled_profiler_exception &e) {
@@ -862,6 +926,66 @@ profiler* resume(profiler * p) {
     return p;
 }
 
+void resume(std::shared_ptr<task_wrapper> tt_ptr) {
+    in_apex prevent_deadlocks;
+    if (tt_ptr == nullptr) {
+        APEX_UTIL_REF_COUNT_APEX_INTERNAL_RESUME
+        return;
+    }
+    // if APEX is disabled, do nothing.
+    if (apex_options::disable() == true) {
+        APEX_UTIL_REF_COUNT_DISABLED_RESUME
+        tt_ptr->prof = nullptr;
+        return;
+    }
+    // don't time filtered events
+    if (event_filter::instance().have_filter && event_filter::exclude(tt_ptr->task_id->get_name())) {
+        tt_ptr->prof = nullptr;
+        return;
+    }
+    apex* instance = apex::instance(); // get the Apex static instance
+    // protect against calls after finalization
+    if (!instance || _exited) {
+        APEX_UTIL_REF_COUNT_RESUME_AFTER_FINALIZE
+        tt_ptr->prof = nullptr;
+        return;
+    }
+    // if APEX is suspended, do nothing.
+    if (apex_options::suspend() == true) {
+        APEX_UTIL_REF_COUNT_SUSPENDED_RESUME
+        tt_ptr->prof = profiler::get_disabled_profiler();
+        return;
+    }
+    if (_notify_listeners) {
+        try {
+            //read_lock_type l(instance->listener_mutex);
+            for (unsigned int i = 0 ; i < instance->listeners.size() ; i++) {
+                if (outside_trace_window(instance->listeners[i], tt_ptr->prof)) {
+                    continue;
+                }
+                bool success = instance->listeners[i]->on_resume(tt_ptr);
+                tt_ptr->prof = thread_instance::instance().get_current_profiler();
+                if (!success && i == 0) {
+                    APEX_UTIL_REF_COUNT_FAILED_RESUME
+                    tt_ptr->prof = profiler::get_disabled_profiler();
+                    return;
+                }
+            }
+        } catch (disabled_profiler_exception &e) {
+            APEX_UTIL_REF_COUNT_FAILED_RESUME
+            tt_ptr->prof = profiler::get_disabled_profiler();
+            return;
+        }
+        // If we are allowing untied timers, clear the timer stack on this thread
+        if (apex_options::untied_timers() == true) {
+            thread_instance::instance().clear_current_profiler();
+        }
+    }
+    APEX_UTIL_REF_COUNT_RESUME
+    thread_instance::instance().restore_children_profilers(tt_ptr);
+    return;
+}
+
 void reset(const std::string &timer_name) {
     in_apex prevent_deadlocks;
     // if APEX is disabled, do nothing.
@@ -943,6 +1067,9 @@ void stop(profiler* the_profiler, bool cleanup) {
     if (_notify_listeners) {
         //read_lock_type l(instance->listener_mutex);
         for (unsigned int i = 0 ; i < instance->listeners.size() ; i++) {
+            if (outside_trace_window(instance->listeners[i], p.get())) {
+                continue;
+            }
             instance->listeners[i]->on_stop(p);
         }
     }
@@ -997,6 +1124,9 @@ void stop(std::shared_ptr<task_wrapper> tt_ptr) {
     if (_notify_listeners) {
         //read_lock_type l(instance->listener_mutex);
         for (unsigned int i = 0 ; i < instance->listeners.size() ; i++) {
+            if (outside_trace_window(instance->listeners[i], p.get())) {
+                continue;
+            }
             instance->listeners[i]->on_stop(p);
         }
     }
@@ -1044,6 +1174,9 @@ void yield(profiler* the_profiler)
     if (_notify_listeners) {
         //read_lock_type l(instance->listener_mutex);
         for (unsigned int i = 0 ; i < instance->listeners.size() ; i++) {
+            if (outside_trace_window(instance->listeners[i], p.get())) {
+                continue;
+            }
             instance->listeners[i]->on_yield(p);
         }
     }
@@ -1093,6 +1226,9 @@ void yield(std::shared_ptr<task_wrapper> tt_ptr)
     if (_notify_listeners) {
         //read_lock_type l(instance->listener_mutex);
         for (unsigned int i = 0 ; i < instance->listeners.size() ; i++) {
+            if (outside_trace_window(instance->listeners[i], p.get())) {
+                continue;
+            }
             instance->listeners[i]->on_yield(p);
         }
     }
@@ -1150,6 +1286,158 @@ void sample_value(const std::string &name, double value, bool threaded)
     if (_notify_listeners) {
         //read_lock_type l(instance->listener_mutex);
         for (unsigned int i = 0 ; i < instance->listeners.size() ; i++) {
+            if (outside_trace_window(instance->listeners[i])) {
+                continue;
+            }
+            instance->listeners[i]->on_sample_value(data);
+        }
+    }
+}
+
+/* Samples taken through counter handles are aggregated by each thread,
+ * and handed to the profiler_listener in batches. */
+struct counter_aggregate {
+    task_identifier * id;
+    double count;
+    double sum;
+    double sum_squares;
+    double minimum;
+    double maximum;
+};
+
+class counter_buffer {
+public:
+    /* Only contended when another thread flushes all buffers at dump time. */
+    std::mutex lock;
+    std::vector<counter_aggregate> counters;
+};
+
+class counter_registry {
+public:
+    std::mutex lock;
+    std::vector<task_identifier*> ids;
+    std::unordered_map<std::string, apex_counter_handle> handles;
+    std::vector<counter_buffer*> buffers;
+};
+
+/* Never freed - threads can still be sampling after static destruction. */
+static counter_registry& counters(void) {
+    static counter_registry * registry = new counter_registry();
+    return *registry;
+}
+
+static APEX_NATIVE_TLS counter_buffer * _counter_buffer = nullptr;
+
+static counter_buffer& my_counter_buffer(void) {
+    if (_counter_buffer == nullptr) {
+        _counter_buffer = new counter_buffer();
+        counter_registry& registry = counters();
+        std::unique_lock<std::mutex> l(registry.lock);
+        registry.buffers.push_back(_counter_buffer);
+    }
+    return *_counter_buffer;
+}
+
+/* Make room for every counter registered so far.  Only the owning thread
+ * grows its buffer, and the registry lock is always taken before a
+ * buffer lock. */
+static bool grow_counter_buffer(counter_buffer& buffer,
+    apex_counter_handle handle) {
+    std::vector<counter_aggregate> added;
+    {
+        counter_registry& registry = counters();
+        std::unique_lock<std::mutex> l(registry.lock);
+        if (handle >= registry.ids.size()) { return false; }
+        for (size_t i = buffer.counters.size() ; i < registry.ids.size() ; i++) {
+            added.push_back({registry.ids[i], 0.0, 0.0, 0.0, 0.0, 0.0});
+        }
+    }
+    std::unique_lock<std::mutex> l(buffer.lock);
+    buffer.counters.insert(buffer.counters.end(), added.begin(), added.end());
+    return true;
+}
+
+static void flush_counter(counter_aggregate& c, profiler_listener * listener) {
+    if (c.count == 0.0) { return; }
+    listener->on_sample_aggregate(c.id, c.count, c.sum, c.sum_squares,
+        c.minimum, c.maximum);
+    c.count = 0.0;
+    c.sum = 0.0;
+    c.sum_squares = 0.0;
+}
+
+/* Hand the partial aggregates from every thread to the profiler. */
+static void flush_counters(apex * instance) {
+    counter_registry& registry = counters();
+    std::unique_lock<std::mutex> l(registry.lock);
+    for (auto buffer : registry.buffers) {
+        std::unique_lock<std::mutex> bl(buffer->lock);
+        for (auto& c : buffer->counters) {
+            flush_counter(c, instance->the_profiler_listener);
+        }
+    }
+}
+
+apex_counter_handle register_counter(const std::string &name)
+{
+    in_apex prevent_deadlocks;
+    task_identifier * id = task_identifier::get_task_id(name);
+    counter_registry& registry = counters();
+    std::unique_lock<std::mutex> l(registry.lock);
+    auto it = registry.handles.find(name);
+    if (it != registry.handles.end()) {
+        return it->second;
+    }
+    apex_counter_handle handle = (apex_counter_handle)(registry.ids.size());
+    registry.ids.push_back(id);
+    registry.handles[name] = handle;
+    return handle;
+}
+
+void sample_value(apex_counter_handle handle, double value)
+{
+    in_apex prevent_deadlocks;
+    // same checks as sample_value(name, value) - see above
+    if (_exited || _measurement_stopped) return;
+    if (apex_options::disable() == true) { return; }
+    if (apex_options::suspend() == true) { return; }
+    if (!_notify_listeners) { return; }
+    apex* instance = apex::instance(); // get the Apex static instance
+    if (!instance) return; // protect against calls after finalization
+    counter_buffer& buffer = my_counter_buffer();
+    // only this thread resizes the buffer, so no lock needed to check
+    if (handle >= buffer.counters.size() &&
+        !grow_counter_buffer(buffer, handle)) {
+        return; // not a registered counter
+    }
+    task_identifier * id;
+    {
+        std::unique_lock<std::mutex> l(buffer.lock);
+        counter_aggregate& c = buffer.counters[handle];
+        id = c.id;
+        if (c.count == 0.0) {
+            c.minimum = value;
+            c.maximum = value;
+        } else {
+            c.minimum = c.minimum > value ? value : c.minimum;
+            c.maximum = c.maximum < value ? value : c.maximum;
+        }
+        c.count += 1.0;
+        c.sum += value;
+        c.sum_squares += value * value;
+        if (c.count >= apex_options::counter_batch_size()) {
+            flush_counter(c, instance->the_profiler_listener);
+        }
+    }
+    /* The profiler_listener is always the first listener, and gets the
+     * aggregates.  Tracing listeners and policies need every sample. */
+    if (instance->listeners.size() > 1) {
+        sample_value_event_data data(thread_instance::get_id(), id, value,
+            false);
+        for (unsigned int i = 1 ; i < instance->listeners.size() ; i++) {
+            if (outside_trace_window(instance->listeners[i])) {
+                continue;
+            }
             instance->listeners[i]->on_sample_value(data);
         }
     }
@@ -1179,6 +1467,7 @@ std::shared_ptr<task_wrapper> new_task(
     task_identifier * id = task_identifier::get_task_id(name);
     std::shared_ptr<task_wrapper>
         tt_ptr(_new_task(id, task_id, parent_task, instance));
+    _mark_task_creation(tt_ptr);
     APEX_UTIL_REF_COUNT_TASK_WRAPPER
     return tt_ptr;
 }
@@ -1199,6 +1488,7 @@ std::shared_ptr<task_wrapper> new_task(
     task_identifier * id = task_identifier::get_task_id(function_address);
     std::shared_ptr<task_wrapper>
         tt_ptr(_new_task(id, task_id, parent_task, instance));
+    _mark_task_creation(tt_ptr);
     return tt_ptr;
 }
 
@@ -1443,6 +1733,7 @@ std::string dump(bool reset) {
 #ifdef APEX_WITH_HIP
     flush_hip_trace();
 #endif
+    flush_counters(instance);
     if (_notify_listeners) {
         dump_event_data data(instance->get_node_id(),
             thread_instance::get_id(), reset);
@@ -1460,6 +1751,32 @@ std::string dump(bool reset) {
     return(std::string(""));
 }
 
+void begin_trace_window(double seconds) {
+    // if APEX is disabled, do nothing.
+    if (apex_options::disable() == true) { return; }
+    uint64_t end = UINT64_MAX;
+    if (seconds > 0.0) {
+        end = profiler::now_ns() + (uint64_t)(seconds * 1.0e9);
+    }
+    // don't cut short a window that is already open for longer
+    std::atomic<uint64_t>& window_end = profiler::trace_window_end();
+    uint64_t current = window_end.load();
+    while (current < end && !window_end.compare_exchange_weak(current, end));
+}
+
+void end_trace_window(void) {
+    // if APEX is disabled, do nothing.
+    if (apex_options::disable() == true) { return; }
+    if (!apex_options::use_trace_windows()) { return; }
+    profiler::trace_window_end().store(0);
+}
+
+bool dump_flight_recorder(void) {
+    // if APEX is disabled, do nothing.
+    if (apex_options::disable() == true) { return false; }
+    return flight_recorder_listener::dump();
+}
+
 // forward declare OMPT runtime shutdown
 #ifdef APEX_WITH_OMPT
 void ompt_force_shutdown(void);
@@ -1647,6 +1964,20 @@ void exit_thread(void)
     // protect against calls after finalization
     if (!instance || _exited) return;
     if (top_level_timer() != nullptr) { stop(top_level_timer()); }
+    // hand over any samples this thread is still holding
+    if (_counter_buffer != nullptr) {
+        counter_registry& registry = counters();
+        std::unique_lock<std::mutex> l(registry.lock);
+        auto& buffers = registry.buffers;
+        buffers.erase(std::remove(buffers.begin(), buffers.end(),
+            _counter_buffer), buffers.end());
+        for (auto& c : _counter_buffer->counters) {
+            flush_counter(c, instance->the_profiler_listener);
+        }
+        l.unlock();
+        delete _counter_buffer;
+        _counter_buffer = nullptr;
+    }
     _exited = true;
     event_data data;
     if (_notify_listeners) {
@@ -1745,6 +2076,26 @@ apex_policy_handle* register_periodic_policy(unsigned long period_microseconds,
     return handle;
 }
 
+apex_policy_handle* register_stop_batch_policy(
+    std::function<int(apex_stop_event const*, size_t)> f)
+{
+    in_apex prevent_deadlocks;
+    // if APEX is disabled, do nothing.
+    if (apex_options::disable() == true) { return nullptr; }
+    int id = -1;
+    policy_handler * handler = apex::instance()->get_policy_handler();
+    if(handler != nullptr)
+    {
+        id = handler->register_stop_batch_policy(f);
+    }
+    apex_policy_handle * handle = new apex_policy_handle();
+    handle->id = id;
+    handle->event_type = APEX_STOP_EVENT;
+    handle->period = 0;
+    apex::instance()->push_policy_handle(handle);
+    return handle;
+}
+
 #ifdef APEX_HAVE_HPX
 int apex::setup_runtime_counter(const std::string & counter_name) {
     bool messaged = false;
@@ -1906,6 +2257,45 @@ apex_profile* get_profile(const task_identifier &task_id) {
     return nullptr;
 }
 
+bool get_profile(apex_function_address action_address, apex_profile &values) {
+    task_identifier id(action_address);
+    return get_profile(id, values);
+}
+
+bool get_profile(const std::string &timer_name, apex_profile &values) {
+    task_identifier id(timer_name);
+    return get_profile(id, values);
+}
+
+bool get_profile(const task_identifier &task_id, apex_profile &values) {
+    in_apex prevent_deadlocks;
+    // if APEX is disabled, do nothing.
+    if (apex_options::disable() == true) { return false; }
+    return apex::__instance()->the_profiler_listener->get_profile(task_id,
+        values);
+}
+
+std::shared_ptr<const profile_set> snapshot_profiles(void) {
+    in_apex prevent_deadlocks;
+    // if APEX is disabled, do nothing.
+    if (apex_options::disable() == true) {
+        return std::make_shared<const profile_set>();
+    }
+    return apex::__instance()->the_profiler_listener->snapshot_profiles();
+}
+
+apex_queue_wait get_queue_wait(const std::string &task_name) {
+    in_apex prevent_deadlocks;
+    task_identifier id(task_name);
+    return queue_wait_stats(id);
+}
+
+apex_queue_wait get_queue_wait(apex_function_address function_address) {
+    in_apex prevent_deadlocks;
+    task_identifier id(function_address);
+    return queue_wait_stats(id);
+}
+
 double current_power_high(void) {
     double power = 0.0;
 #ifdef APEX_HAVE_RCR
@@ -1929,6 +2319,15 @@ std::vector<task_identifier>& get_available_profiles() {
     return apex::__instance()->the_profiler_listener->get_available_profiles();
 }
 
+std::vector<task_identifier> get_available_profiles_copy() {
+    // if APEX is disabled, do nothing.
+    if (apex_options::disable() == true) {
+        return std::vector<task_identifier>();
+    }
+    return apex::__instance()->the_profiler_listener->
+        get_available_profiles_copy();
+}
+
 void print_options() {
     // if APEX is disabled, do nothing.
     if (apex_options::disable() == true) { return; }
@@ -1957,6 +2356,9 @@ void send (uint64_t tag, uint64_t size, uint64_t target) {
         if (_notify_listeners) {
             //read_lock_type l(instance->listener_mutex);
             for (unsigned int i = 0 ; i < instance->listeners.size() ; i++) {
+                if (outside_trace_window(instance->listeners[i])) {
+                    continue;
+                }
                 instance->listeners[i]->on_send(data);
             }
         }
@@ -1987,6 +2389,9 @@ void recv (uint64_t tag, uint64_t size, uint64_t source_rank, uint64_t
         if (_notify_listeners) {
             //read_lock_type l(instance->listener_mutex);
             for (unsigned int i = 0 ; i < instance->listeners.size() ; i++) {
+                if (outside_trace_window(instance->listeners[i])) {
+                    continue;
+                }
                 instance->listeners[i]->on_recv(data);
             }
         }
@@ -2028,6 +2433,18 @@ extern "C" {
         return(strdup(dump(reset).c_str()));
     }
 
+    void apex_begin_trace_window(double seconds) {
+        begin_trace_window(seconds);
+    }
+
+    void apex_end_trace_window(void) {
+        end_trace_window();
+    }
+
+    int apex_dump_flight_recorder(void) {
+        return dump_flight_recorder() ? 1 : 0;
+    }
+
     void apex_finalize(void) {
         finalize();
     }
@@ -2109,6 +2526,15 @@ extern "C" {
         sample_value(tmp, value, threaded);
     }
 
+    apex_counter_handle apex_register_counter(const char * name) {
+        string tmp(name);
+        return register_counter(tmp);
+    }
+
+    void apex_sample_counter(apex_counter_handle handle, double value) {
+        sample_value(handle, value);
+    }
+
     void apex_new_task(apex_profiler_type type, void * identifier,
                        unsigned long long task_id) {
         if (type == APEX_FUNCTION_ADDRESS) {
@@ -2153,6 +2579,14 @@ extern "C" {
         return register_periodic_policy(period, f);
     }
 
+    apex_policy_handle* apex_register_stop_batch_policy(
+        apex_stop_batch_function f) {
+        return register_stop_batch_policy(
+            [f](apex_stop_event const * events, size_t count) {
+                return f(events, (unsigned long)count);
+            });
+    }
+
     void apex_deregister_policy(apex_policy_handle * handle) {
         return deregister_policy(handle);
     }
@@ -2169,6 +2603,16 @@ extern "C" {
         return nullptr;
     }
 
+    apex_queue_wait apex_get_queue_wait(apex_profiler_type type,
+        void * identifier) {
+        APEX_ASSERT(identifier != nullptr);
+        if (type == APEX_FUNCTION_ADDRESS) {
+            return get_queue_wait((apex_function_address)(identifier));
+        }
+        string tmp((const char *)identifier);
+        return get_queue_wait(tmp);
+    }
+
     double apex_current_power_high() {
         return current_power_high();
     }
@@ -75,6 +75,42 @@ APEX_EXPORT int apex_init(const char * thread_name, const uint64_t comm_rank,
  */
 APEX_EXPORT const char * apex_dump(bool reset);
 
+/**
+ \brief Open a trace window.
+
+ With APEX_TRACE_WINDOWS=1, the tracing listeners (APEX_OTF2 and
+ APEX_TRACE_EVENT) only record timers that start while a trace window is
+ open.  Outside of a window, they aren't sent any events at all.  A policy
+ can open a window when something interesting happens, for example when
+ an iteration takes too long.  If a window is already open for longer, it
+ is not shortened.
+ \param seconds How long to keep the window open, 0 until
+                 apex_end_trace_window is called.
+ \sa @ref apex_end_trace_window
+ */
+APEX_EXPORT void apex_begin_trace_window(double seconds);
+
+/**
+ \brief Close the trace window.
+
+ Timers that were started inside the window are still traced when they
+ stop.
+ \sa @ref apex_begin_trace_window
+ */
+APEX_EXPORT void apex_end_trace_window(void);
+
+/**
+ \brief Dump the flight recorder.
+
+ Write the most recent events from every thread to a Chrome trace,
+ apex_flight_recorder.<node>.<n>.json.  This can be called from a
+ policy, for example when a timer takes longer than expected.
+ Requires APEX_FLIGHT_RECORDER=1.
+ \return 1 if a trace was written, 0 otherwise.
+ \sa @ref apex_dump
+ */
+APEX_EXPORT int apex_dump_flight_recorder(void);
+
 /**
  \brief Finalize APEX.
 
@@ -268,6 +304,32 @@ APEX_EXPORT void apex_set_state(apex_thread_state state);
  */
 APEX_EXPORT void apex_sample_value(const char * name, double value);
 
+/**
+ \brief Register a counter for repeated sampling.
+
+ Looks up the counter name once, so that later samples through
+ the returned handle don't have to.  Registering the same name
+ more than once returns the same handle.
+
+ \param name The name of the sampled value
+ \return A handle to pass to apex_sample_counter.
+ */
+APEX_EXPORT apex_counter_handle apex_register_counter(const char * name);
+
+/**
+ \brief Sample a registered counter.
+
+ Like apex_sample_value, but without any string handling or memory
+ allocation.  Each thread aggregates its samples (count, sum, min and
+ max) and hands them to the profiler in batches of
+ APEX_COUNTER_BATCH_SIZE samples, and whenever the profile is dumped.
+
+ \param handle The handle returned by apex_register_counter
+ \param value The sampled value
+ \return No return value.
+ */
+APEX_EXPORT void apex_sample_counter(apex_counter_handle handle, double value);
+
 /**
  \brief Create a new task (dependency).
 
@@ -385,6 +447,21 @@ APEX_EXPORT apex_policy_handle * apex_register_policy(
 APEX_EXPORT apex_policy_handle * apex_register_periodic_policy(
     unsigned long period, apex_policy_function f);
 
+/**
+ \brief Register a policy that gets the timer stops in batches.
+
+ The stops are saved in per-thread buffers, and passed to the function
+ on an APEX thread, at most APEX_POLICY_BATCH_PERIOD microseconds after
+ they happened, so the policy doesn't delay the application threads.
+
+ \param f The function to be called with each batch of stops.
+ \return A handle to the policy, to be stored if the policy is to be
+         un-registered later.
+ \sa @ref apex_deregister_policy, @ref apex_register_policy
+ */
+APEX_EXPORT apex_policy_handle * apex_register_stop_batch_policy(
+    apex_stop_batch_function f);
+
 /**
  \brief Deregister a policy with APEX.
 
@@ -413,6 +490,23 @@ APEX_EXPORT void apex_deregister_policy(apex_policy_handle * handle);
 APEX_EXPORT apex_profile * apex_get_profile(apex_profiler_type type,
     void * identifier);
 
+/**
+ \brief Get the queue wait statistics for the specified task type.
+
+ This function will return how long tasks of the specified type waited
+ between apex_new_task and their first start, in nanoseconds.  The
+ statistics are only collected when APEX_QUEUE_WAIT is set.
+
+ \param type The type of the address to be returned. This can be one of the @ref
+             apex_profiler_type values.
+ \param identifier The function address of the task function, or a "const
+             char *" pointer to the name of the task.
+ \return The queue wait statistics, all zeros if no task of that type has
+         been started.
+ */
+APEX_EXPORT apex_queue_wait apex_get_queue_wait(apex_profiler_type type,
+    void * identifier);
+
 /**
  \brief Get the current power reading
 
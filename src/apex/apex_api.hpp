@@ -93,6 +93,42 @@ APEX_EXPORT uint64_t init(const char * thread_name,
  */
 APEX_EXPORT std::string dump(bool reset);
 
+/**
+ \brief Open a trace window.
+
+ With APEX_TRACE_WINDOWS=1, the tracing listeners (APEX_OTF2 and
+ APEX_TRACE_EVENT) only record timers that start while a trace window is
+ open.  Outside of a window, they aren't sent any events at all.  A policy
+ can open a window when something interesting happens, for example when
+ an iteration takes too long.  If a window is already open for longer, it
+ is not shortened.
+ \param seconds How long to keep the window open, 0 until
+                 end_trace_window is called.
+ \sa @ref apex::end_trace_window
+ */
+APEX_EXPORT void begin_trace_window(double seconds = 0.0);
+
+/**
+ \brief Close the trace window.
+
+ Timers that were started inside the window are still traced when they
+ stop.
+ \sa @ref apex::begin_trace_window
+ */
+APEX_EXPORT void end_trace_window(void);
+
+/**
+ \brief Dump the flight recorder.
+
+ Write the most recent events from every thread to a Chrome trace,
+ apex_flight_recorder.<node>.<n>.json.  This can be called from a
+ policy, for example when a timer takes longer than expected.
+ Requires APEX_FLIGHT_RECORDER=1.
+ \return true if a trace was written.
+ \sa @ref apex::dump
+ */
+APEX_EXPORT bool dump_flight_recorder(void);
+
 /**
  \brief Finalize APEX.
 
@@ -154,6 +190,21 @@ APEX_EXPORT profiler * start(const std::string &timer_name);
  */
 APEX_EXPORT profiler * start(const apex_function_address function_address);
 
+/**
+ \brief Start a timer.
+
+ Like start(timer_name), for a timer whose task_identifier was looked
+ up once with task_identifier::get_task_id(), so that starting it again
+ doesn't build or hash its name.  Tools that see the same events over
+ and over (like the Kokkos hooks) should keep the task_identifier.
+
+ \param task_id The task_identifier of the timer.
+ \return The handle for the timer object in APEX, to be passed in to
+         the matching apex::stop() call.
+ \sa @ref apex::stop, @ref apex::yield, @ref apex::resume
+ */
+APEX_EXPORT profiler * start(task_identifier * task_id);
+
 /**
  \brief Start a timer.
 
@@ -337,6 +388,32 @@ APEX_EXPORT void set_state(apex_thread_state state);
  */
 APEX_EXPORT void sample_value(const std::string &name, double value, bool threaded = false);
 
+/**
+ \brief Register a counter for repeated sampling.
+
+ Looks up the counter name once, so that later samples through
+ the returned handle don't have to.  Registering the same name
+ more than once returns the same handle.
+
+ \param name The name of the sampled value
+ \return A handle to pass to apex::sample_value.
+ */
+APEX_EXPORT apex_counter_handle register_counter(const std::string &name);
+
+/**
+ \brief Sample a registered counter.
+
+ Like sample_value(name, value), but without any string handling or
+ memory allocation.  Each thread aggregates its samples (count, sum,
+ min and max) and hands them to the profiler in batches of
+ APEX_COUNTER_BATCH_SIZE samples, and whenever the profile is dumped.
+
+ \param handle The handle returned by register_counter
+ \param value The sampled value
+ \return No return value.
+ */
+APEX_EXPORT void sample_value(apex_counter_handle handle, double value);
+
 /**
  \brief Create a new task (dependency).
 
@@ -512,6 +589,24 @@ APEX_EXPORT std::set<apex_policy_handle*> register_policy(
 APEX_EXPORT apex_policy_handle* register_periodic_policy(
     unsigned long period, std::function<int(apex_context const&)> f);
 
+/**
+ \brief Register a policy that gets the timer stops in batches.
+
+ A policy registered for APEX_STOP_EVENT runs on the thread that stopped
+ the timer, which delays that thread.  Instead, a stop batch policy runs
+ on an APEX thread: the stops are saved in per-thread buffers, and passed
+ to the policy in batches, at most APEX_POLICY_BATCH_PERIOD microseconds
+ after they happened (and once more at finalization).  Each stop includes
+ the duration, the task GUID and the thread.
+
+ \param f The function to be called with each batch of stops.
+ \return A handle to the policy, to be stored if the policy is to be
+         un-registered later.
+ \sa @ref apex::deregister_policy, @ref apex::register_policy
+ */
+APEX_EXPORT apex_policy_handle* register_stop_batch_policy(
+    std::function<int(apex_stop_event const*, size_t)> f);
+
 /**
  \brief Periodically sample a runtime counter.
 
@@ -588,6 +683,99 @@ APEX_EXPORT apex_profile* get_profile(const std::string &timer_name);
  */
 APEX_EXPORT apex_profile* get_profile(const task_identifier &task_id);
 
+/**
+ \brief Get a consistent copy of the profile for the specified function address.
+
+ Unlike the profile returned by @ref apex::get_profile, which is updated
+ while it is read, the copy never mixes values from two different updates,
+ so the calls and the accumulated time always agree.  Reading the copy
+ never blocks the threads that update the profile.
+
+ \param function_address The address of the function.
+ \param values The copy of the profile.
+ \return True if the profile exists, false otherwise.
+ */
+APEX_EXPORT bool get_profile(apex_function_address function_address,
+    apex_profile &values);
+
+/**
+ \brief Get a consistent copy of the profile for the specified timer or counter.
+
+ \param timer_name The name of the function or sampled value
+ \param values The copy of the profile.
+ \return True if the profile exists, false otherwise.
+ \sa @ref apex::get_profile(apex_function_address, apex_profile&)
+ */
+APEX_EXPORT bool get_profile(const std::string &timer_name,
+    apex_profile &values);
+
+/**
+ \brief Get a consistent copy of the profile for the specified task_identifier.
+
+ \param task_id The task_identifier of the timer/counter
+ \param values The copy of the profile.
+ \return True if the profile exists, false otherwise.
+ \sa @ref apex::get_profile(apex_function_address, apex_profile&)
+ */
+APEX_EXPORT bool get_profile(const task_identifier &task_id,
+    apex_profile &values);
+
+/**
+ \brief A copy of all the profiles, see @ref apex::snapshot_profiles.
+ */
+class profile_set {
+public:
+    /** The total number of updates to the profiles when the copy was made.
+        It only changes when a profile is updated, reset or created. */
+    uint64_t version;
+    /** The timers and counters, in no particular order */
+    std::vector<task_identifier> ids;
+    /** The consistent copies of their profiles, in the same order */
+    std::vector<apex_profile> profiles;
+    profile_set(void) : version(0) {}
+    size_t size(void) const { return ids.size(); }
+};
+
+/**
+ \brief Get a copy of all the profiles at once.
+
+ This function will return a consistent copy of every profile, taken in
+ one pass.  The set is never modified after it is returned, so it can be
+ kept and compared with a later set, for example to compute the change
+ of every profile over a period.  If no profile has changed since the
+ last call, the same set is returned again, so a periodic policy can call
+ this function often.
+
+ \return The profiles, and their version.
+ */
+APEX_EXPORT std::shared_ptr<const profile_set> snapshot_profiles(void);
+
+/**
+ \brief Get the queue wait statistics for the specified task type.
+
+ This function will return the queue wait statistics for the specified task
+ type: how long tasks created with apex::new_task waited before they were
+ started, in nanoseconds.  A policy can use this to throttle task creation
+ when the wait grows.  The statistics are only collected when
+ APEX_QUEUE_WAIT is set.
+
+ \param task_name The name of the task type
+ \return The queue wait statistics, all zeros if no task of that type has
+         been started.
+ */
+APEX_EXPORT apex_queue_wait get_queue_wait(const std::string &task_name);
+
+/**
+ \brief Get the queue wait statistics for the specified function address.
+
+ \param function_address The address of the task function
+ \return The queue wait statistics, all zeros if no task of that type has
+         been started.
+ \sa @ref apex::get_queue_wait
+ */
+APEX_EXPORT apex_queue_wait get_queue_wait(
+    apex_function_address function_address);
+
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 
 /**
@@ -602,6 +790,18 @@ APEX_EXPORT apex_profile* get_profile(const task_identifier &task_id);
  */
 APEX_EXPORT std::vector<task_identifier>& get_available_profiles();
 
+/**
+ \brief Get a copy of the set of profiles that are identified by name
+ \internal
+
+ Like get_available_profiles(), but the vector belongs to the caller, so
+ it doesn't change while it is used, even when other threads ask for the
+ profiles too.
+
+ \return A vector of task_identifier objects
+ */
+APEX_EXPORT std::vector<task_identifier> get_available_profiles_copy();
+
 /**
  \brief Get the current power reading
 
@@ -11,6 +11,9 @@
 #include <string.h>
 #include <vector>
 #include <set>
+#include <map>
+#include <algorithm>
+#include <functional>
 
 #include "apex_bfd.h"
 #include "apex.hpp"
@@ -790,6 +793,188 @@ bool Apex_bfd_resolveBfdInfo(apex_bfd_handle_t handle,
   return false;
 }
 
+// Fill in the fields of an address that could not be resolved, the same
+// way Apex_bfd_resolveBfdInfo does for a single address.
+static void Apex_bfd_internal_finishUnresolved(ApexBfdUnit * unit,
+    int matchingIdx, unsigned long probeAddr, ApexBfdInfo & info)
+{
+  // we might have partial information, like filename and line number.
+  if ((info.funcname == nullptr) && (info.filename != nullptr) && (info.lineno > 0)) {
+    info.probeAddr = probeAddr;
+    info.funcname = (char*)malloc(32);
+    sprintf(const_cast<char*>(info.funcname), "anonymous");
+    return;
+  }
+  if (info.funcname == nullptr) {
+    info.funcname = (char*)malloc(128);
+    sprintf(const_cast<char*>(info.funcname), "addr=<%lx>", probeAddr);
+  }
+  if (info.filename == nullptr) {
+    if (matchingIdx != -1) {
+      info.filename = unit->addressMaps[matchingIdx]->name;
+    } else {
+      info.filename = unit->executablePath;
+    }
+  }
+  info.probeAddr = probeAddr;
+  info.lineno = 0;
+}
+
+// Resolve all of the addresses that fall in one module.  The indices
+// refer to sorted addresses, so after the section search the leftovers
+// can be matched against an address-sorted copy of the symbol table in
+// a single pass, rather than one full symbol table scan per address.
+// Any address that is still unresolved is returned in 'misses'.
+static void Apex_bfd_internal_resolveModuleBatch(ApexBfdUnit * unit,
+    int matchingIdx, unsigned long const * probeAddrs, ApexBfdInfo * infos,
+    vector<size_t> const & members, vector<size_t> & misses)
+{
+  bool loaded = (matchingIdx != -1) ?
+    Apex_bfd_internal_loadSymTab(unit, matchingIdx) :
+    Apex_bfd_internal_loadExecSymTab(unit);
+  if (!loaded) {
+    for (size_t i : members) {
+      infos[i].secure(probeAddrs[i]);
+    }
+    return;
+  }
+  ApexBfdModule * module = Apex_bfd_internal_getModuleFromIdx(unit, matchingIdx);
+
+  vector<size_t> pending;
+  for (size_t i : members) {
+    ApexBfdInfo & info = infos[i];
+    unsigned long addr0 = probeAddrs[i];
+    unsigned long addr1 = (matchingIdx != -1) ?
+      (addr0 - unit->addressMaps[matchingIdx]->start) : 0;
+    info.lineno = 0;
+    info.probeAddr = apex_getProbeAddr(module->bfdImage, addr0);
+    apex_LocateAddressData data(module, info);
+    bfd_map_over_sections(module->bfdImage,
+      Apex_bfd_internal_locateAddress, &data);
+    if (!data.found && addr1 && addr0 != addr1) {
+      info.probeAddr = apex_getProbeAddr(module->bfdImage, addr1);
+      bfd_map_over_sections(module->bfdImage,
+        Apex_bfd_internal_locateAddress, &data);
+    }
+    if (info.funcname && !info.filename) {
+      if (matchingIdx != -1) {
+        info.filename = unit->addressMaps[matchingIdx]->name;
+      } else {
+        info.filename = unit->executablePath;
+      }
+    }
+    if (data.found && info.funcname) {
+      info.demangled = Apex_bfd_internal_tryDemangle(module->bfdImage,
+          info.funcname);
+      info.probeAddr = addr0;
+      continue;
+    }
+    pending.push_back(i);
+  }
+  if (pending.empty()) { return; }
+
+  // Sort the symbol table once, then walk it alongside the addresses.
+  vector<pair<unsigned long, char const *> > symbols;
+  symbols.reserve(module->nr_all_syms);
+  for (asymbol ** s = module->syms; *s; s++) {
+    asymbol const & asym = **s;
+    if (asym.name && asym.section->size) {
+      symbols.push_back(make_pair(
+        (unsigned long)(asym.section->vma + asym.value), asym.name));
+    }
+  }
+  std::stable_sort(symbols.begin(), symbols.end(),
+    [](pair<unsigned long, char const *> const & a,
+       pair<unsigned long, char const *> const & b) {
+      return a.first < b.first;
+    });
+  size_t s = 0;
+  for (size_t i : pending) {
+    unsigned long addr = probeAddrs[i];
+    while (s < symbols.size() && symbols[s].first < addr) { s++; }
+    if (s < symbols.size() && symbols[s].first == addr) {
+      char const * name = symbols[s].second;
+      if (name[0] == '.') {
+        char const * mark = strchr(const_cast<char*>(name), '$');
+        if (mark) name = mark + 1;
+      }
+      infos[i].demangled = Apex_bfd_internal_tryDemangle(module->bfdImage, name);
+      infos[i].probeAddr = addr;
+    } else {
+      misses.push_back(i);
+    }
+  }
+}
+
+void Apex_bfd_resolveBfdInfoBatch(apex_bfd_handle_t handle,
+    unsigned long const * probeAddrs, ApexBfdInfo * infos, size_t count)
+{
+  if (!Apex_bfd_checkHandle(handle)) {
+    for (size_t i = 0 ; i < count ; i++) {
+      infos[i].secure(probeAddrs[i]);
+    }
+    return;
+  }
+  ApexBfdUnit * unit = apex_ThebfdUnits()[handle];
+  if (unit == nullptr || count == 0) {
+      return;
+  }
+  if (unit->apex_objopen_counter != get_apex_objopen_counter()) {
+    Apex_bfd_updateAddressMaps(handle);
+  }
+
+  // Group the addresses by module.  Because they are sorted, consecutive
+  // addresses almost always fall in the same map as the previous one.
+  std::map<int, vector<size_t> > groups;
+  int lastIdx = -1;
+  for (size_t i = 0 ; i < count ; i++) {
+    unsigned long addr = probeAddrs[i];
+    int idx = lastIdx;
+    if (idx == -1 || addr < unit->addressMaps[idx]->start ||
+        addr > unit->addressMaps[idx]->end) {
+      idx = Apex_bfd_internal_getModuleIndex(unit, addr);
+    }
+    groups[idx].push_back(i);
+    lastIdx = idx;
+  }
+
+  // Search each module once, for all of its addresses.  The modules are
+  // searched one after another: libbfd keeps global state (its cache of
+  // open files, and the error state) that isn't thread safe.
+  vector<vector<size_t> > misses(groups.size());
+  size_t g = 0;
+  for (auto & group : groups) {
+    Apex_bfd_internal_resolveModuleBatch(unit, group.first, probeAddrs,
+      infos, group.second, misses[g++]);
+  }
+
+  // Whatever is left over gets one more try in the executable.
+  g = 0;
+  for (auto & group : groups) {
+    int matchingIdx = group.first;
+    for (size_t i : misses[g++]) {
+      ApexBfdInfo & info = infos[i];
+      if (matchingIdx != -1 && Apex_bfd_internal_loadExecSymTab(unit)) {
+        ApexBfdModule * module = unit->modules[matchingIdx];
+        apex_LocateAddressData data(unit->executableModule, info);
+        info.probeAddr = apex_getProbeAddr(module->bfdImage, probeAddrs[i]);
+        bfd_map_over_sections(unit->executableModule->bfdImage,
+          Apex_bfd_internal_locateAddress, &data);
+        if (data.found && info.funcname) {
+          if (!info.filename) {
+            info.filename = unit->addressMaps[matchingIdx]->name;
+          }
+          info.demangled = Apex_bfd_internal_tryDemangle(module->bfdImage,
+              info.funcname);
+          info.probeAddr = probeAddrs[i];
+          continue;
+        }
+      }
+      Apex_bfd_internal_finishUnresolved(unit, matchingIdx, probeAddrs[i], info);
+    }
+  }
+}
+
 void Apex_bfd_internal_iterateOverSymtab(ApexBfdModule * module,
     ApexBfdIterFn fn, unsigned long offset)
 {
@@ -115,6 +115,12 @@ void Apex_bfd_updateAddressMaps(apex_bfd_handle_t handle);
 bool Apex_bfd_resolveBfdInfo(apex_bfd_handle_t handle,
         unsigned long probeAddr, ApexBfdInfo & info);
 
+// Batched forward lookup.  The addresses (which must be sorted) are
+// grouped by module, each module is searched in one pass, and the modules
+// are searched in parallel.  The infos array must have count entries.
+void Apex_bfd_resolveBfdInfoBatch(apex_bfd_handle_t handle,
+        unsigned long const * probeAddrs, ApexBfdInfo * infos, size_t count);
+
 // Fast scan of the executable symbol table.
 int Apex_bfd_processBfdExecInfo(apex_bfd_handle_t handle, ApexBfdIterFn fn);
 
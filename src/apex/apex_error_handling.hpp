@@ -19,6 +19,7 @@
 #include <string.h>
 #include <regex>
 #include "utils.hpp"
+#include "flight_recorder_listener.hpp"
 
 static std::mutex output_mutex;
 
@@ -78,6 +79,8 @@ static void apex_custom_signal_handler(int sig) {
   std::cerr << std::endl;
   std::cerr << std::endl;
   fflush(stderr);
+  // keep the events leading up to the crash, if the flight recorder is on
+  apex::flight_recorder_listener::dump_after_fatal_signal();
   //apex::finalize();
   _exit(-1);
 }
@@ -22,11 +22,14 @@
 #include <unordered_map>
 #include <mutex>
 #include <stack>
+#include <deque>
 #include <vector>
 #include <set>
 #include <unordered_map>
 #include <stdlib.h>
+#include <string.h>
 #include "apex.hpp"
+#include "task_identifier.hpp"
 #include "Kokkos_Profiling_C_Interface.h"
 
 /*
@@ -40,6 +43,130 @@ static std::stack<apex::profiler*>& timer_stack() {
     static APEX_NATIVE_TLS std::stack<apex::profiler*> thestack;
     return thestack;
 }
+
+/* The kinds of Kokkos events that have a timer or a counter */
+enum class kokkos_event : uint32_t {
+    PARALLEL_FOR,
+    PARALLEL_REDUCE,
+    PARALLEL_SCAN,
+    REGION,
+    ALLOCATE,
+    DEEP_COPY
+};
+
+class kokkos_timer {
+public:
+    apex::task_identifier * id;
+    apex_counter_handle bytes;
+};
+
+/* Kokkos applications launch the same kernels over and over, so every
+ * thread keeps the timer and the counter of each kernel, region, copy and
+ * allocation it has seen, and a repeated event doesn't build its name or
+ * look it up in APEX again.  Kokkos usually passes the same name pointer
+ * for the same kernel, so that is tried first, but it doesn't promise to:
+ * otherwise the event is found by a hash of the names.  Either way the
+ * names are compared, to be sure. */
+class kokkos_timers {
+private:
+    class entry {
+    public:
+        kokkos_event kind;
+        uint32_t devid;
+        std::vector<std::string> names;
+        kokkos_timer timer;
+    };
+    std::deque<entry> _entries; // never moved, the maps point into it
+    std::unordered_map<uint64_t, std::vector<entry*> > _by_hash;
+    /* the last event seen with this (last) name pointer.  Names that are
+     * built for each call would add a pointer every time, so it is
+     * emptied when it gets this big. */
+    std::unordered_map<const char*, entry*> _by_pointer;
+    static const size_t max_pointers = 4096;
+    static bool same(const entry& e, kokkos_event kind, uint32_t devid,
+        const char * const * names, size_t count) {
+        if (e.kind != kind || e.devid != devid || e.names.size() != count) {
+            return false;
+        }
+        for (size_t i = 0 ; i < count ; i++) {
+            if (strcmp(e.names[i].c_str(), names[i]) != 0) { return false; }
+        }
+        return true;
+    }
+    /* FNV-1a, of the kind, the device and the names */
+    static uint64_t hash(kokkos_event kind, uint32_t devid,
+        const char * const * names, size_t count) {
+        uint64_t h = 14695981039346656037ull;
+        h = (h ^ (uint64_t)kind) * 1099511628211ull;
+        h = (h ^ devid) * 1099511628211ull;
+        for (size_t i = 0 ; i < count ; i++) {
+            for (const char * c = names[i] ; *c != 0 ; c++) {
+                h = (h ^ (uint8_t)(*c)) * 1099511628211ull;
+            }
+            // so that "ab","c" differs from "a","bc"
+            h = (h ^ 0xff) * 1099511628211ull;
+        }
+        return h;
+    }
+public:
+    /* The timer of an event.  Only a new event calls make(timer_name,
+     * counter_name) to build its names; an empty name has no timer (or
+     * no counter). */
+    template <typename F>
+    kokkos_timer& get(kokkos_event kind, uint32_t devid,
+        const char * const * names, size_t count, F make) {
+        auto found = _by_pointer.find(names[count-1]);
+        if (found != _by_pointer.end() &&
+            same(*(found->second), kind, devid, names, count)) {
+            return found->second->timer;
+        }
+        if (found == _by_pointer.end() &&
+            _by_pointer.size() >= max_pointers) {
+            _by_pointer.clear();
+        }
+        entry*& last = _by_pointer[names[count-1]];
+        auto& bucket = _by_hash[hash(kind, devid, names, count)];
+        for (auto e : bucket) {
+            if (same(*e, kind, devid, names, count)) {
+                last = e;
+                return e->timer;
+            }
+        }
+        std::string timer_name;
+        std::string counter_name;
+        make(timer_name, counter_name);
+        entry e;
+        e.kind = kind;
+        e.devid = devid;
+        e.names.assign(names, names + count);
+        e.timer.id = timer_name.empty() ? nullptr :
+            apex::task_identifier::get_task_id(timer_name);
+        e.timer.bytes = counter_name.empty() ? 0 :
+            apex::register_counter(counter_name);
+        _entries.push_back(std::move(e));
+        last = &(_entries.back());
+        bucket.push_back(last);
+        return last->timer;
+    }
+};
+
+static kokkos_timers& timers() {
+    static APEX_NATIVE_TLS kokkos_timers thetimers;
+    return thetimers;
+}
+
+/* The timer of a parallel_for, parallel_reduce or parallel_scan */
+static apex::task_identifier * kernel_timer(kokkos_event kind,
+    const char * label, const char* name, uint32_t devid) {
+    const char * names[] = {name};
+    return timers().get(kind, devid, names, 1,
+        [&](std::string& timer_name, std::string&) {
+            std::stringstream ss;
+            ss << "Kokkos " << label << ", Dev: " << devid << ", " << name;
+            timer_name = ss.str();
+        }).id;
+}
+
 static std::mutex section_mtx;
 static std::vector<std::string>& sections() {
     static std::vector<std::string> thevector;
@@ -95,36 +222,30 @@ void kokkosp_request_tool_settings(int num_actions,
  */
 void kokkosp_begin_parallel_for(const char* name,
     uint32_t devid, uint64_t* kernid) {
-    std::stringstream ss;
-    ss << "Kokkos for, Dev: " << devid << ", " << name;
-    std::string tmp{ss.str()};
     // Start a new profiler, with no known parent
     // (current timer on stack, if exists)
-    auto p = apex::start(tmp);
+    auto p = apex::start(kernel_timer(kokkos_event::PARALLEL_FOR, "for",
+        name, devid));
     // save the task wrapper in the kernid
     *(kernid) = (uint64_t)p;
 }
 
 void kokkosp_begin_parallel_reduce(const char* name,
     uint32_t devid, uint64_t* kernid) {
-    std::stringstream ss;
-    ss << "Kokkos reduce, Dev: " << devid << ", " << name;
-    std::string tmp{ss.str()};
     // Start a new profiler, with no known parent
     // (current timer on stack, if exists)
-    auto p = apex::start(tmp);
+    auto p = apex::start(kernel_timer(kokkos_event::PARALLEL_REDUCE, "reduce",
+        name, devid));
     // save the task wrapper in the kernid
     *(kernid) = (uint64_t)p;
 }
 
 void kokkosp_begin_parallel_scan(const char* name,
     uint32_t devid, uint64_t* kernid) {
-    std::stringstream ss;
-    ss << "Kokkos scan, Dev: " << devid << ", " << name;
-    std::string tmp{ss.str()};
     // Start a new profiler, with no known parent
     // (current timer on stack, if exists)
-    auto p = apex::start(tmp);
+    auto p = apex::start(kernel_timer(kokkos_event::PARALLEL_SCAN, "scan",
+        name, devid));
     // save the task wrapper in the kernid
     *(kernid) = (uint64_t)p;
 }
@@ -157,12 +278,16 @@ void kokkosp_end_parallel_scan(uint64_t kernid) {
  * user.
  */
 void kokkosp_push_profile_region(const char* name) {
-    std::stringstream ss;
-    ss << "Kokkos region, " << name;
-    std::string tmp{ss.str()};
+    const char * names[] = {name};
+    auto& timer = timers().get(kokkos_event::REGION, 0, names, 1,
+        [&](std::string& timer_name, std::string&) {
+            std::stringstream ss;
+            ss << "Kokkos region, " << name;
+            timer_name = ss.str();
+        });
     // Start a new profiler, with no known parent
     // (current timer on stack, if exists)
-    auto p = apex::start(tmp);
+    auto p = apex::start(timer.id);
     timer_stack().push(p);
 }
 
@@ -187,19 +312,23 @@ void kokkosp_pop_profile_region() {
 void kokkosp_allocate_data(SpaceHandle_t handle, const char* name,
     void* ptr, uint64_t size) {
     APEX_UNUSED(ptr);
-    std::stringstream ss;
-    ss << "Kokkos " << handle.name << " data, " << name;
-    /*
-    std::string tmp{ss.str()};
-    auto p = apex::start(tmp);
-    memory_mtx.lock();
-    memory_map().insert(std::pair<void*,apex::profiler*>(ptr, p));
-    memory_mtx.unlock();
-    */
-    ss << ": Bytes";
-    std::string tmp2{ss.str()};
+    const char * names[] = {handle.name, name};
+    auto& timer = timers().get(kokkos_event::ALLOCATE, 0, names, 2,
+        [&](std::string&, std::string& counter_name) {
+            std::stringstream ss;
+            ss << "Kokkos " << handle.name << " data, " << name;
+            /*
+            std::string tmp{ss.str()};
+            auto p = apex::start(tmp);
+            memory_mtx.lock();
+            memory_map().insert(std::pair<void*,apex::profiler*>(ptr, p));
+            memory_mtx.unlock();
+            */
+            ss << ": Bytes";
+            counter_name = ss.str();
+        });
     double bytes = (double)(size);
-    apex::sample_value(tmp2, bytes);
+    apex::sample_value(timer.bytes, bytes);
 }
 
 /* This function will be called whenever a shared allocation is destroyed. The
@@ -234,16 +363,21 @@ void kokkosp_begin_deep_copy(
     SpaceHandle dst_handle, const char* dst_name, const void* dst_ptr,
     SpaceHandle src_handle, const char* src_name, const void* src_ptr,
     uint64_t size) {
-    std::stringstream ss;
-    ss << "Kokkos deep copy: " << src_handle.name << " " << src_name
-       << " -> " << dst_handle.name << " " << dst_name;
-    std::string tmp{ss.str()};
-    auto p = apex::start(tmp);
+    const char * names[] = {src_handle.name, src_name, dst_handle.name,
+        dst_name};
+    auto& timer = timers().get(kokkos_event::DEEP_COPY, 0, names, 4,
+        [&](std::string& timer_name, std::string& counter_name) {
+            std::stringstream ss;
+            ss << "Kokkos deep copy: " << src_handle.name << " " << src_name
+               << " -> " << dst_handle.name << " " << dst_name;
+            timer_name = ss.str();
+            ss << ": Bytes";
+            counter_name = ss.str();
+        });
+    auto p = apex::start(timer.id);
     timer_stack().push(p);
-    ss << ": Bytes";
-    std::string tmp2{ss.str()};
     double bytes = (double)(size);
-    apex::sample_value(tmp2, bytes);
+    apex::sample_value(timer.bytes, bytes);
     APEX_UNUSED(src_ptr);
     APEX_UNUSED(dst_ptr);
 }
@@ -30,6 +30,8 @@
 #include "Kokkos_Profiling_C_Interface.h"
 #include "apex_api.hpp"
 #include "apex_policies.hpp"
+#include "context_model.hpp"
+#include "tuning_cache.hpp"
 
 std::string pVT(Kokkos_Tools_VariableInfo_ValueType t) {
     if (t == kokkos_value_double) {
@@ -145,22 +147,23 @@ class KokkosSession {
 private:
 // EXHAUSTIVE, RANDOM, NELDER_MEAD, PARALLEL_RANK_ORDER
     KokkosSession() :
-        window(5),
+        window(1),
         strategy(apex_ah_tuning_strategy::SIMULATED_ANNEALING),
         //strategy(apex_ah_tuning_strategy::NELDER_MEAD),
         verbose(false),
         use_history(false),
+        appendCache(false),
         running(false){
             verbose = apex::apex_options::use_kokkos_verbose();
             // don't do this until the object is constructed!
     }
 public:
-    ~KokkosSession() {
-        writeCache();
-    }
     static KokkosSession& getSession();
     KokkosSession(const KokkosSession&) =delete;
     KokkosSession& operator=(const KokkosSession&) =delete;
+    /* calls per sample of the metric.  Each call is a sample, and the
+     * adaptive sampling of the request decides how many calls each
+     * configuration gets. */
     int window;
     apex_ah_tuning_strategy strategy;
     std::unordered_map<std::string, std::shared_ptr<apex_tuning_request>>
@@ -168,6 +171,8 @@ public:
     std::unordered_map<std::string, std::vector<int>> var_ids;
     bool verbose;
     bool use_history;
+    /* converged contexts are appended to the (binary) cache */
+    bool appendCache;
     bool running;
     std::map<size_t, Variable*> inputs;
     std::map<size_t, Variable*> outputs;
@@ -176,21 +181,29 @@ public:
     std::unordered_map<size_t, std::string> active_requests;
     std::set<size_t> used_history;
     std::unordered_map<size_t, uint64_t> context_starts;
-    void writeCache();
     bool checkForCache();
     void readCache();
+    bool readBinaryCache();
     void saveInputVar(size_t id, Variable * var);
     void saveOutputVar(size_t id, Variable * var);
+    void saveVar(Variable * var);
+    void saveTunings(const std::string& name, const size_t vars,
+        const Kokkos_Tools_VariableValue* values);
     void parseVariableCache(std::ifstream& results);
     void parseContextCache(std::ifstream& results);
-    std::stringstream cachedResults;
     std::string cacheFilename;
     std::map<size_t, struct Kokkos_Tools_VariableInfo> cachedVariables;
     std::map<size_t, std::string> cachedVariableNames;
-    std::map<std::string, std::map<size_t, struct Kokkos_Tools_VariableValue> > cachedTunings;
+    std::unordered_map<std::string, std::map<size_t, struct Kokkos_Tools_VariableValue> > cachedTunings;
+    /* the converged contexts, to start new contexts from similar ones */
+    apex::context_model model;
+    bool parseContextName(const std::string& name,
+        std::vector<apex::context_input>& inputs);
 };
 
-/* If we've cached values, we can bypass a lot. */
+/* If we've cached values, we can bypass a lot.  The binary cache is read
+ * and then appended to as contexts converge; a YAML cache from an older
+ * version of APEX is only read. */
 bool KokkosSession::checkForCache() {
     static bool once{false};
     if (once) { return use_history; }
@@ -199,83 +212,87 @@ bool KokkosSession::checkForCache() {
     if (strlen(apex::apex_options::kokkos_tuning_cache()) > 0) {
         cacheFilename = std::string(apex::apex_options::kokkos_tuning_cache());
     } else {
-        cacheFilename = std::string("./apex_converged_tuning.yaml");
+        cacheFilename = std::string("./apex_converged_tuning.cache");
+        std::ifstream binary(cacheFilename);
+        std::ifstream legacy("./apex_converged_tuning.yaml");
+        if (!binary.good() && legacy.good()) {
+            cacheFilename = std::string("./apex_converged_tuning.yaml");
+        }
     }
     std::ifstream f(cacheFilename);
-    if (f.good()) {
+    // an empty file was just created by another rank
+    if (f.good() && f.peek() != std::ifstream::traits_type::eof()) {
         use_history = true;
         if(verbose) {
             std::cout << "Cache found" << std::endl;
         }
-        readCache();
+        if (apex::tuning_cache::is_cache(cacheFilename)) {
+            // don't add to a cache we can't read
+            appendCache = readBinaryCache();
+        } else {
+            readCache();
+        }
     } else {
         if(verbose) {
             std::cout << "Cache not found" << std::endl;
         }
+        appendCache = true;
     }
     return use_history;
 }
 
 void KokkosSession::saveInputVar(size_t id, Variable * var) {
     inputs.insert(std::make_pair(id, var));
-    if (!use_history) {
-        cachedResults << "Input_" << id << ":" << std::endl;
-        cachedResults << var->toString();
-    }
+    saveVar(var);
 }
 
 void KokkosSession::saveOutputVar(size_t id, Variable * var) {
     outputs.insert(std::make_pair(id, var));
-    if (!use_history) {
-        cachedResults << "Output_" << id << ":" << std::endl;
-        cachedResults << var->toString();
-    }
+    saveVar(var);
 }
 
-void KokkosSession::writeCache(void) {
-    if(use_history) { return; }
-    // did the user specify a file?
-    if (strlen(apex::apex_options::kokkos_tuning_cache()) > 0) {
-        cacheFilename = std::string(apex::apex_options::kokkos_tuning_cache());
-    } else {
-        cacheFilename = std::string("./apex_converged_tuning.yaml");
-    }
-    std::ofstream results(cacheFilename);
-    std::cout << "Writing cache of Kokkos tuning results to: '" << cacheFilename << "'" << std::endl;
-    results << cachedResults.rdbuf();
-    size_t count = 0;
-    for (const auto &req : requests) {
-        results << "Context_" << count++ << ":" << std::endl;
-        results << "  Name: \"" << req.first << "\"" << std::endl;
-        std::shared_ptr<apex_tuning_request> request = req.second;
-        results << "  Converged: " <<
-            (request->has_converged() ? "true" : "false") << std::endl;
-        if (request->has_converged()) {
-            results << "  Results:" << std::endl;
-            results << "    NumVars: " << var_ids[req.first].size() << std::endl;
-            for (const auto &id : var_ids[req.first]) {
-                results << "    id: " << id << std::endl;
-                Variable* var{KokkosSession::getSession().outputs[id]};
-                if (var->info.valueQuantity == kokkos_value_set) {
-                    auto param = std::static_pointer_cast<apex_param_enum>(
-                        request->get_param(var->name));
-                    results << "    value: " << param->get_value() << std::endl;
-                } else if (var->info.valueQuantity == kokkos_value_range) {
-                    if (var->info.type == kokkos_value_double) {
-                        auto param = std::static_pointer_cast<apex_param_double>(
-                            request->get_param(var->name));
-                        results << "    value: " << param->get_value() << std::endl;
-                    } else if (var->info.type == kokkos_value_int64) {
-                        auto param = std::static_pointer_cast<apex_param_long>(
-                            request->get_param(var->name));
-                        results << "    value: " << param->get_value() << std::endl;
-                    }
-                }
-            }
+/* The cache needs the variables to read the tuned values back */
+void KokkosSession::saveVar(Variable * var) {
+    if (!appendCache || cachedVariables.count(var->id) > 0) { return; }
+    apex::tuning_variable variable;
+    variable.id = var->id;
+    variable.name = var->name;
+    variable.type = var->info.type;
+    variable.category = var->info.category;
+    variable.quantity = var->info.valueQuantity;
+    apex::tuning_cache::append(cacheFilename, variable);
+}
+
+/* Append a converged context to the cache, so it is kept even if the run
+ * doesn't finish, and other ranks and runs can use it. */
+void KokkosSession::saveTunings(const std::string& name, const size_t vars,
+    const Kokkos_Tools_VariableValue* values) {
+    if (!appendCache) { return; }
+    static bool once{false};
+    if (!once) {
+        std::cout << "Writing cache of Kokkos tuning results to: '" << cacheFilename << "'" << std::endl;
+        once = true;
+    }
+    std::vector<apex::tuning_value> tuned;
+    for (size_t i = 0 ; i < vars ; i++) {
+        apex::tuning_value value;
+        value.id = values[i].type_id;
+        Variable* var{outputs[value.id]};
+        if (var->info.type == kokkos_value_double) {
+            value.type = apex::tuning_value_type::DOUBLE;
+            value.dvalue = values[i].value.double_value;
+        } else if (var->info.type == kokkos_value_int64) {
+            value.type = apex::tuning_value_type::INT64;
+            value.lvalue = values[i].value.int_value;
+        } else {
+            value.type = apex::tuning_value_type::STRING;
+            value.svalue = std::string(values[i].value.string_value);
         }
-        // if not converged, need to get the "best so far" values for the parameters.
+        tuned.push_back(value);
+    }
+    if (!apex::tuning_cache::append(cacheFilename, name, tuned)) {
+        std::cerr << "Error writing the Kokkos tuning cache '" << cacheFilename << "'" << std::endl;
     }
-    results.close();
 }
 
 void KokkosSession::parseVariableCache(std::ifstream& results) {
@@ -370,9 +387,40 @@ void KokkosSession::parseContextCache(std::ifstream& results) {
             vars.insert(std::make_pair(id, std::move(var)));
         }
         cachedTunings.insert(std::make_pair(name, std::move(vars)));
+        std::vector<apex::context_input> inputs;
+        if (parseContextName(name, inputs)) {
+            model.add(name, inputs);
+        }
     }
 }
 
+/* Get the input values back from the name of a cached context, like
+ * "[1:1000,2:parallel_for]".  Contexts with strings that can't be parsed
+ * are only used for exact matches. */
+bool KokkosSession::parseContextName(const std::string& name,
+    std::vector<apex::context_input>& inputs) {
+    if (name.size() < 2 || name.front() != '[' || name.back() != ']') {
+        return false;
+    }
+    std::stringstream ss(name.substr(1, name.size() - 2));
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        size_t colon = item.find(':');
+        if (colon == std::string::npos) { return false; }
+        size_t id = atol(item.substr(0, colon).c_str());
+        std::string value = item.substr(colon + 1);
+        auto info = cachedVariables.find(id);
+        if (info == cachedVariables.end()) { return false; }
+        if (info->second.type == kokkos_value_string ||
+            info->second.category == kokkos_value_categorical) {
+            inputs.push_back(apex::context_input(id, value));
+        } else {
+            inputs.push_back(apex::context_input(id, atof(value.c_str())));
+        }
+    }
+    return true;
+}
+
 void KokkosSession::readCache(void) {
     std::ifstream results(cacheFilename);
     std::cout << "Reading cache of Kokkos tuning results from: '" << cacheFilename << "'" << std::endl;
@@ -398,6 +446,56 @@ void KokkosSession::readCache(void) {
     }
 }
 
+bool KokkosSession::readBinaryCache(void) {
+    std::cout << "Reading cache of Kokkos tuning results from: '" << cacheFilename << "'" << std::endl;
+    apex::tuning_cache cache;
+    std::string error;
+    bool ok = cache.read(cacheFilename, error);
+    if (!error.empty()) {
+        std::cerr << "Kokkos tuning cache: " << error << std::endl;
+    }
+    if (!ok) { return false; }
+    for (const auto &v : cache.variables) {
+        struct Kokkos_Tools_VariableInfo info;
+        memset(&info, 0, sizeof(struct Kokkos_Tools_VariableInfo));
+        info.type = (Kokkos_Tools_VariableInfo_ValueType)v.second.type;
+        info.category =
+            (Kokkos_Tools_VariableInfo_StatisticalCategory)v.second.category;
+        info.valueQuantity =
+            (Kokkos_Tools_VariableInfo_CandidateValueType)v.second.quantity;
+        cachedVariables.insert(std::make_pair(v.first, std::move(info)));
+        cachedVariableNames.insert(std::make_pair(v.first, v.second.name));
+    }
+    for (const auto &name : cache.names) {
+        std::map<size_t, struct Kokkos_Tools_VariableValue> vars;
+        bool known = true;
+        for (const auto &value : cache.contexts[name]) {
+            auto info = cachedVariables.find(value.id);
+            if (info == cachedVariables.end()) { known = false; break; }
+            struct Kokkos_Tools_VariableValue var;
+            memset(&var, 0, sizeof(struct Kokkos_Tools_VariableValue));
+            var.type_id = value.id;
+            if (value.type == apex::tuning_value_type::DOUBLE) {
+                var.value.double_value = value.dvalue;
+            } else if (value.type == apex::tuning_value_type::INT64) {
+                var.value.int_value = value.lvalue;
+            } else {
+                strncpy(var.value.string_value, value.svalue.c_str(),
+                    KOKKOS_TOOLS_TUNING_STRING_LENGTH - 1);
+            }
+            var.metadata = &(info->second);
+            vars.insert(std::make_pair(value.id, std::move(var)));
+        }
+        if (!known) { continue; }
+        cachedTunings.insert(std::make_pair(name, std::move(vars)));
+        std::vector<apex::context_input> inputs;
+        if (parseContextName(name, inputs)) {
+            model.add(name, inputs);
+        }
+    }
+    return true;
+}
+
 KokkosSession& KokkosSession::getSession() {
     static KokkosSession session;
     return session;
@@ -497,6 +595,25 @@ size_t& getDepth() {
     return depth;
 }
 
+/* A value as it appears in a context name.  Categorical inputs are
+ * compared with this string, so they have to be written the same way. */
+void writeValue(std::ostream& ss, const Kokkos_Tools_VariableValue& value,
+    Kokkos_Tools_VariableInfo_ValueType type) {
+    switch (type) {
+        case kokkos_value_double:
+            ss << value.value.double_value;
+            break;
+        case kokkos_value_int64:
+            ss << value.value.int_value;
+            break;
+        case kokkos_value_string:
+            ss << value.value.string_value;
+            break;
+        default:
+            break;
+    }
+}
+
 std::string hashContext(size_t numVars,
     const Kokkos_Tools_VariableValue* values,
     std::map<size_t, Variable*>& varmap) {
@@ -506,19 +623,7 @@ std::string hashContext(size_t numVars,
         auto id = values[i].type_id;
         ss << d << id << ":";
         Variable* var{varmap[id]};
-        switch (var->info.type) {
-            case kokkos_value_double:
-                ss << values[i].value.double_value;
-                break;
-            case kokkos_value_int64:
-                ss << values[i].value.int_value;
-                break;
-            case kokkos_value_string:
-                ss << values[i].value.string_value;
-                break;
-            default:
-                break;
-        }
+        writeValue(ss, values[i], var->info.type);
         d = ",";
     }
     ss << "]";
@@ -547,11 +652,8 @@ bool getCachedTunings(std::string name,
     for (size_t i = 0 ; i < vars ; i++) {
         auto id = values[i].type_id;
         auto variter = result->second.find(id);
-        auto nameiter = session.cachedVariableNames.find(id);
         if (variter == result->second.end()) { return false; }
-        if (nameiter == session.cachedVariableNames.end()) { return false; }
         auto var = variter->second;
-        auto varname = nameiter->second;
         if (var.metadata->type == kokkos_value_double) {
             values[i].value.double_value = var.value.double_value;
             //std::string tmp(name+":"+varname);
@@ -609,6 +711,100 @@ void set_params(std::shared_ptr<apex_tuning_request> request,
     }
 }
 
+/* The input values of a context, for the context model */
+std::vector<apex::context_input> contextInputs(size_t numVars,
+    const Kokkos_Tools_VariableValue* values) {
+    KokkosSession& session = KokkosSession::getSession();
+    std::vector<apex::context_input> inputs;
+    for (size_t i = 0 ; i < numVars ; i++) {
+        auto id = values[i].type_id;
+        Variable* var{session.inputs[id]};
+        if (var->info.type == kokkos_value_string) {
+            inputs.push_back(apex::context_input(id,
+                std::string(values[i].value.string_value)));
+        } else if (var->info.category == kokkos_value_categorical) {
+            // the same string as in the context name
+            std::stringstream ss;
+            writeValue(ss, values[i], var->info.type);
+            inputs.push_back(apex::context_input(id, ss.str()));
+        } else {
+            inputs.push_back(apex::context_input(id,
+                var->info.type == kokkos_value_double ?
+                values[i].value.double_value :
+                (double)values[i].value.int_value));
+        }
+    }
+    return inputs;
+}
+
+bool sameTunings(const std::map<size_t, Kokkos_Tools_VariableValue>& a,
+    const std::map<size_t, Kokkos_Tools_VariableValue>& b) {
+    if (a.size() != b.size()) { return false; }
+    for (const auto &kv : a) {
+        auto other = b.find(kv.first);
+        if (other == b.end()) { return false; }
+        const auto &x = kv.second;
+        const auto &y = other->second;
+        if (x.metadata->type == kokkos_value_double) {
+            if (x.value.double_value != y.value.double_value) { return false; }
+        } else if (x.metadata->type == kokkos_value_int64) {
+            if (x.value.int_value != y.value.int_value) { return false; }
+        } else if (strncmp(x.value.string_value, y.value.string_value,
+            KOKKOS_TOOLS_TUNING_STRING_LENGTH) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* A new context: if the two nearest converged contexts are close enough
+ * and agree, use their configuration without a search.  Otherwise, start
+ * the search from the configuration of the nearest one. */
+bool inferTunings(const std::string & name,
+    const std::vector<apex::context_input>& inputs, const size_t vars,
+    Kokkos_Tools_VariableValue* values) {
+    KokkosSession& session = KokkosSession::getSession();
+    auto nearest = session.model.nearest(inputs, 2);
+    if (nearest.empty()) { return false; }
+    const auto &first = session.cachedTunings[nearest[0].second];
+    if (nearest.size() == 2 && nearest[1].first <=
+        apex::apex_options::kokkos_tuning_neighbor_distance() &&
+        sameTunings(first, session.cachedTunings[nearest[1].second])) {
+        // remember it, the next request for this context is a lookup
+        session.cachedTunings[name] = first;
+        if(session.verbose) {
+            std::cout << "Using the tuning of " << nearest[0].second
+                      << " for " << name << std::endl;
+        }
+        return getCachedTunings(name, vars, values);
+    }
+    if(session.verbose) {
+        std::cout << "Starting the search for " << name << " from "
+                  << nearest[0].second << std::endl;
+    }
+    getCachedTunings(nearest[0].second, vars, values);
+    return false;
+}
+
+/* A converged context, remember its configuration for the next requests,
+ * the similar contexts and the next runs */
+void learnTunings(const std::string & name,
+    const std::vector<apex::context_input>& inputs, bool use_model,
+    const size_t vars, const Kokkos_Tools_VariableValue* values) {
+    KokkosSession& session = KokkosSession::getSession();
+    std::map<size_t, Kokkos_Tools_VariableValue> tuned;
+    for (size_t i = 0 ; i < vars ; i++) {
+        Kokkos_Tools_VariableValue value = values[i];
+        value.metadata = &(session.outputs[value.type_id]->info);
+        tuned.insert(std::make_pair(value.type_id, value));
+    }
+    session.cachedTunings[name] = std::move(tuned);
+    session.saveTunings(name, vars, values);
+    if (use_model) {
+        session.model.add(name, inputs);
+    }
+}
+
 bool handle_start(const std::string & name, const size_t vars,
     Kokkos_Tools_VariableValue* values, uint64_t& delta, bool& converged) {
     KokkosSession& session = KokkosSession::getSession();
@@ -637,18 +833,18 @@ bool handle_start(const std::string & name, const size_t vars,
         bool verbose = session.verbose;
         // Create a metric
         std::function<double(void)> metric = [=]()->double{
-            apex_profile * profile = apex::get_profile(name);
-            if(profile == nullptr) {
+            apex_profile profile;
+            if(!apex::get_profile(name, profile)) {
                 std::cerr << "ERROR: no profile for " << name << std::endl;
                 //abort();
                 return 0.0;
             }
-            if(profile->calls == 0.0) {
+            if(profile.calls == 0.0) {
                 std::cerr << "ERROR: calls = 0 for " << name << std::endl;
                 //abort();
                 return 0.0;
             }
-            double result = profile->accumulated/profile->calls;
+            double result = profile.accumulated/profile.calls;
             if(verbose) {
                 std::cout << "querying time per call: " << (double)(result)/1000000000.0 << "s" << std::endl;
             }
@@ -662,6 +858,10 @@ bool handle_start(const std::string & name, const size_t vars,
         request->set_aggregation_times(3);
         // min, max, mean
         request->set_aggregation_function("min");
+        /* Between 2 and 10 calls per configuration for the in-tree
+         * strategies: stable kernels need few calls, and configurations
+         * that are clearly slower than the best one are dropped early. */
+        request->set_adaptive_sampling(2, 10);
 
         for (size_t i = 0 ; i < vars ; i++) {
             auto id = values[i].type_id;
@@ -675,7 +875,7 @@ bool handle_start(const std::string & name, const size_t vars,
                     front = std::to_string(values[i].value.double_value);
                 } else if (var->info.type == kokkos_value_int64) {
                     front = std::to_string(values[i].value.int_value);
-                } else if (var->info.type == kokkos_value_int64) {
+                } else if (var->info.type == kokkos_value_string) {
                     front = std::string(values[i].value.string_value);
                 }
                 //printf("Initial value: %s\n", front.c_str()); fflush(stdout);
@@ -723,10 +923,10 @@ void handle_stop(const std::string & name) {
     if(search == session.requests.end()) {
         std::cerr << "ERROR: No data for " << name << std::endl;
     } else {
-        apex_profile * profile = apex::get_profile(name);
+        apex_profile profile;
         if(session.window == 1 ||
-           (profile != nullptr &&
-            profile->calls >= session.window)) {
+           (apex::get_profile(name, profile) &&
+            profile.calls >= session.window)) {
             //std::cout << "Num calls: " << profile->calls << std::endl;
             std::shared_ptr<apex_tuning_request> request = search->second;
             // Evaluate the results
@@ -828,10 +1028,19 @@ void kokkosp_request_values(
     // create a unique name for this combination of input vars
     std::string name{hashContext(numContextVariables, contextVariableValues,
         session.inputs)};
-    // check if we have a cached result
-    bool success{false};
-    if (session.use_history) {
-        success = getCachedTunings(name, numTuningVariables, tuningVariableValues);
+    // check if we have a cached result, from a file or from this run
+    bool success = getCachedTunings(name, numTuningVariables,
+        tuningVariableValues);
+    // a new context, use what we know about similar ones
+    bool use_model = apex::apex_options::use_kokkos_tuning_neighbors() &&
+        numContextVariables > 0;
+    std::vector<apex::context_input> inputs;
+    if (!success && use_model) {
+        inputs = contextInputs(numContextVariables, contextVariableValues);
+        if (session.requests.count(name) == 0) {
+            success = inferTunings(name, inputs, numTuningVariables,
+                tuningVariableValues);
+        }
     }
     if (success) {
         session.used_history.insert(contextId);
@@ -842,6 +1051,10 @@ void kokkosp_request_values(
             // throw away the time spent setting up tuning
             //session.context_starts[contextId] = session.context_starts[contextId] + delta;
         }
+        if (converged) {
+            learnTunings(name, inputs, use_model, numTuningVariables,
+                tuningVariableValues);
+        }
         if (!converged) {
             // add this name to our map of active contexts
             session.active_requests.insert(
@@ -117,6 +117,21 @@ inline void __set_thread_cap(int new_cap) {
   return;
 }
 
+/* A consistent copy of the profile of the function being tuned, or nullptr
+ * if there is no data yet. */
+inline apex_profile * __get_function_profile(apex_profile &values) {
+    bool found;
+    if(thread_cap_tuning_session->function_of_interest !=
+        APEX_NULL_FUNCTION_ADDRESS) {
+        found = apex::get_profile(
+            thread_cap_tuning_session->function_of_interest, values);
+    } else {
+        found = apex::get_profile(
+            thread_cap_tuning_session->function_name_of_interest, values);
+    }
+    return found ? &values : nullptr;
+}
+
 #if 0  // unused for now
 inline int __get_inputs(long int **inputs, int * num_inputs) {
   inputs = &(tuning_session->__ah_inputs[0]);
@@ -317,15 +332,8 @@ int apex_throughput_throttling_policy(apex_context const context) {
       return APEX_NOERROR;
     }
 
-    apex_profile * function_profile = nullptr;
-    if(thread_cap_tuning_session->function_of_interest !=
-    APEX_NULL_FUNCTION_ADDRESS) {
-        function_profile = apex::get_profile(
-            thread_cap_tuning_session->function_of_interest);
-    } else {
-        function_profile = apex::get_profile(
-            thread_cap_tuning_session->function_name_of_interest);
-    }
+    apex_profile values;
+    apex_profile * function_profile = __get_function_profile(values);
     double current_mean = function_profile->accumulated /
         function_profile->calls;
     //printf("%d Calls: %f, Accum: %f, Mean: %f\n", tuning_session->test_pp,
@@ -488,19 +496,9 @@ int apex_throughput_throttling_dhc_policy(apex_context const context) {
     static bool got_low = false;
     static bool got_high = false;
 
-    apex_profile * function_profile = nullptr;
     // get a measurement of our current setting
-    if(thread_cap_tuning_session->function_of_interest !=
-        APEX_NULL_FUNCTION_ADDRESS) {
-        function_profile =
-            apex::get_profile(thread_cap_tuning_session->function_of_interest);
-        //reset(tuning_session->function_of_interest); // we want new measurements!
-    } else {
-        function_profile =
-            apex::get_profile(thread_cap_tuning_session->function_name_of_interest);
-        //reset(tuning_session->function_name_of_interest); // we want new
-        //measurements!
-    }
+    apex_profile values;
+    apex_profile * function_profile = __get_function_profile(values);
     // if we have no data yet, return.
     if (function_profile == nullptr) {
         printf ("No Data?\n");
@@ -662,19 +660,8 @@ int apex_throughput_throttling_ah_policy(apex_context const context) {
     }
 
     // get a measurement of our current setting
-    apex_profile * function_profile = nullptr;
-    if(thread_cap_tuning_session->function_of_interest !=
-        APEX_NULL_FUNCTION_ADDRESS) {
-        function_profile =
-            apex::get_profile(thread_cap_tuning_session->function_of_interest);
-        //reset(thread_cap_tuning_session->function_of_interest);
-        // we want new measurements!
-    } else {
-        function_profile =
-            apex::get_profile(thread_cap_tuning_session->function_name_of_interest);
-        //reset(thread_cap_tuning_session->function_name_of_interest);
-        // we want new measurements!
-    }
+    apex_profile values;
+    apex_profile * function_profile = __get_function_profile(values);
     // if we have no data yet, return.
     if (function_profile == nullptr) {
         cerr << "No profile data?" << endl;
@@ -751,15 +738,8 @@ int apex_throughput_tuning_policy(apex_context const context) {
     }
 
     // get a measurement of our current setting
-    apex_profile * function_profile = nullptr;
-    if(thread_cap_tuning_session->function_of_interest !=
-        APEX_NULL_FUNCTION_ADDRESS) {
-        function_profile =
-        apex::get_profile(thread_cap_tuning_session->function_of_interest);
-    } else {
-        function_profile =
-        apex::get_profile(thread_cap_tuning_session->function_name_of_interest);
-    }
+    apex_profile values;
+    apex_profile * function_profile = __get_function_profile(values);
     // if we have no data yet, return.
     if (function_profile == nullptr) {
         cerr << "No profile data?" << endl;
@@ -878,6 +858,14 @@ int apex_custom_tuning_policy(shared_ptr<apex_tuning_session> tuning_session,
 }
 #endif // APEX_HAVE_ACTIVEHARMONY
 
+inline void __print_sampling(shared_ptr<apex_tuning_session> tuning_session) {
+    const apex::adaptive_sampler & sampler = tuning_session->sampler;
+    if (!sampler.enabled()) { return; }
+    cout << "APEX: " << sampler.samples() << " samples for "
+         << sampler.candidates() << " configurations, "
+         << sampler.discarded() << " discarded early." << endl;
+}
+
 int apex_sa_policy(shared_ptr<apex_tuning_session> tuning_session,
     apex_context const context) {
     APEX_UNUSED(context);
@@ -888,6 +876,7 @@ int apex_sa_policy(shared_ptr<apex_tuning_session> tuning_session,
             tuning_session->converged_message = true;
             cout << "APEX: Tuning has converged for session " << tuning_session->id
             << "." << endl;
+            __print_sampling(tuning_session);
             tuning_session->sa_session.saveBestSettings();
             tuning_session->sa_session.printBestSettings();
         }
@@ -897,6 +886,9 @@ int apex_sa_policy(shared_ptr<apex_tuning_session> tuning_session,
 
     // get a measurement of our current setting
     double new_value = tuning_session->metric_of_interest();
+    // keep measuring it, if the sampler needs more samples
+    if (!tuning_session->sampler.add(new_value)) { return APEX_NOERROR; }
+    new_value = tuning_session->sampler.cost();
 
     /* Report the performance we've just measured. */
     tuning_session->sa_session.evaluate(new_value);
@@ -907,6 +899,39 @@ int apex_sa_policy(shared_ptr<apex_tuning_session> tuning_session,
     return APEX_NOERROR;
 }
 
+int apex_search_policy(shared_ptr<apex_tuning_session> tuning_session,
+    apex_context const context) {
+    APEX_UNUSED(context);
+    if (apex_final) return APEX_NOERROR; // we terminated
+    std::unique_lock<std::mutex> l{shutdown_mutex};
+    if (tuning_session->search_session.converged()) {
+        if (!tuning_session->converged_message) {
+            tuning_session->converged_message = true;
+            cout << "APEX: Tuning has converged for session " << tuning_session->id
+            << " after " << tuning_session->search_session.get_evaluations()
+            << " evaluations." << endl;
+            __print_sampling(tuning_session);
+            tuning_session->search_session.print_best_settings();
+        }
+        tuning_session->search_session.save_best_settings();
+        return APEX_NOERROR;
+    }
+
+    // get a measurement of our current setting
+    double new_value = tuning_session->metric_of_interest();
+    // keep measuring it, if the sampler needs more samples
+    if (!tuning_session->sampler.add(new_value)) { return APEX_NOERROR; }
+    new_value = tuning_session->sampler.cost();
+
+    /* Report the performance we've just measured. */
+    tuning_session->search_session.evaluate(new_value);
+
+    /* Request new settings for next time */
+    tuning_session->search_session.get_new_settings();
+
+    return APEX_NOERROR;
+}
+
 
 /// ----------------------------------------------------------------------------
 ///
@@ -1454,6 +1479,114 @@ inline int __sa_setup(shared_ptr<apex_tuning_session>
   return APEX_NOERROR;
 }
 
+/* Is this strategy in-tree, or does it need Active Harmony? */
+inline bool __is_search_strategy(apex_ah_tuning_strategy s) {
+#ifdef APEX_HAVE_ACTIVEHARMONY
+    return s == apex_ah_tuning_strategy::COORDINATE_DESCENT ||
+        s == apex_ah_tuning_strategy::BAYESIAN_OPTIMIZATION;
+#else
+    return s != apex_ah_tuning_strategy::SIMULATED_ANNEALING;
+#endif
+}
+
+inline int __search_setup(shared_ptr<apex_tuning_session>
+    tuning_session, apex_tuning_request & request) {
+  // iterate over the parameters, and create variables.
+  using namespace apex::search;
+  for(auto & kv : request.params) {
+      auto & param = kv.second;
+      switch(param->get_type()) {
+          case apex_param_type::LONG: {
+              auto param_long =
+              std::static_pointer_cast<apex_param_long>(param);
+              variable v(variable_type::longtype, param_long->value.get());
+              long lvalue = param_long->min;
+              do {
+                  v.lvalues.push_back(lvalue);
+                  lvalue = lvalue + param_long->step;
+              } while (param_long->step > 0 && lvalue <= param_long->max);
+              if (param_long->step > 0 && param_long->init > param_long->min) {
+                  v.initial = (param_long->init - param_long->min) /
+                      param_long->step;
+              }
+              tuning_session->search_session.add_var(param->get_name(), v);
+          }
+          break;
+          case apex_param_type::DOUBLE: {
+              auto param_double =
+              std::static_pointer_cast<apex_param_double>(param);
+              variable v(variable_type::doubletype, param_double->value.get());
+              // count the values, so the steps don't add up rounding errors
+              size_t count = 1;
+              if (param_double->step > 0.0 &&
+                  param_double->max > param_double->min) {
+                  count += (size_t)((param_double->max - param_double->min) /
+                      param_double->step + 1.0e-9);
+              }
+              for (size_t i = 0 ; i < count ; i++) {
+                  v.dvalues.push_back(param_double->min +
+                      i * param_double->step);
+              }
+              if (count > 1 && param_double->init > param_double->min) {
+                  v.initial = (size_t)std::lround((param_double->init -
+                      param_double->min) / param_double->step);
+              }
+              tuning_session->search_session.add_var(param->get_name(), v);
+          }
+          break;
+          case apex_param_type::ENUM: {
+              auto param_enum =
+              std::static_pointer_cast<apex_param_enum>(param);
+              variable v(variable_type::stringtype, param_enum->value.get());
+              for(const std::string & possible_value :
+                             param_enum->possible_values) {
+                  if (possible_value == param_enum->init_value) {
+                      v.initial = v.svalues.size();
+                  }
+                  v.svalues.push_back(possible_value);
+              }
+              if (v.svalues.empty()) {
+                  cerr << "ERROR: Tuning parameter " << param->get_name()
+                  << " has no possible values." << endl;
+                  return APEX_ERROR;
+              }
+              tuning_session->search_session.add_var(param->get_name(), v);
+          }
+          break;
+          default:
+              cerr <<
+              "ERROR: Attempted to register tuning parameter with unknown type."
+              << endl;
+              return APEX_ERROR;
+      }
+  }
+  strategy_type type = strategy_type::NELDER_MEAD;
+  switch(request.strategy) {
+      case apex_ah_tuning_strategy::EXHAUSTIVE:
+          type = strategy_type::EXHAUSTIVE;
+          break;
+      case apex_ah_tuning_strategy::RANDOM:
+          type = strategy_type::RANDOM;
+          break;
+      case apex_ah_tuning_strategy::COORDINATE_DESCENT:
+          type = strategy_type::COORDINATE_DESCENT;
+          break;
+      case apex_ah_tuning_strategy::BAYESIAN_OPTIMIZATION:
+          type = strategy_type::TPE;
+          break;
+      default: // Nelder-Mead, and the closest thing to parallel rank order
+          type = strategy_type::NELDER_MEAD;
+          break;
+  }
+  tuning_session->strategy = request.strategy;
+  tuning_session->search_session.start(type, request.max_evaluations,
+      tuning_session->id);
+  /* request initial settings */
+  tuning_session->search_session.get_new_settings();
+
+  return APEX_NOERROR;
+}
+
 inline int __common_setup_timer_throttling(apex_optimization_criteria_t
     criteria, apex_optimization_method_t method, unsigned long update_interval)
 {
@@ -1535,6 +1668,8 @@ inline int __common_setup_custom_tuning(shared_ptr<apex_tuning_session>
 inline int __common_setup_custom_tuning(shared_ptr<apex_tuning_session>
     tuning_session, apex_tuning_request & request) {
     __read_common_variables(tuning_session);
+    tuning_session->sampler = apex::adaptive_sampler(request.min_samples,
+        request.max_samples);
     int status = APEX_NOERROR;
     // if using the simulated annealing strategy, don't use AH!
     if (request.strategy == apex_ah_tuning_strategy::SIMULATED_ANNEALING) {
@@ -1547,6 +1682,16 @@ inline int __common_setup_custom_tuning(shared_ptr<apex_tuning_session>
             }
             );
         }
+    } else if (__is_search_strategy(request.strategy)) {
+        status = __search_setup(tuning_session, request);
+        if(status == APEX_NOERROR) {
+            apex::register_policy(
+            request.trigger,
+            [=](apex_context const & context)->int {
+                return apex_search_policy(tuning_session, context);
+            }
+            );
+        }
     } else {
         int status = __active_harmony_custom_setup(tuning_session, request);
         if(status == APEX_NOERROR) {
@@ -1771,7 +1916,9 @@ APEX_EXPORT bool has_session_converged(apex_tuning_session_handle h) {
 APEX_EXPORT void get_best_values(apex_tuning_session_handle h) {
     if (apex_options::disable() == true) { return; }
     auto tuning_session = get_session(h);
-    if(tuning_session && tuning_session->htask != nullptr) {
+    if(tuning_session && tuning_session->search_session.started()) {
+        tuning_session->search_session.save_best_settings();
+    } else if(tuning_session && tuning_session->htask != nullptr) {
 #ifdef APEX_HAVE_ACTIVEHARMONY
         ah_best(tuning_session->htask);
 #endif
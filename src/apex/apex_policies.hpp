@@ -29,10 +29,19 @@
 #include "apex_policies.h"
 // include the simulated annealing class
 #include "simulated_annealing.hpp"
+// include the in-tree search strategies
+#include "search_strategy.hpp"
+// include the adaptive sampling of the metric
+#include "adaptive_sampling.hpp"
 
 enum class apex_param_type : int {NONE, LONG, DOUBLE, ENUM};
+/* Without Active Harmony, the first four use the in-tree search strategies
+ * (PARALLEL_RANK_ORDER uses Nelder-Mead).  SIMULATED_ANNEALING,
+ * COORDINATE_DESCENT and BAYESIAN_OPTIMIZATION (a tree-structured Parzen
+ * estimator, for expensive metrics) are always in-tree. */
 enum class apex_ah_tuning_strategy : int {EXHAUSTIVE, RANDOM, NELDER_MEAD,
-PARALLEL_RANK_ORDER, SIMULATED_ANNEALING};
+PARALLEL_RANK_ORDER, SIMULATED_ANNEALING, COORDINATE_DESCENT,
+BAYESIAN_OPTIMIZATION};
 
 struct apex_tuning_session;
 class apex_tuning_request;
@@ -67,6 +76,8 @@ class apex_param {
         tuning_session, apex_tuning_request & request);
         friend int __sa_setup(std::shared_ptr<apex_tuning_session>
             tuning_session, apex_tuning_request & request);
+        friend int __search_setup(std::shared_ptr<apex_tuning_session>
+            tuning_session, apex_tuning_request & request);
 };
 
 class apex_param_long : public apex_param {
@@ -100,6 +111,8 @@ class apex_param_long : public apex_param {
         tuning_session, apex_tuning_request & request);
         friend int __sa_setup(std::shared_ptr<apex_tuning_session>
             tuning_session, apex_tuning_request & request);
+        friend int __search_setup(std::shared_ptr<apex_tuning_session>
+            tuning_session, apex_tuning_request & request);
 };
 
 class apex_param_double : public apex_param {
@@ -133,6 +146,8 @@ class apex_param_double : public apex_param {
         tuning_session, apex_tuning_request & request);
         friend int __sa_setup(std::shared_ptr<apex_tuning_session>
             tuning_session, apex_tuning_request & request);
+        friend int __search_setup(std::shared_ptr<apex_tuning_session>
+            tuning_session, apex_tuning_request & request);
 };
 
 class apex_param_enum : public apex_param {
@@ -165,6 +180,8 @@ class apex_param_enum : public apex_param {
         tuning_session, apex_tuning_request & request);
         friend int __sa_setup(std::shared_ptr<apex_tuning_session>
             tuning_session, apex_tuning_request & request);
+        friend int __search_setup(std::shared_ptr<apex_tuning_session>
+            tuning_session, apex_tuning_request & request);
 };
 
 
@@ -180,6 +197,9 @@ class apex_tuning_request {
         double radius;
         int aggregation_times;
         std::string aggregation_function;
+        size_t max_evaluations;
+        size_t min_samples;
+        size_t max_samples;
 
     public:
         apex_tuning_request(const std::string & name, std::function<double()>
@@ -187,13 +207,15 @@ class apex_tuning_request {
             : name{name}, metric{metric}, trigger{trigger},
             tuning_session_handle{0},
             running{false},
-            strategy{apex_ah_tuning_strategy::PARALLEL_RANK_ORDER}  {};
+            strategy{apex_ah_tuning_strategy::PARALLEL_RANK_ORDER},
+            radius(0.5), aggregation_times(3), aggregation_function("min"),
+            max_evaluations(0), min_samples(1), max_samples(1)  {};
         apex_tuning_request(const std::string & name) : name{name},
         trigger{APEX_INVALID_EVENT},
             tuning_session_handle{0}, running{false},
             strategy{apex_ah_tuning_strategy::PARALLEL_RANK_ORDER},
-            radius(0.5), aggregation_times(3), aggregation_function("min")
-            {};
+            radius(0.5), aggregation_times(3), aggregation_function("min"),
+            max_evaluations(0), min_samples(1), max_samples(1) {};
         virtual ~apex_tuning_request()  {};
 
         const std::string & get_name() const {
@@ -291,6 +313,21 @@ class apex_tuning_request {
             aggregation_function = f;
         };
 
+        /* The most evaluations for an in-tree search strategy, 0 for the
+         * strategy's default */
+        void set_max_evaluations(size_t m) {
+            max_evaluations = m;
+        };
+
+        /* For the in-tree strategies: measure each configuration between
+         * min and max times, as needed to tell it apart from the best one
+         * so far (see adaptive_sampling.hpp), instead of once.  The
+         * aggregation settings are for Active Harmony only. */
+        void set_adaptive_sampling(size_t min, size_t max) {
+            min_samples = min;
+            max_samples = max;
+        };
+
         friend apex_tuning_session_handle
         __setup_custom_tuning(apex_tuning_request & request);
         friend int
@@ -301,6 +338,8 @@ class apex_tuning_request {
         tuning_session, apex_tuning_request & request);
         friend int __sa_setup(std::shared_ptr<apex_tuning_session>
             tuning_session, apex_tuning_request & request);
+        friend int __search_setup(std::shared_ptr<apex_tuning_session>
+            tuning_session, apex_tuning_request & request);
 };
 
 
@@ -323,6 +362,10 @@ struct apex_tuning_session {
 
     // if using simulated annealing, this is the request.
     apex::simulated_annealing::SimulatedAnnealing sa_session;
+    // if using an in-tree search strategy, this is the search.
+    apex::search::search_session search_session;
+    // how many samples each configuration gets, for the in-tree strategies
+    apex::adaptive_sampler sampler;
     bool converged_message = false;
 
     // variables related to power throttling
@@ -176,6 +176,18 @@ typedef struct _context
                        for a custom_event */
 } apex_context;
 
+/** A timer stop, as delivered to a stop batch policy.
+ *
+ */
+typedef struct _stop_event
+{
+    void * task_id;    /*!< The apex::task_identifier of the timer */
+    double duration;   /*!< The time from the start (or resume) to the stop,
+                            in nanoseconds */
+    uint64_t guid;     /*!< The GUID of the task */
+    uint64_t thread;   /*!< The APEX id of the thread that stopped the timer */
+} apex_stop_event;
+
 /** The type of a profiler object
  *
  */
@@ -205,16 +217,41 @@ typedef struct _profile
     int times_reset;        /*!< How many times was this timer reset */
 } apex_profile;
 
+/**
+ * The queue wait statistics for a task type in APEX: the time from
+ * creating a task with new_task to its first start, in nanoseconds.
+ * The percentiles are estimated from a histogram.
+ */
+typedef struct _queue_wait
+{
+    double calls;           /*!< Number of tasks started */
+    double mean;            /*!< Mean wait */
+    double median;          /*!< 50th percentile of the wait */
+    double p90;             /*!< 90th percentile of the wait */
+    double p99;             /*!< 99th percentile of the wait */
+    double maximum;         /*!< Longest wait */
+} apex_queue_wait;
+
 /** Rather than use void pointers everywhere, be explicit about
  * what the functions are expecting.
  */
 typedef int (*apex_policy_function)(apex_context const context);
 
+/** A reference to a function that processes a batch of timer stops.
+ */
+typedef int (*apex_stop_batch_function)(apex_stop_event const * events,
+    unsigned long count);
+
 /**
  *  A handle to a tuning session.
  */
 typedef uint32_t apex_tuning_session_handle;
 
+/**
+ *  A handle to a counter registered with apex_register_counter.
+ */
+typedef uint32_t apex_counter_handle;
+
 /** A null pointer representing an APEX function address.
  * Used when a null APEX function address is to be passed in to
  * any apex functions to represent "all functions".
@@ -271,6 +308,12 @@ inline unsigned int sc_nprocessors_onln()
     macro (APEX_OTF2, use_otf2, bool, false) \
     macro (APEX_OTF2_COLLECTIVE_SIZE, otf2_collective_size, int, 1) \
     macro (APEX_TRACE_EVENT, use_trace_event, bool, false) \
+    macro (APEX_TRACE_WINDOWS, use_trace_windows, bool, false) \
+    macro (APEX_FLIGHT_RECORDER, use_flight_recorder, bool, false) \
+    macro (APEX_FLIGHT_RECORDER_SIZE, flight_recorder_size, int, 16384) \
+    macro (APEX_CRITICAL_PATH, use_critical_path, bool, false) \
+    macro (APEX_QUEUE_WAIT, use_queue_wait, bool, false) \
+    macro (APEX_RECORD_EVENTS, use_record_events, bool, false) \
     macro (APEX_POLICY, use_policy, bool, true) \
     macro (APEX_MEASURE_CONCURRENCY, use_concurrency, int, 0) \
     macro (APEX_MEASURE_CONCURRENCY_PERIOD, concurrency_period, int, 1000000) \
@@ -278,6 +321,10 @@ inline unsigned int sc_nprocessors_onln()
     macro (APEX_VERBOSE, use_verbose, bool, false) \
     macro (APEX_PROFILE_OUTPUT, use_profile_output, int, false) \
     macro (APEX_CSV_OUTPUT, use_csv_output, int, false) \
+    macro (APEX_PROFILE_SNAPSHOT, use_profile_snapshot, bool, false) \
+    macro (APEX_SHARED_PROFILE, use_shared_profile, bool, false) \
+    macro (APEX_SHARED_PROFILE_SIZE, shared_profile_size, int, 4096) \
+    macro (APEX_COUNTER_BATCH_SIZE, counter_batch_size, int, 256) \
     macro (APEX_TASKGRAPH_OUTPUT, use_taskgraph_output, bool, false) \
     macro (APEX_TASKTREE_OUTPUT, use_tasktree_output, bool, false) \
     macro (APEX_SOURCE_LOCATION, use_source_location, bool, false) \
@@ -310,8 +357,11 @@ inline unsigned int sc_nprocessors_onln()
     macro (APEX_PIN_APEX_THREADS, pin_apex_threads, bool, true) \
     macro (APEX_TRACK_MEMORY, track_memory, bool, false) \
     macro (APEX_TASK_SCATTERPLOT, task_scatterplot, bool, false) \
+    macro (APEX_SCATTERPLOT_RESERVOIR_SIZE, scatterplot_reservoir_size, int, 128) \
     macro (APEX_TIME_TOP_LEVEL_OS_THREADS, top_level_os_threads, bool, false) \
     macro (APEX_POLICY_DRAIN_TIMEOUT, policy_drain_timeout, int, 1000) \
+    macro (APEX_POLICY_BATCH_PERIOD, policy_batch_period, int, 100000) \
+    macro (APEX_POLICY_RULES_PERIOD, policy_rules_period, int, 1000000) \
     macro (APEX_ENABLE_CUDA, use_cuda, int, false) \
     macro (APEX_CUDA_COUNTERS, use_cuda_counters, int, false) \
     macro (APEX_CUDA_KERNEL_DETAILS, use_cuda_kernel_details, int, false) \
@@ -332,11 +382,23 @@ inline unsigned int sc_nprocessors_onln()
     macro (APEX_KOKKOS_VERBOSE, use_kokkos_verbose, bool, false) \
     macro (APEX_KOKKOS_TUNING, use_kokkos_tuning, bool, true) \
     macro (APEX_KOKKOS_PROFILING_FENCES, use_kokkos_profiling_fences, bool, false) \
+    macro (APEX_KOKKOS_TUNING_NEIGHBORS, use_kokkos_tuning_neighbors, bool, true) \
     macro (APEX_START_DELAY_SECONDS, start_delay_seconds, int, 0) \
     macro (APEX_MAX_DURATION_SECONDS, max_duration_seconds, int, 0) \
 
+/* Building with -DAPEX_THROTTLE=TRUE turns on the overhead budget by
+ * default.  Short timers are then sampled, not measured every time. */
+#if defined(APEX_THROTTLE)
+#define APEX_DEFAULT_OVERHEAD_BUDGET 0.02
+#else
+#define APEX_DEFAULT_OVERHEAD_BUDGET 0.0
+#endif
+
 #define FOREACH_APEX_FLOAT_OPTION(macro) \
-    macro (APEX_SCATTERPLOT_FRACTION, scatterplot_fraction, double, 0.01) \
+    macro (APEX_OVERHEAD_BUDGET, overhead_budget, double, \
+        APEX_DEFAULT_OVERHEAD_BUDGET) \
+    macro (APEX_KOKKOS_TUNING_NEIGHBOR_DISTANCE, \
+        kokkos_tuning_neighbor_distance, double, 1.0) \
 
 #define FOREACH_APEX_STRING_OPTION(macro) \
     macro (APEX_PAPI_METRICS, papi_metrics, char*, "") \
@@ -348,7 +410,9 @@ inline unsigned int sc_nprocessors_onln()
     macro (APEX_OTF2_ARCHIVE_NAME, otf2_archive_name, char*, \
         APEX_DEFAULT_OTF2_ARCHIVE_NAME) \
     macro (APEX_EVENT_FILTER_FILE, task_event_filter_file, char*, "") \
-    macro (APEX_KOKKOS_TUNING_CACHE, kokkos_tuning_cache, char*, "")
+    macro (APEX_POLICY_RULES_FILE, policy_rules_file, char*, "") \
+    macro (APEX_KOKKOS_TUNING_CACHE, kokkos_tuning_cache, char*, "") \
+    macro (APEX_SYMBOL_CACHE_PATH, symbol_cache_path, char*, "")
 
 // Do the clang check first
 #if defined(__APPLE__) || defined(__clang__)
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2014-2021 Kevin Huck
+ * Copyright (c) 2014-2021 University of Oregon
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include "context_model.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace apex {
+
+void context_model::describe(const std::vector<context_input> &inputs,
+    std::string &key, std::vector<double> &features) {
+    key.clear();
+    features.clear();
+    for (auto &i : inputs) {
+        key += std::to_string(i.id);
+        if (i.categorical) {
+            // the length first, so no category can look like another
+            key += "=" + std::to_string(i.category.size()) + ":" + i.category;
+        } else {
+            key += "#";
+            double magnitude = std::log2(1.0 + std::fabs(i.number));
+            features.push_back(i.number < 0.0 ? -magnitude : magnitude);
+        }
+        key += ";";
+    }
+}
+
+bool context_model::add(const std::string &name,
+    const std::vector<context_input> &inputs) {
+    if (!_names.insert(name).second) { return false; }
+    entry e;
+    e.name = name;
+    describe(inputs, e.key, e.features);
+    _entries.push_back(std::move(e));
+    return true;
+}
+
+std::vector<std::pair<double, std::string> > context_model::nearest(
+    const std::vector<context_input> &inputs, size_t k) const {
+    std::string key;
+    std::vector<double> features;
+    describe(inputs, key, features);
+    std::vector<std::pair<double, const entry*> > found;
+    for (auto &e : _entries) {
+        if (e.key != key) { continue; }
+        double sum = 0.0;
+        for (size_t f = 0 ; f < features.size() ; f++) {
+            double d = features[f] - e.features[f];
+            sum += d * d;
+        }
+        found.push_back(std::make_pair(std::sqrt(sum), &e));
+    }
+    size_t n = std::min(k, found.size());
+    std::partial_sort(found.begin(), found.begin() + n, found.end(),
+        [](const std::pair<double, const entry*> &a,
+           const std::pair<double, const entry*> &b) {
+            return a.first < b.first; });
+    std::vector<std::pair<double, std::string> > result;
+    for (size_t i = 0 ; i < n ; i++) {
+        result.push_back(std::make_pair(found[i].first, found[i].second->name));
+    }
+    return result;
+}
+
+} // apex
+
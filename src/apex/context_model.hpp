@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2014-2021 Kevin Huck
+ * Copyright (c) 2014-2021 University of Oregon
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+
+/* A nearest neighbor model of tuning contexts, for the Kokkos autotuning.
+ *
+ * A context is the set of input values a kernel is tuned for, like the
+ * problem size and the kernel name.  The model remembers the contexts whose
+ * tuning has converged, and finds the ones most similar to a new context,
+ * so its search can start from (or skip to) their best configuration.
+ * Categorical inputs (strings, or inputs declared categorical) have to be
+ * equal for contexts to be similar at all.  Numeric inputs are compared on
+ * a log2 scale, because sizes vary by orders of magnitude and a kernel
+ * behaves about the same at 1000 and 1100 elements, but not at 10 and 110:
+ * a distance of 1 is a factor of 2 in one input.
+ */
+
+#include <stddef.h>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace apex {
+
+/* One input value of a context */
+class context_input {
+public:
+    size_t id;
+    bool categorical;
+    double number;
+    std::string category;
+    context_input(size_t id, double number) : id(id), categorical(false),
+        number(number) {}
+    context_input(size_t id, const std::string &category) : id(id),
+        categorical(true), number(0.0), category(category) {}
+};
+
+class context_model {
+private:
+    class entry {
+    public:
+        std::string name;
+        std::string key; // the input ids and the categorical values
+        std::vector<double> features; // the numeric inputs, on a log scale
+    };
+    std::vector<entry> _entries;
+    std::unordered_set<std::string> _names;
+    static void describe(const std::vector<context_input> &inputs,
+        std::string &key, std::vector<double> &features);
+public:
+    /* Remember a converged context, false if it is known already */
+    bool add(const std::string &name, const std::vector<context_input>
+        &inputs);
+    /* The names of the (at most k) known contexts nearest to these inputs,
+     * with their distances, nearest first.  Only contexts with the same
+     * inputs and the same categorical values are considered. */
+    std::vector<std::pair<double, std::string> > nearest(
+        const std::vector<context_input> &inputs, size_t k) const;
+    size_t size(void) const { return _entries.size(); }
+};
+
+} // apex
+
@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2014-2021 Kevin Huck
+ * Copyright (c) 2014-2021 University of Oregon
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include "critical_path_listener.hpp"
+#include "thread_instance.hpp"
+#include "apex_options.hpp"
+#include "profiler.hpp"
+#include "task_wrapper.hpp"
+#include "utils.hpp"
+#include <stdio.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+
+#define APEX_CRITICAL_PATH_TOP_TASKS 10
+
+namespace apex {
+
+critical_path_listener::critical_path_listener (void) : _node_id(0),
+    _total_work(0), _critical_path(0), _critical_chain(nullptr) {
+}
+
+void critical_path_listener::on_startup(startup_event_data &data) {
+    _node_id = (int)data.comm_rank;
+}
+
+static void add_to_chain(critical_path_chain &chain, task_identifier * id,
+    uint64_t time) {
+    for (auto &c : chain) {
+        if (c.first == id) {
+            c.second += time;
+            return;
+        }
+    }
+    chain.push_back(std::make_pair(id, time));
+}
+
+/* Find the entry for a task, creating it if this is the first time we have
+ * heard of it.  Call with the lock held. */
+critical_path_task& critical_path_listener::find_task(uint64_t guid,
+    std::shared_ptr<task_wrapper> &tt_ptr) {
+    auto it = _tasks.find(guid);
+    if (it != _tasks.end()) { return it->second; }
+    critical_path_task& task = _tasks[guid];
+    task.id = tt_ptr->get_task_id();
+    task.parent_guid = tt_ptr->parent_guid;
+    /* A parent can finish before its children are started (or before
+     * asynchronous GPU children are reported), in which case we have
+     * already forgotten it.  Bring it back, already complete, so the
+     * children's chains still reach the grandparent.  A task we haven't
+     * heard of is either finished like that or not started yet (and
+     * on_start() marks it running), so don't look at its profiler, which
+     * may have been freed. */
+    task.complete = true;
+    return task;
+}
+
+bool critical_path_listener::on_start(std::shared_ptr<task_wrapper> &tt_ptr) {
+    if (tt_ptr->guid == 0) { return true; }
+    std::unique_lock<std::mutex> l(_mutex);
+    critical_path_task& task = find_task(tt_ptr->guid, tt_ptr);
+    // the task is running now, even if a child mentioned it first
+    task.complete = false;
+    if (!task.counted && task.parent_guid != 0 && tt_ptr->parent != nullptr) {
+        critical_path_task& parent = find_task(task.parent_guid,
+            tt_ptr->parent);
+        parent.outstanding++;
+        task.counted = true;
+    }
+    return true;
+}
+
+void critical_path_listener::on_yield(std::shared_ptr<profiler> &p) {
+    if (p->tt_ptr == nullptr || p->tt_ptr->guid == 0) { return; }
+    uint64_t elapsed = (uint64_t)(p->elapsed());
+    std::unique_lock<std::mutex> l(_mutex);
+    find_task(p->tt_ptr->guid, p->tt_ptr).work += elapsed;
+}
+
+void critical_path_listener::on_task_complete(
+    std::shared_ptr<task_wrapper> &tt_ptr) {
+    if (tt_ptr->guid == 0) { return; }
+    uint64_t elapsed = 0;
+    profiler * prof = tt_ptr->prof;
+    if (prof != nullptr && prof != profiler::get_disabled_profiler()) {
+        elapsed = (uint64_t)(prof->elapsed());
+    }
+    /* If the parent is the current timer on this thread, this task ran
+     * inside it, not alongside it. */
+    bool nested = false;
+    if (tt_ptr->parent_guid != 0) {
+        profiler * current = thread_instance::get_current_profiler();
+        nested = current != nullptr && current->guid == tt_ptr->parent_guid;
+    }
+    std::unique_lock<std::mutex> l(_mutex);
+    if (tt_ptr->parent_guid != 0 && tt_ptr->parent != nullptr) {
+        find_task(tt_ptr->parent_guid, tt_ptr->parent);
+    }
+    critical_path_task& task = find_task(tt_ptr->guid, tt_ptr);
+    task.work += elapsed;
+    task.nested = nested;
+    task.complete = true;
+    if (task.outstanding == 0) {
+        finish_task(tt_ptr->guid);
+    }
+}
+
+/* The task and all of its children are done, so its chain is final. Hand
+ * it to the parent, and keep going up the tree while the parents are done,
+ * too.  Call with the lock held. */
+void critical_path_listener::finish_task(uint64_t guid) {
+    while (true) {
+        auto it = _tasks.find(guid);
+        if (it == _tasks.end()) { return; }
+        critical_path_task& task = it->second;
+        uint64_t own = task.work > task.nested_work ?
+            task.work - task.nested_work : 0;
+        uint64_t span = own + task.nested_span + task.async_span;
+        _total_work += own;
+        std::shared_ptr<critical_path_chain> chain =
+            std::make_shared<critical_path_chain>(task.nested_chain);
+        if (task.async_chain != nullptr) {
+            for (auto &c : *(task.async_chain)) {
+                add_to_chain(*chain, c.first, c.second);
+            }
+        }
+        add_to_chain(*chain, task.id, own);
+        uint64_t parent_guid = task.parent_guid;
+        uint64_t work = task.work;
+        bool counted = task.counted;
+        bool nested = task.nested;
+        _tasks.erase(it);
+        auto parent_it = _tasks.find(parent_guid);
+        if (parent_guid == 0 || parent_it == _tasks.end()) {
+            // a top level task
+            if (span > _critical_path) {
+                _critical_path = span;
+                _critical_chain = chain;
+            }
+            return;
+        }
+        critical_path_task& parent = parent_it->second;
+        if (nested) {
+            // nested children ran one after another
+            parent.nested_work += work;
+            parent.nested_span += span;
+            for (auto &c : *chain) {
+                add_to_chain(parent.nested_chain, c.first, c.second);
+            }
+        } else if (span > parent.async_span) {
+            // asynchronous children overlap, keep the longest
+            parent.async_span = span;
+            parent.async_chain = chain;
+        }
+        if (counted && parent.outstanding > 0) {
+            parent.outstanding--;
+        }
+        if (!parent.complete || parent.outstanding > 0) { return; }
+        guid = parent_guid;
+    }
+}
+
+std::string critical_path_listener::report(void) {
+    uint64_t total_work;
+    uint64_t critical_path;
+    std::shared_ptr<const critical_path_chain> chain;
+    {
+        std::unique_lock<std::mutex> l(_mutex);
+        total_work = _total_work;
+        critical_path = _critical_path;
+        chain = _critical_chain;
+    }
+    // every thread has its own task_identifiers, so merge them by name
+    std::unordered_map<std::string, uint64_t> by_name;
+    if (chain != nullptr) {
+        for (auto &c : *chain) {
+            by_name[c.first->get_name()] += c.second;
+        }
+    }
+    std::vector<std::pair<std::string, uint64_t> > sorted(by_name.begin(),
+        by_name.end());
+    std::sort(sorted.begin(), sorted.end(),
+        [](const std::pair<std::string, uint64_t> &a,
+           const std::pair<std::string, uint64_t> &b) {
+            return a.second > b.second;
+        });
+    std::stringstream ss;
+    char line[256];
+    ss << "Critical path analysis:" << std::endl;
+    snprintf(line, sizeof(line), "%52s : %.6f seconds\n",
+        "Critical path length", critical_path * 1.0e-9);
+    ss << line;
+    snprintf(line, sizeof(line), "%52s : %.6f seconds\n",
+        "Total work", total_work * 1.0e-9);
+    ss << line;
+    if (critical_path > 0) {
+        snprintf(line, sizeof(line), "%52s : %.2f\n",
+            "Available parallelism", (double)total_work / critical_path);
+    } else {
+        snprintf(line, sizeof(line), "%52s : n/a\n",
+            "Available parallelism");
+    }
+    ss << line;
+    if (sorted.size() > 0) {
+        ss << "Task types on the critical path:" << std::endl;
+    }
+    size_t count = 0;
+    for (auto &s : sorted) {
+        if (count++ == APEX_CRITICAL_PATH_TOP_TASKS) { break; }
+        snprintf(line, sizeof(line), "%52.52s : %.6f seconds, %5.1f%%\n",
+            s.first.c_str(), s.second * 1.0e-9, critical_path > 0 ?
+            100.0 * s.second / critical_path : 0.0);
+        ss << line;
+    }
+    return ss.str();
+}
+
+void critical_path_listener::on_dump(dump_event_data &data) {
+    std::string output(report());
+    if (apex_options::use_screen_output() && _node_id == 0) {
+        std::cout << output;
+    }
+    data.output += output;
+    std::stringstream filename;
+    filename << apex_options::output_file_path() << filesystem_separator()
+             << "apex_critical_path." << _node_id << ".txt";
+    std::ofstream out(filename.str());
+    out << output;
+    out.close();
+    if (data.reset) {
+        std::unique_lock<std::mutex> l(_mutex);
+        _total_work = 0;
+        _critical_path = 0;
+        _critical_chain = nullptr;
+    }
+}
+
+}
+
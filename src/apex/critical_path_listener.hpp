@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2014-2021 Kevin Huck
+ * Copyright (c) 2014-2021 University of Oregon
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+
+/* The critical path listener (APEX_CRITICAL_PATH) follows the parent/child
+ * relationships between tasks as they complete, and keeps the longest
+ * chain of work through the task tree.  Children are treated as
+ * dependencies of their parent: a child that ran nested inside its parent
+ * on the same thread adds to the parent's chain, while children that ran
+ * asynchronously overlap, so only the longest of them counts.  At dump
+ * time it reports the length of the critical path, the task types on it,
+ * and the available parallelism (total work / critical path length).
+ */
+
+#include "event_listener.hpp"
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace apex {
+
+/* The time each task type contributes to a chain. Only a handful of
+ * task types are ever on one chain, so a vector is enough. */
+typedef std::vector<std::pair<task_identifier*, uint64_t> > critical_path_chain;
+
+class critical_path_task {
+public:
+    task_identifier * id;
+    uint64_t parent_guid;
+    uint64_t work;           // time spent in this task, including nested children
+    uint64_t nested_work;    // time spent in children nested in this task
+    uint64_t nested_span;    // sum of the nested children's chains
+    uint64_t async_span;     // longest chain of the asynchronous children
+    uint32_t outstanding;    // children started, but not finished
+    bool complete;
+    bool counted;            // included in the parent's outstanding children
+    bool nested;             // ran nested in the parent, on the parent's thread
+    critical_path_chain nested_chain;
+    std::shared_ptr<const critical_path_chain> async_chain;
+    critical_path_task(void) : id(nullptr), parent_guid(0), work(0),
+        nested_work(0), nested_span(0), async_span(0), outstanding(0),
+        complete(false), counted(false), nested(false),
+        async_chain(nullptr) {}
+};
+
+class critical_path_listener : public event_listener {
+private:
+    int _node_id;
+    std::mutex _mutex;
+    /* only the tasks that are running or waiting for children */
+    std::unordered_map<uint64_t, critical_path_task> _tasks;
+    uint64_t _total_work;
+    uint64_t _critical_path;
+    std::shared_ptr<const critical_path_chain> _critical_chain;
+    critical_path_task& find_task(uint64_t guid,
+        std::shared_ptr<task_wrapper> &tt_ptr);
+    void finish_task(uint64_t guid);
+    std::string report(void);
+public:
+    critical_path_listener (void);
+    ~critical_path_listener (void) {};
+    void on_startup(startup_event_data &data);
+    void on_dump(dump_event_data &data);
+    void on_reset(task_identifier * id) { APEX_UNUSED(id); };
+    void on_pre_shutdown(void) {};
+    void on_shutdown(shutdown_event_data &data) { APEX_UNUSED(data); };
+    void on_new_node(node_event_data &data) { APEX_UNUSED(data); };
+    void on_new_thread(new_thread_event_data &data) { APEX_UNUSED(data); };
+    void on_exit_thread(event_data &data) { APEX_UNUSED(data); };
+    bool on_start(std::shared_ptr<task_wrapper> &tt_ptr);
+    void on_stop(std::shared_ptr<profiler> &p) { APEX_UNUSED(p); };
+    void on_yield(std::shared_ptr<profiler> &p);
+    bool on_resume(std::shared_ptr<task_wrapper> &tt_ptr) {
+        APEX_UNUSED(tt_ptr);
+        return true;
+    };
+    void on_task_complete(std::shared_ptr<task_wrapper> &tt_ptr);
+    void on_sample_value(sample_value_event_data &data) { APEX_UNUSED(data); };
+    void on_periodic(periodic_event_data &data) { APEX_UNUSED(data); };
+    void on_custom_event(custom_event_data &data) { APEX_UNUSED(data); };
+    void on_send(message_event_data &data) { APEX_UNUSED(data); };
+    void on_recv(message_event_data &data) { APEX_UNUSED(data); };
+    void set_node_id(int node_id, int node_count) {
+        APEX_UNUSED(node_count);
+        _node_id = node_id;
+    }
+    void set_metadata(const char * name, const char * value) {
+        APEX_UNUSED(name);
+        APEX_UNUSED(value);
+    };
+};
+
+}
+
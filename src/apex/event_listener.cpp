@@ -46,17 +46,31 @@ node_event_data::node_event_data(int node_id, int thread_id) {
 }
 
 sample_value_event_data::sample_value_event_data(int thread_id,
-    string counter_name, double counter_value, bool threaded) {
+    const string &counter_name, double counter_value, bool threaded) {
   this->event_type_ = APEX_SAMPLE_VALUE;
   this->is_counter = true;
   this->thread_id = thread_id;
   this->counter_name = new string(counter_name);
   this->counter_value = counter_value;
   this->is_threaded = threaded;
+  this->counter_id = nullptr;
+}
+
+sample_value_event_data::sample_value_event_data(int thread_id,
+    task_identifier * counter_id, double counter_value, bool threaded) {
+  this->event_type_ = APEX_SAMPLE_VALUE;
+  this->is_counter = true;
+  this->thread_id = thread_id;
+  this->counter_name = &(counter_id->name);
+  this->counter_value = counter_value;
+  this->is_threaded = threaded;
+  this->counter_id = counter_id;
 }
 
 sample_value_event_data::~sample_value_event_data() {
-  delete(counter_name);
+  if (counter_id == nullptr) {
+    delete(counter_name);
+  }
 }
 
 custom_event_data::custom_event_data(apex_event_type event_type,
@@ -65,7 +65,11 @@ public:
   double counter_value;
   bool is_threaded;
   bool is_counter;
-  sample_value_event_data(int thread_id, std::string counter_name, double counter_value, bool threaded);
+  /* set when the sample came through a counter handle */
+  task_identifier * counter_id;
+  sample_value_event_data(int thread_id, const std::string &counter_name, double counter_value, bool threaded);
+  /* Doesn't copy the name, the task_identifier outlives the event. */
+  sample_value_event_data(int thread_id, task_identifier * counter_id, double counter_value, bool threaded);
   ~sample_value_event_data();
 };
 
@@ -113,6 +117,9 @@ public:
 class event_listener
 {
 public:
+  // set for the tracing listeners when APEX_TRACE_WINDOWS is on, so that
+  // they are only sent events inside a trace window
+  bool in_trace_windows = false;
   // virtual destructor
   virtual ~event_listener() {};
   // all methods in the interface that a handler has to override
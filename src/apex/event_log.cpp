@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2014-2021 Kevin Huck
+ * Copyright (c) 2014-2021 University of Oregon
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include "event_log.hpp"
+#include <stdio.h>
+#include <string.h>
+
+namespace apex {
+
+event_log_reader::event_log_reader(const std::string &filename) :
+    _error("") {
+    FILE * f = fopen(filename.c_str(), "rb");
+    if (f == nullptr) {
+        _error = "could not open " + filename;
+        return;
+    }
+    event_log_header header;
+    if (fread(&header, sizeof(header), 1, f) != 1 ||
+        memcmp(header.magic, event_log_magic, sizeof(header.magic)) != 0) {
+        _error = filename + " is not an event log";
+        fclose(f);
+        return;
+    }
+    if (header.version != event_log_version) {
+        _error = filename + " has an unsupported version";
+        fclose(f);
+        return;
+    }
+    event_log_block block;
+    while (fread(&block, sizeof(block), 1, f) == 1) {
+        if (block.type == event_log_block_type::NAMES) {
+            for (uint32_t i = 0 ; i < block.count ; i++) {
+                uint32_t index, length;
+                if (fread(&index, sizeof(index), 1, f) != 1 ||
+                    fread(&length, sizeof(length), 1, f) != 1) {
+                    _error = filename + " is truncated";
+                    break;
+                }
+                std::string name(length, '\0');
+                if (length > 0 && fread(&name[0], 1, length, f) != length) {
+                    _error = filename + " is truncated";
+                    break;
+                }
+                if (index >= names.size()) { names.resize(index + 1); }
+                names[index] = name;
+            }
+        } else if (block.type == event_log_block_type::EVENTS) {
+            size_t start = events.size();
+            events.resize(start + block.count);
+            if (fread(&events[start], sizeof(recorded_event), block.count,
+                f) != block.count) {
+                _error = filename + " is truncated";
+                events.resize(start);
+            }
+        } else {
+            _error = filename + " has a bad block";
+        }
+        if (!ok()) { break; }
+    }
+    fclose(f);
+    // don't trust names from a damaged file
+    for (auto &e : events) {
+        if (e.type != recorded_event_type::SEND &&
+            e.type != recorded_event_type::RECV && e.name >= names.size()) {
+            _error = filename + " has a bad event";
+            events.clear();
+            break;
+        }
+    }
+}
+
+}
+
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2014-2021 Kevin Huck
+ * Copyright (c) 2014-2021 University of Oregon
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+
+/* The binary event log written with APEX_RECORD_EVENTS, and read by the
+ * apex_replay utility.  The file is a header followed by blocks, each
+ * starting with an event_log_block.  A NAMES block has one entry per new
+ * name: the name id, its length, then the name without a terminating zero.
+ * An EVENTS block is an array of recorded_event.  Every thread writes its
+ * events in blocks, in the order they happened on that thread, and a name
+ * is always written before the first event that uses it.
+ */
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace apex {
+
+static const char event_log_magic[8] = {'A','P','E','X','E','V','T','\0'};
+static const uint32_t event_log_version = 1;
+
+struct event_log_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t node_id;
+};
+
+enum class event_log_block_type : uint32_t {
+    NAMES,
+    EVENTS
+};
+
+struct event_log_block {
+    event_log_block_type type;
+    uint32_t count;
+};
+
+enum class recorded_event_type : uint32_t {
+    START,
+    RESUME,
+    STOP,
+    YIELD,
+    SAMPLE,
+    SEND,
+    RECV
+};
+
+struct recorded_event {
+    uint64_t timestamp;
+    uint64_t guid;         // the tag, for messages
+    uint64_t parent_guid;  // the size, for messages
+    union {
+        double value;      // samples
+        uint64_t rank;     // the target of a send, the source of a recv
+    };
+    uint32_t thread;
+    uint32_t name;         // the source thread, for a recv
+    recorded_event_type type;
+    uint32_t padding;
+};
+
+class event_log_reader {
+private:
+    std::string _error;
+public:
+    std::vector<std::string> names;
+    std::vector<recorded_event> events;
+    event_log_reader(const std::string &filename);
+    bool ok(void) { return _error.size() == 0; }
+    const std::string& error(void) { return _error; }
+};
+
+}
+
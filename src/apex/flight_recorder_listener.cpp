@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2014-2021 Kevin Huck
+ * Copyright (c) 2014-2021 University of Oregon
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include "flight_recorder_listener.hpp"
+#include "thread_instance.hpp"
+#include "apex_options.hpp"
+#include "profiler.hpp"
+#include "task_wrapper.hpp"
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <atomic>
+#include <string>
+
+namespace apex {
+
+flight_recorder_listener * flight_recorder_listener::_instance(nullptr);
+
+flight_buffer::flight_buffer(size_t capacity, uint64_t tid) :
+    head(0), thread_id(tid) {
+    // round up to a power of 2, so the index is just a mask
+    size_t size = 1;
+    while (size < capacity) { size = size << 1; }
+    events = new flight_event[size];
+    memset(events, 0, size * sizeof(flight_event));
+    mask = size - 1;
+}
+
+flight_recorder_listener::flight_recorder_listener (void) :
+    _terminate(false), _node_id(0), _dumps(0), _dump_requested(false),
+    _dump_thread(nullptr) {
+    _instance = this;
+    _dump_thread = new std::thread(&flight_recorder_listener::dump_thread,
+        this);
+    struct sigaction act;
+    memset(&act, 0, sizeof(act));
+    sigemptyset(&act.sa_mask);
+    act.sa_flags = SA_RESTART;
+    act.sa_handler = flight_recorder_listener::sigusr2_handler;
+    sigaction(SIGUSR2, &act, nullptr);
+}
+
+flight_recorder_listener::~flight_recorder_listener (void) {
+    stop_dump_thread();
+    _instance = nullptr;
+    // the buffers are not freed, threads may still be recording
+}
+
+/* Only async-signal-safe things in here: set a flag and post to the
+ * dump thread, which does the writing. */
+void flight_recorder_listener::sigusr2_handler(int sig) {
+    APEX_UNUSED(sig);
+    flight_recorder_listener * instance = _instance;
+    if (instance == nullptr) { return; }
+    instance->_dump_requested = true;
+    instance->_dump_signal.post();
+}
+
+void flight_recorder_listener::dump_thread(void) {
+    while (true) {
+        _dump_signal.wait();
+        if (_terminate) { break; }
+        if (_dump_requested.exchange(false)) {
+            write_trace(false);
+        }
+    }
+}
+
+bool flight_recorder_listener::dump(void) {
+    flight_recorder_listener * instance = _instance;
+    if (instance == nullptr) { return false; }
+    return instance->write_trace(false);
+}
+
+void flight_recorder_listener::dump_after_fatal_signal(void) {
+    flight_recorder_listener * instance = _instance;
+    if (instance == nullptr) { return; }
+    instance->write_trace(true);
+}
+
+flight_buffer * flight_recorder_listener::my_buffer(void) {
+    static APEX_NATIVE_TLS flight_buffer * mine = nullptr;
+    if (mine == nullptr) {
+        mine = new flight_buffer(apex_options::flight_recorder_size(),
+            thread_instance::get_id());
+        std::unique_lock<std::mutex> l(_buffers_mutex);
+        _buffers.push_back(mine);
+    }
+    return mine;
+}
+
+void flight_recorder_listener::on_startup(startup_event_data &data) {
+    _node_id = (int)data.comm_rank;
+}
+
+void flight_recorder_listener::on_shutdown(shutdown_event_data &data) {
+    APEX_UNUSED(data);
+    stop_dump_thread();
+}
+
+void flight_recorder_listener::stop_dump_thread(void) {
+    if (_terminate) { return; }
+    _terminate = true;
+    if (_dump_thread != nullptr) {
+        _dump_signal.post();
+        _dump_thread->join();
+        delete _dump_thread;
+        _dump_thread = nullptr;
+    }
+}
+
+bool flight_recorder_listener::on_start(std::shared_ptr<task_wrapper> &tt_ptr) {
+    if (!_terminate) {
+        // the profiler_listener has already taken the start time
+        uint64_t stamp = tt_ptr->prof != nullptr ?
+            tt_ptr->prof->get_start_ns() : profiler::now_ns();
+        my_buffer()->record(stamp, tt_ptr->get_task_id(),
+            flight_event_type::START);
+    }
+    return true;
+}
+
+bool flight_recorder_listener::on_resume(std::shared_ptr<task_wrapper> &tt_ptr) {
+    return on_start(tt_ptr);
+}
+
+void flight_recorder_listener::on_stop(std::shared_ptr<profiler> &p) {
+    if (!_terminate) {
+        my_buffer()->record(p->get_stop_ns(), p->get_task_id(),
+            flight_event_type::STOP);
+    }
+}
+
+void flight_recorder_listener::on_yield(std::shared_ptr<profiler> &p) {
+    on_stop(p);
+}
+
+void flight_recorder_listener::on_sample_value(sample_value_event_data &data) {
+    if (!_terminate) {
+        task_identifier * id = data.counter_id;
+        if (id == nullptr) {
+            id = task_identifier::get_task_id(*(data.counter_name));
+        }
+        my_buffer()->record(profiler::now_ns(), id,
+            flight_event_type::COUNTER, data.counter_value);
+    }
+}
+
+/* After a fatal signal, don't risk allocating memory or resolving
+ * addresses - write what we have. */
+static void write_name(FILE * f, task_identifier * id,
+    bool after_fatal_signal) {
+    if (after_fatal_signal) {
+        if (id->has_name) {
+            fputs(id->name.c_str(), f);
+        } else {
+            fprintf(f, "UNRESOLVED ADDR 0x%" PRIx64, (uint64_t)(id->address));
+        }
+    } else {
+        fputs(id->get_name().c_str(), f);
+    }
+}
+
+bool flight_recorder_listener::write_trace(bool after_fatal_signal) {
+    std::unique_lock<std::mutex> dump_lock(_dump_mutex, std::defer_lock);
+    std::unique_lock<std::mutex> buffers_lock(_buffers_mutex, std::defer_lock);
+    if (after_fatal_signal) {
+        /* the crashing thread may be holding these.  Without the buffers
+         * lock, a thread could be adding a buffer, so don't dump at all. */
+        if (!dump_lock.try_lock()) { return false; }
+        if (!buffers_lock.try_lock()) { return false; }
+    } else {
+        dump_lock.lock();
+        buffers_lock.lock();
+    }
+    char filename[4096];
+    snprintf(filename, sizeof(filename), "%s/apex_flight_recorder.%d.%d.json",
+        apex_options::output_file_path(), _node_id, _dumps++);
+    FILE * f = fopen(filename, "w");
+    if (f == nullptr) {
+        perror("opening flight recorder trace");
+        return false;
+    }
+    fprintf(f, "{\n\"displayTimeUnit\": \"ms\",\n\"traceEvents\": [\n");
+    fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d"
+        ",\"args\":{\"name\":\"Process %d\"}}", _node_id, _node_id);
+    for (auto buffer : _buffers) {
+        uint64_t tid = buffer->thread_id;
+        fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d"
+            ",\"tid\":%" PRIu64 ",\"args\":{\"name\":\"CPU Thread %" PRIu64
+            "\"}}", _node_id, tid, tid);
+        uint64_t capacity = buffer->mask + 1;
+        uint64_t end = buffer->head.load(std::memory_order_acquire);
+        uint64_t index = end > capacity ? end - capacity : 0;
+        // a stop without its start was overwritten, leave it out
+        int depth = 0;
+        for ( ; index < end ; index++) {
+            flight_event e = buffer->events[index & buffer->mask];
+            /* was this one overwritten while we were reading it?  The fence
+             * keeps the copy from moving after the load of the head. */
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint64_t now = buffer->head.load(std::memory_order_acquire);
+            if (now - index >= capacity) { depth = 0; continue; }
+            if (e.id == nullptr) { continue; }
+            double stamp = e.timestamp * 1.0e-3;
+            switch (e.type) {
+                case flight_event_type::START:
+                    depth++;
+                    fprintf(f, ",\n{\"name\":\"");
+                    write_name(f, e.id, after_fatal_signal);
+                    fprintf(f, "\",\"ph\":\"B\",\"pid\":%d,\"tid\":%" PRIu64
+                        ",\"ts\":%.3f}", _node_id, tid, stamp);
+                    break;
+                case flight_event_type::STOP:
+                    if (depth == 0) { break; }
+                    depth--;
+                    fprintf(f, ",\n{\"name\":\"");
+                    write_name(f, e.id, after_fatal_signal);
+                    fprintf(f, "\",\"ph\":\"E\",\"pid\":%d,\"tid\":%" PRIu64
+                        ",\"ts\":%.3f}", _node_id, tid, stamp);
+                    break;
+                case flight_event_type::COUNTER:
+                    fprintf(f, ",\n{\"name\":\"");
+                    write_name(f, e.id, after_fatal_signal);
+                    fprintf(f, "\",\"ph\":\"C\",\"pid\":%d,\"ts\":%.3f"
+                        ",\"args\":{\"value\":%f}}", _node_id, stamp, e.value);
+                    break;
+            }
+        }
+    }
+    fprintf(f, "\n]\n}\n");
+    fclose(f);
+    if (apex_options::use_verbose() || after_fatal_signal) {
+        fprintf(stderr, "APEX: flight recorder written to %s\n", filename);
+    }
+    return true;
+}
+
+}
+
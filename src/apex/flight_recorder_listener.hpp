@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2014-2021 Kevin Huck
+ * Copyright (c) 2014-2021 University of Oregon
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+
+/* The flight recorder (APEX_FLIGHT_RECORDER) keeps the most recent
+ * APEX_FLIGHT_RECORDER_SIZE events of every thread in a circular buffer,
+ * overwriting the oldest ones.  Nothing is written until a dump is
+ * requested, either with SIGUSR2, with apex::dump_flight_recorder() (from
+ * a policy, for example), or when APEX catches a fatal signal.  Each dump
+ * writes a Chrome trace, apex_flight_recorder.<node>.<n>.json.
+ */
+
+#include "event_listener.hpp"
+#include "semaphore.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace apex {
+
+enum class flight_event_type : uint32_t {
+    START,
+    STOP,
+    COUNTER
+};
+
+struct flight_event {
+    uint64_t timestamp;
+    double value; // counters only
+    task_identifier * id;
+    flight_event_type type;
+    uint32_t padding;
+};
+
+/* Only the owning thread writes to a buffer.  A dump copies the events
+ * and then checks head again, to throw away any that were overwritten
+ * while it was reading. */
+class flight_buffer {
+public:
+    flight_event * events;
+    uint64_t mask;
+    std::atomic<uint64_t> head;
+    uint64_t thread_id;
+    flight_buffer(size_t capacity, uint64_t tid);
+    void record(uint64_t timestamp, task_identifier * id,
+        flight_event_type type, double value = 0.0) {
+        uint64_t index = head.load(std::memory_order_relaxed);
+        flight_event& e = events[index & mask];
+        /* a reader that sees the new event has to see the head that made
+         * this slot reusable, too */
+        std::atomic_thread_fence(std::memory_order_release);
+        e.timestamp = timestamp;
+        e.value = value;
+        e.id = id;
+        e.type = type;
+        head.store(index + 1, std::memory_order_release);
+    }
+};
+
+class flight_recorder_listener : public event_listener {
+private:
+    bool _terminate;
+    int _node_id;
+    std::atomic<int> _dumps;
+    std::atomic<bool> _dump_requested;
+    std::mutex _dump_mutex;
+    std::mutex _buffers_mutex;
+    std::vector<flight_buffer*> _buffers;
+    semaphore _dump_signal;
+    std::thread * _dump_thread;
+    static flight_recorder_listener * _instance;
+    flight_buffer * my_buffer(void);
+    void dump_thread(void);
+    void stop_dump_thread(void);
+    static void sigusr2_handler(int sig);
+    bool write_trace(bool after_fatal_signal);
+public:
+    flight_recorder_listener (void);
+    ~flight_recorder_listener (void);
+    /* write the buffers now, returns false if there is no flight recorder */
+    static bool dump(void);
+    /* called by the fatal signal handler: don't resolve any addresses,
+     * and don't wait for a dump that is already running */
+    static void dump_after_fatal_signal(void);
+    void on_startup(startup_event_data &data);
+    void on_dump(dump_event_data &data) { APEX_UNUSED(data); };
+    void on_reset(task_identifier * id) { APEX_UNUSED(id); };
+    void on_pre_shutdown(void) {};
+    void on_shutdown(shutdown_event_data &data);
+    void on_new_node(node_event_data &data) { APEX_UNUSED(data); };
+    void on_new_thread(new_thread_event_data &data) { APEX_UNUSED(data); };
+    void on_exit_thread(event_data &data) { APEX_UNUSED(data); };
+    bool on_start(std::shared_ptr<task_wrapper> &tt_ptr);
+    void on_stop(std::shared_ptr<profiler> &p);
+    void on_yield(std::shared_ptr<profiler> &p);
+    bool on_resume(std::shared_ptr<task_wrapper> &tt_ptr);
+    void on_task_complete(std::shared_ptr<task_wrapper> &tt_ptr) {
+        APEX_UNUSED(tt_ptr);
+    };
+    void on_sample_value(sample_value_event_data &data);
+    void on_periodic(periodic_event_data &data) { APEX_UNUSED(data); };
+    void on_custom_event(custom_event_data &data) { APEX_UNUSED(data); };
+    void on_send(message_event_data &data) { APEX_UNUSED(data); };
+    void on_recv(message_event_data &data) { APEX_UNUSED(data); };
+    void set_node_id(int node_id, int node_count) {
+        APEX_UNUSED(node_count);
+        _node_id = node_id;
+    }
+    void set_metadata(const char * name, const char * value) {
+        APEX_UNUSED(name);
+        APEX_UNUSED(value);
+    };
+};
+
+}
+
@@ -101,8 +101,8 @@ public:
       _handler_initialized(false),
       _terminate(false)
     { }
-  void cancel(void) {
-      _terminate = true;
+  /* Stops the timer thread, but the handler keeps running */
+  void stop_timer(void) {
       if(_timer_thread != nullptr) {
 #if defined(_MSC_VER) || defined(__APPLE__)
         cv.notify_all();
@@ -114,6 +114,10 @@ public:
         _timer_thread = nullptr;
       }
   }
+  void cancel(void) {
+      _terminate = true;
+      stop_timer();
+  }
   // virtual destructor
   virtual ~handler() {
       cancel();
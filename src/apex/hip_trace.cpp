@@ -531,13 +531,15 @@ void store_profiler_data(const std::string &name, uint32_t correlationId,
     // fake out the profiler_listener
     instance->the_profiler_listener->push_profiler_public(prof);
     // Handle tracing, if necessary
-    if (apex::apex_options::use_trace_event()) {
+    bool traced = !apex::apex_options::use_trace_windows() ||
+        apex::profiler::in_trace_window(prof->get_start_ns());
+    if (apex::apex_options::use_trace_event() && traced) {
         apex::trace_event_listener * tel =
             (apex::trace_event_listener*)instance->the_trace_event_listener;
         tel->on_async_event(node, prof);
     }
 #ifdef APEX_HAVE_OTF2
-    if (apex::apex_options::use_otf2() && otf2_trace) {
+    if (apex::apex_options::use_otf2() && otf2_trace && traced) {
         apex::otf2_listener * tol =
             (apex::otf2_listener*)instance->the_otf2_listener;
         tol->on_async_event(node, prof);
@@ -570,13 +572,15 @@ void store_counter_data(const char * name, const std::string& ctx,
     // fake out the profiler_listener
     instance->the_profiler_listener->push_profiler_public(prof);
     // Handle tracing, if necessary
-    if (apex::apex_options::use_trace_event()) {
+    bool traced = !apex::apex_options::use_trace_windows() ||
+        apex::profiler::in_trace_window(prof->get_stop_ns());
+    if (apex::apex_options::use_trace_event() && traced) {
         apex::trace_event_listener * tel =
             (apex::trace_event_listener*)instance->the_trace_event_listener;
         tel->on_async_metric(node, prof);
     }
 #ifdef APEX_HAVE_OTF2
-    if (apex::apex_options::use_otf2()) {
+    if (apex::apex_options::use_otf2() && traced) {
         apex::otf2_listener * tol =
             (apex::otf2_listener*)instance->the_otf2_listener;
         tol->on_async_metric(node, prof);
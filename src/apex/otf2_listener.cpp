@@ -422,10 +422,10 @@ namespace apex {
         my_node_id = (my_node_id << 32) + _event_threads.size();
         evt_writer = OTF2_Archive_GetEvtWriter( archive, my_node_id );
         //if (thread_instance::get_id() == 0) {
-        // If this is the first thread, make it the comm_evt_writer
+        // If this is the first thread, make it the communication location
         // (assume it is the master thread)
-        if (comm_evt_writer == nullptr) {
-            comm_evt_writer = evt_writer;
+        if (_comm.writer == nullptr) {
+            _comm.writer = evt_writer;
         }
         //_event_threads.insert(thread_instance::get_id());
         //std::cout << "CPU Inserting " << _event_threads.size() << std::endl;
@@ -439,8 +439,9 @@ namespace apex {
       // Are we closing an event writer?
       } else if (!create) {
         //if (thread_instance::get_id() == 0) {
-        if (evt_writer == comm_evt_writer) {
-            comm_evt_writer = nullptr;
+        if (evt_writer == _comm.writer) {
+            std::unique_lock<std::mutex> l(_comm.lock);
+            _comm.writer = nullptr;
         }
         if (evt_writer != nullptr) {
             //printf("closing event writer %p for thread %lu\n", evt_writer,
@@ -456,6 +457,40 @@ namespace apex {
       return evt_writer;
     }
 
+    /* Each thread reuses one attribute list, rather than allocating
+     * and freeing one for every event. */
+    OTF2_AttributeList* otf2_listener::get_attribute_list(bool create) {
+      static APEX_NATIVE_TLS OTF2_AttributeList* al(nullptr);
+      if (create) {
+        if (al == nullptr) {
+            al = OTF2_AttributeList_New();
+        } else {
+            OTF2_AttributeList_RemoveAllAttributes(al);
+        }
+      } else if (al != nullptr) {
+        OTF2_AttributeList_Delete(al);
+        al = nullptr;
+      }
+      return al;
+    }
+
+    /* The virtual location for samples taken by APEX's own threads
+     * (proc_read, policies...), created the first time it's needed.
+     * Call with _samplers.lock held. */
+    OTF2_EvtWriter* otf2_listener::get_samplers_writer(void) {
+      if (_samplers.writer == nullptr) {
+        std::unique_lock<std::mutex> l(_event_set_mutex);
+        size_t tmpid = _event_threads.size();
+        uint64_t my_node_id = my_saved_node_id;
+        my_node_id = (my_node_id << 32) + tmpid;
+        _samplers.writer = OTF2_Archive_GetEvtWriter( archive, my_node_id );
+        _event_threads.insert(tmpid);
+        _event_thread_names.insert(std::pair<uint32_t, std::string>(tmpid,
+            "APEX samplers"));
+      }
+      return _samplers.writer;
+    }
+
     bool otf2_listener::event_file_exists (uint32_t threadid) {
         // get exclusive access to the set - unlocks on exit
         std::unique_lock<std::mutex> l(_event_set_mutex);
@@ -475,7 +510,7 @@ namespace apex {
 
     /* constructor for the OTF2 listener class */
     otf2_listener::otf2_listener (void) : _terminate(false),
-        _initialized(false), comm_evt_writer(nullptr),
+        _initialized(false),
         global_def_writer(nullptr), dropped(0) {
         /* set the flusher */
         flush_callbacks.otf2_pre_flush  = otf2_listener::pre_flush;
@@ -1153,6 +1188,7 @@ namespace apex {
 #endif
         //_event_threads.insert(thread_instance::get_id());
         getEvtWriter(false);
+        get_attribute_list(false);
         APEX_UNUSED(data);
         return;
     }
@@ -1186,6 +1222,8 @@ namespace apex {
         // This could be a callback from a library before APEX is ready
         // Something like OpenMP or CUDA/CUPTI or...?
         if (!_initialized) return false;
+        // take the timestamp first, before waiting on any locks
+        uint64_t stamp = get_time();
         task_identifier * id = tt_ptr->get_task_id();
         // don't close the archive on us!
         read_lock_type lock(_archive_mutex);
@@ -1194,23 +1232,17 @@ namespace apex {
         // before we process the event, make sure the event write is open
         OTF2_EvtWriter* local_evt_writer = getEvtWriter(true);
         if (local_evt_writer != nullptr) {
-            // create an attribute list
-            OTF2_AttributeList * al = OTF2_AttributeList_New();
+            OTF2_AttributeList * al = get_attribute_list(true);
             // create an attribute
             OTF2_AttributeList_AddUint64( al, 0, tt_ptr->guid );
             OTF2_AttributeList_AddUint64( al, 1, tt_ptr->parent_guid );
             uint64_t idx = get_region_index(id);
-            uint64_t stamp = 0L;
-            if (thread_instance::get_id() == 0) {
+            if (local_evt_writer == _comm.writer) {
                 // Because the event writer for thread 0 is also
-                // used for communication events and sampled values,
-                // we have to get a lock for it.
-                std::unique_lock<std::mutex> lock(_comm_mutex);
-                // unfortunately, we can't use the timestamp from the
-                // profiler object. bummer. it has to be taken after
-                // the lock is acquired, so that events happen on
-                // thread 0 in monotonic order.
-                stamp = get_time();
+                // used for communication events, we have to get a
+                // lock for it.
+                std::unique_lock<std::mutex> lock(_comm.lock);
+                stamp = _comm.in_order(stamp);
                 OTF2_EC(OTF2_EvtWriter_Enter( local_evt_writer, al,
                     stamp, idx /* region */ ));
 #if APEX_HAVE_PAPI
@@ -1219,7 +1251,6 @@ namespace apex {
                     stamp, true);
 #endif
             } else {
-                stamp = get_time();
                 OTF2_EC(OTF2_EvtWriter_Enter( local_evt_writer, al,
                     stamp, idx /* region */ ));
 #if APEX_HAVE_PAPI
@@ -1228,8 +1259,6 @@ namespace apex {
                     stamp, true);
 #endif
             }
-            // delete the attribute list
-            OTF2_AttributeList_Delete(al);
             return true;
         }
         return false;
@@ -1243,29 +1272,25 @@ namespace apex {
         // This could be a callback from a library before APEX is ready
         // Something like OpenMP or CUDA/CUPTI or...?
         if (!_initialized) return ;
+        // take the timestamp first, before waiting on any locks
+        uint64_t stamp = get_time();
         // don't close the archive on us!
         read_lock_type lock(_archive_mutex);
         OTF2_EvtWriter* local_evt_writer = getEvtWriter(true);
         if (local_evt_writer != nullptr) {
             // not likely, but just in case...
             if (_terminate) { return; }
-            // create an attribute list
-            OTF2_AttributeList * al = OTF2_AttributeList_New();
+            OTF2_AttributeList * al = get_attribute_list(true);
             // create an attribute
             OTF2_AttributeList_AddUint64( al, 0, p->tt_ptr->guid );
             OTF2_AttributeList_AddUint64( al, 1, p->tt_ptr->parent_guid );
-            // unfortunately, we can't use the timestamp from the
-            // profiler object. bummer. it has to be taken after
-            // the lock is acquired, so that events happen on
-            // thread 0 in monotonic order.
-            uint64_t stamp = 0L;
             uint64_t idx = get_region_index(p->get_task_id());
-            if (thread_instance::get_id() == 0) {
+            if (local_evt_writer == _comm.writer) {
                 // Because the event writer for thread 0 is also
-                // used for communication events and sampled values,
-                // we have to get a lock for it.
-                std::unique_lock<std::mutex> lock(_comm_mutex);
-                stamp = get_time();
+                // used for communication events, we have to get a
+                // lock for it.
+                std::unique_lock<std::mutex> lock(_comm.lock);
+                stamp = _comm.in_order(stamp);
                 OTF2_EC(OTF2_EvtWriter_Leave( local_evt_writer, al,
                     stamp, idx /* region */ ));
 #if APEX_HAVE_PAPI
@@ -1274,7 +1299,6 @@ namespace apex {
                     stamp, false);
 #endif
             } else {
-                stamp = get_time();
                 OTF2_EC(OTF2_EvtWriter_Leave( local_evt_writer, al,
                     stamp, idx /* region */ ));
 #if APEX_HAVE_PAPI
@@ -1283,8 +1307,6 @@ namespace apex {
                     stamp, false);
 #endif
             }
-            // delete the attribute list
-            OTF2_AttributeList_Delete(al);
         }
         return;
     }
@@ -1295,28 +1317,22 @@ namespace apex {
 
     /* The send is always assumed to be done by thread 0 */
     void otf2_listener::on_send(message_event_data &data) {
+        // take the timestamp first, before waiting on any locks
+        uint64_t stamp = get_time();
         // don't close the archive on us!
         read_lock_type lock(_archive_mutex);
         // not likely, but just in case...
         if (_terminate) { return; }
-        if (comm_evt_writer != nullptr) {
-            // create an empty attribute list. could be null?
-            OTF2_AttributeList * attributeList = OTF2_AttributeList_New();
-            // only one communicator, so hard coded.
-            OTF2_CommRef communicator = 0;
-            {
-                // because we are writing to thread 0's event stream,
-                // set the lock
-                std::unique_lock<std::mutex> lock(_comm_mutex);
-                // we have to get a timestamp after the lock, to make sure
-                // that time stamps are monotonically increasing. :(
-                uint64_t stamp = get_time();
-                // write our recv into the event stream
-                OTF2_EC(OTF2_EvtWriter_MpiSend  ( comm_evt_writer,
-                        attributeList, stamp, data.target, communicator,
-                        data.tag, data.size ));
-            }
-            OTF2_EC(OTF2_AttributeList_Delete(attributeList));
+        // only one communicator, so hard coded.
+        OTF2_CommRef communicator = 0;
+        // because we are writing to thread 0's event stream,
+        // set the lock
+        std::unique_lock<std::mutex> comm_lock(_comm.lock);
+        if (_comm.writer != nullptr) {
+            // write our send into the event stream
+            OTF2_EC(OTF2_EvtWriter_MpiSend  ( _comm.writer, nullptr,
+                    _comm.in_order(stamp), data.target, communicator,
+                    data.tag, data.size ));
         }
         return;
     }
@@ -1325,35 +1341,31 @@ namespace apex {
      * because the sender doesnt' know which thread will handle
      * the parcel. But the receiver knows the sending thread. */
     void otf2_listener::on_recv(message_event_data &data) {
+        // take the timestamp first, before waiting on any locks
+        uint64_t stamp = get_time();
         // don't close the archive on us!
         read_lock_type lock(_archive_mutex);
         // not likely, but just in case...
         if (_terminate) { return; }
-        if (comm_evt_writer != nullptr) {
-            // create an empty attribute list. could be null?
-            OTF2_AttributeList * attributeList = OTF2_AttributeList_New();
-            // only one communicator, so hard coded.
-            OTF2_CommRef communicator = 0;
-            {
-                // because we are writing to thread 0's event stream,
-                // set the lock
-                std::unique_lock<std::mutex> lock(_comm_mutex);
-                // we have to get a timestamp after the lock, to make sure
-                // that time stamps are monotonically increasing. :(
-                uint64_t stamp = get_time();
-                // write our recv into the event stream
-                //std::cout << "receiving from: " << data.source_thread <<
-                //std::endl;
-                OTF2_EC(OTF2_EvtWriter_MpiRecv  ( comm_evt_writer,
-                        attributeList, stamp, data.source_rank, communicator,
-                        data.tag, data.size ));
-            }
-            // delete the attribute.
-            OTF2_EC(OTF2_AttributeList_Delete(attributeList));
+        // only one communicator, so hard coded.
+        OTF2_CommRef communicator = 0;
+        // because we are writing to thread 0's event stream,
+        // set the lock
+        std::unique_lock<std::mutex> comm_lock(_comm.lock);
+        if (_comm.writer != nullptr) {
+            // write our recv into the event stream
+            //std::cout << "receiving from: " << data.source_thread <<
+            //std::endl;
+            OTF2_EC(OTF2_EvtWriter_MpiRecv  ( _comm.writer, nullptr,
+                    _comm.in_order(stamp), data.source_rank, communicator,
+                    data.tag, data.size ));
         }
         return;
     }
 
+    /* Samples are written to the location of the thread that took them,
+     * so threads never wait for each other.  Samples from APEX's own
+     * threads go to the shared "APEX samplers" location. */
     void otf2_listener::on_sample_value(sample_value_event_data &data) {
         // This could be an asynchronous sampled counter, may have gotten
         // here before initialization is done.  Wait a sec...hopefully not longer.
@@ -1365,15 +1377,12 @@ namespace apex {
         if (!_initialized) {
             return;
         }
+        // take the timestamp first, before waiting on any locks
+        uint64_t stamp = get_time();
         // don't close the archive on us!
         read_lock_type lock(_archive_mutex);
         // not likely, but just in case...
         if (_terminate) { return; }
-
-        OTF2_EvtWriter* local_evt_writer = comm_evt_writer;
-        if (data.is_threaded) {
-            local_evt_writer = getEvtWriter(true);
-        }
         // create a union for storing the value
         OTF2_MetricValue omv[1];
         omv[0].floating_point = data.counter_value;
@@ -1381,19 +1390,24 @@ namespace apex {
         // tell the union what type this is
         OTF2_Type omt[1];
         omt[0]=OTF2_TYPE_DOUBLE;
-        {
-            uint64_t idx = get_metric_index(*(data.counter_name));
-            // because we are writing to thread 0's event stream,
-            // set the lock
-            std::unique_lock<std::mutex> lock(_comm_mutex);
-            // we have to get a timestamp after the lock, to make sure
-            // that time stamps are monotonically increasing. :(
-            uint64_t stamp = get_time();
-            // write our counter into the event stream
-            if (local_evt_writer != nullptr) {
-                OTF2_EC(OTF2_EvtWriter_Metric( local_evt_writer, nullptr, stamp,
-                idx, 1, omt, omv ));
+        uint64_t idx = get_metric_index(*(data.counter_name));
+        if (!thread_instance::is_worker()) {
+            std::unique_lock<std::mutex> samplers_lock(_samplers.lock);
+            OTF2_EvtWriter* samplers_writer = get_samplers_writer();
+            if (samplers_writer != nullptr) {
+                OTF2_EC(OTF2_EvtWriter_Metric( samplers_writer, nullptr,
+                    _samplers.in_order(stamp), idx, 1, omt, omv ));
             }
+            return;
+        }
+        OTF2_EvtWriter* local_evt_writer = getEvtWriter(true);
+        if (local_evt_writer == _comm.writer) {
+            std::unique_lock<std::mutex> comm_lock(_comm.lock);
+            OTF2_EC(OTF2_EvtWriter_Metric( local_evt_writer, nullptr,
+                _comm.in_order(stamp), idx, 1, omt, omv ));
+        } else if (local_evt_writer != nullptr) {
+            OTF2_EC(OTF2_EvtWriter_Metric( local_evt_writer, nullptr, stamp,
+                idx, 1, omt, omv ));
         }
         return;
     }
@@ -2716,8 +2730,7 @@ namespace apex {
         // before we process the event, make sure the event write is open
         OTF2_EvtWriter* local_evt_writer = vthread_evt_writer_map[tid];
         if (local_evt_writer != nullptr) {
-            // create an attribute list
-            OTF2_AttributeList * al = OTF2_AttributeList_New();
+            OTF2_AttributeList * al = get_attribute_list(true);
             // create an attribute
             OTF2_AttributeList_AddUint64( al, 0, p->tt_ptr->guid );
             OTF2_AttributeList_AddUint64( al, 1, p->tt_ptr->parent_guid );
@@ -2728,8 +2741,6 @@ namespace apex {
                 stamp, idx /* region */ ));
             last_ts[tid] = stamp;
             //last_p[tid] = std::string(p->tt_ptr->task_id->get_name());
-            // delete the attribute list
-            OTF2_AttributeList_Delete(al);
         }
         return;
 
@@ -32,7 +32,6 @@ namespace apex {
         std::mutex _region_mutex;
         std::mutex _string_mutex;
         std::mutex _metric_mutex;
-        std::mutex _comm_mutex;
         std::mutex _event_set_mutex;
         std::set<uint32_t> _event_threads;
         std::map<uint32_t, std::string> _event_thread_names;
@@ -136,9 +135,30 @@ namespace apex {
         static OTF2_FlushCallbacks flush_callbacks;
         void* event_writer(void* arg);
         OTF2_Archive* archive;
-        OTF2_EvtWriter* comm_evt_writer;
+        /* A location that more than one thread writes to.  Timestamps
+         * are taken before the lock, so they are clamped to keep the
+         * events on the location in order. */
+        class shared_location {
+        public:
+            std::mutex lock;
+            OTF2_EvtWriter* writer;
+            uint64_t last_stamp;
+            shared_location() : writer(nullptr), last_stamp(0) {}
+            uint64_t in_order(uint64_t stamp) {
+                if (stamp < last_stamp) { stamp = last_stamp; }
+                last_stamp = stamp;
+                return stamp;
+            }
+        };
+        /* Thread 0's location, which is also the rank's location in the
+         * MPI communicator, so sends and receives are written there. */
+        shared_location _comm;
+        /* Process-wide samples from APEX's own (non-worker) threads. */
+        shared_location _samplers;
+        OTF2_EvtWriter* get_samplers_writer(void);
         //APEX_NATIVE_TLS OTF2_DefWriter* def_writer;
         OTF2_EvtWriter* getEvtWriter(bool create);
+        OTF2_AttributeList* get_attribute_list(bool create);
         bool event_file_exists (uint32_t threadid);
         OTF2_DefWriter* getDefWriter(uint32_t threadid);
         OTF2_GlobalDefWriter* global_def_writer;
@@ -31,22 +31,61 @@
 #include <unistd.h>
 #endif
 #include "tau_listener.hpp"
+#include "thread_instance.hpp"
 
 using namespace std;
 
 namespace apex {
 
-    class policy_manager {
+    /* Readers of the policy tables announce the epoch they started
+     * reading in, each in its own cache line, so the hot path never writes
+     * to memory shared with other threads.  A retired table can be deleted
+     * once every active reader started in a later epoch. */
+    struct alignas(64) reader_epoch {
+        std::atomic<uint64_t> epoch;
+        unsigned int depth;
+        reader_epoch() : epoch(0), depth(0) {}
+    };
+
+    static std::atomic<uint64_t> global_epoch(1);
+
+    static std::mutex& readers_mutex(void) {
+        static std::mutex mtx;
+        return mtx;
+    }
+
+    /* never freed, threads can exit at any time */
+    static std::vector<reader_epoch*>& readers(void) {
+        static std::vector<reader_epoch*> * all =
+            new std::vector<reader_epoch*>();
+        return *all;
+    }
+
+    static reader_epoch& my_epoch(void) {
+        static APEX_NATIVE_TLS reader_epoch * mine = nullptr;
+        if (mine == nullptr) {
+            mine = new reader_epoch();
+            std::unique_lock<std::mutex> l(readers_mutex());
+            readers().push_back(mine);
+        }
+        return *mine;
+    }
+
+    /* Policies can cause events (and more policies) of their own, so only
+     * the outermost section announces the epoch. */
+    class read_section {
+    private:
+        reader_epoch& _mine;
     public:
-        static std::atomic<size_t>& get() {
-            static std::atomic<size_t> active;
-            return active;
-        };
-        policy_manager() {
-            get()++;
+        read_section() : _mine(my_epoch()) {
+            if (_mine.depth++ == 0) {
+                _mine.epoch.store(global_epoch.load());
+            }
         }
-        ~policy_manager() {
-            get()--;
+        ~read_section() {
+            if (--_mine.depth == 0) {
+                _mine.epoch.store(0, std::memory_order_release);
+            }
         }
     };
 
@@ -55,9 +94,17 @@ namespace apex {
 #ifdef APEX_HAVE_HPX
     std::atomic<bool> hpx_timer_stopped{false};
     std::mutex hpx_timer_mutex;
-    policy_handler::policy_handler (void) : handler() { }
+    policy_handler::policy_handler (void) : handler(),
+        _policies(new policy_table()), _custom_count(0),
+        _stop_batch_count(0), _batch_thread(nullptr), _batch_done(false) {
+        for (auto &count : _counts) { count = 0; }
+    }
 #else
-    policy_handler::policy_handler (void) : handler() { }
+    policy_handler::policy_handler (void) : handler(),
+        _policies(new policy_table()), _custom_count(0),
+        _stop_batch_count(0), _batch_thread(nullptr), _batch_done(false) {
+        for (auto &count : _counts) { count = 0; }
+    }
 #endif
 
     /*
@@ -72,15 +119,21 @@ namespace apex {
 #ifdef APEX_HAVE_HPX
     policy_handler::policy_handler (uint64_t period_microseconds) :
         handler(period_microseconds),
+        _policies(new policy_table()), _custom_count(0),
+        _stop_batch_count(0), _batch_thread(nullptr), _batch_done(false),
         hpx_timer(hpx::util::bind(&policy_handler::_handler, this), _period,
         "apex_internal_policy_handler")
     {
+        for (auto &count : _counts) { count = 0; }
         _init();
     }
 #else
     policy_handler::policy_handler (uint64_t period_microseconds) :
-        handler(period_microseconds)
+        handler(period_microseconds),
+        _policies(new policy_table()), _custom_count(0),
+        _stop_batch_count(0), _batch_thread(nullptr), _batch_done(false)
     {
+        for (auto &count : _counts) { count = 0; }
         _init();
     }
 #endif
@@ -103,8 +156,16 @@ namespace apex {
         return true;
     }
 
+    policy_handler::~policy_handler (void) {
+        stop_batch_thread();
+        std::unique_lock<std::mutex> l(_write_mutex);
+        for (auto &retired : _retired) {
+            delete retired.second;
+        }
+        delete _policies.load();
+    }
+
     void policy_handler::_init(void) {
-        policy_manager::get() = 0;
 #ifdef APEX_HAVE_HPX
         hpx_timer.start();
 #else
@@ -127,353 +188,242 @@ namespace apex {
 #endif
     }
 
-    int policy_handler::register_policy(const apex_event_type & when,
-            std::function<int(apex_context const&)> f) {
-        // save the old policy setting
-        bool old_policy_setting = apex_options::use_policy();
-        // prevent policies from iterating - kind of like a lock, but faster.
-        apex_options::use_policy(false);
-        // Sleep just a tiny bit - that allows other threads that might be
-        // currently processing policies to clear out. This is actually
-        // more efficient than a lock transaction on every policy execution.
-        while(policy_manager::get() > 0) {
-#if defined(_WIN32)
-            Sleep(1);
+    /* The timer only runs while there are periodic policies.  Stopping it
+     * doesn't terminate the handler, the other policies keep running.  Call
+     * with the write lock held. */
+    void policy_handler::update_timer(const policy_table & table) {
+        if (_terminate) return;
+        const bool periodic = !table.builtin[APEX_PERIODIC].empty();
+#ifdef APEX_HAVE_HPX
+        std::unique_lock<mutex> l(hpx_timer_mutex);
+        if (periodic) {
+            hpx_timer.start();
+        } else {
+            hpx_timer.stop();
+        }
 #else
-            usleep(apex_options::policy_drain_timeout()); // sleep 1ms
+        if (periodic && _timer_thread == nullptr) {
+            run();
+        } else if (!periodic) {
+            stop_timer();
+        }
 #endif
+    }
+
+    /* Publish a new table, and retire the old one.  Call with the write
+     * lock held. */
+    void policy_handler::publish(policy_table * table) {
+        for (int i = 0 ; i < APEX_CUSTOM_EVENT_1 ; i++) {
+            _counts[i] = table->builtin[i].size();
         }
-        int id = next_id++;
-        std::shared_ptr<policy_instance> instance(
-                std::make_shared<policy_instance>(id, f));
-        switch(when) {
-            case APEX_STARTUP: {
-                //write_lock_type l(startup_mutex);
-                startup_policies.push_back(instance);
-                break;
-            }
-            case APEX_SHUTDOWN: {
-                //write_lock_type l(shutdown_mutex);
-                shutdown_policies.push_back(instance);
-                break;
-            }
-            case APEX_NEW_NODE: {
-                //write_lock_type l(new_node_mutex);
-                new_node_policies.push_back(instance);
-                break;
-            }
-            case APEX_NEW_THREAD: {
-                //write_lock_type l(new_thread_mutex);
-                new_thread_policies.push_back(instance);
-                break;
-            }
-            case APEX_EXIT_THREAD: {
-                //write_lock_type l(exit_thread_mutex);
-                exit_thread_policies.push_back(instance);
-                break;
-            }
-            case APEX_START_EVENT: {
-                //write_lock_type l(start_event_mutex);
-                start_event_policies.push_back(instance);
-                break;
-            }
-            case APEX_RESUME_EVENT: {
-                //write_lock_type l(resume_event_mutex);
-                resume_event_policies.push_back(instance);
-                break;
-            }
-            case APEX_STOP_EVENT: {
-                //write_lock_type l(stop_event_mutex);
-                stop_event_policies.push_back(instance);
-                break;
-            }
-            case APEX_YIELD_EVENT: {
-                //write_lock_type l(yield_event_mutex);
-                yield_event_policies.push_back(instance);
-                break;
-            }
-            case APEX_SAMPLE_VALUE: {
-                //write_lock_type l(sample_value_mutex);
-                sample_value_policies.push_back(instance);
-                break;
-            }
-            case APEX_SEND: {
-                //write_lock_type l(sample_value_mutex);
-                send_policies.push_back(instance);
-                break;
-            }
-            case APEX_RECV: {
-                //write_lock_type l(sample_value_mutex);
-                recv_policies.push_back(instance);
-                break;
-            }
-            case APEX_PERIODIC: {
-                //write_lock_type l(periodic_mutex);
-                periodic_policies.push_back(instance);
-                break;
+        size_t custom = 0;
+        for (auto &kv : table->custom) { custom += kv.second.size(); }
+        _custom_count = custom;
+        _stop_batch_count = table->stop_batch.size();
+        const policy_table * old = _policies.exchange(table);
+        // readers that started before this epoch may still see the old one
+        uint64_t epoch = ++global_epoch;
+        _retired.push_back(std::make_pair(epoch, old));
+        reclaim();
+    }
+
+    /* Delete the retired tables that nobody can be reading.  Call with the
+     * write lock held. */
+    void policy_handler::reclaim(void) {
+        uint64_t oldest = UINT64_MAX;
+        {
+            std::unique_lock<std::mutex> l(readers_mutex());
+            for (auto reader : readers()) {
+                uint64_t epoch = reader->epoch.load();
+                if (epoch != 0 && epoch < oldest) { oldest = epoch; }
             }
-            //case APEX_CUSTOM_EVENT_1:
-            default: {
-                //write_lock_type l(custom_event_mutex);
-                static std::mutex foo;
-                foo.lock();
-                if(custom_event_policies.find(when) == custom_event_policies.end()) {
-                    std::list<std::shared_ptr<policy_instance> > new_list;
-                    custom_event_policies.insert(std::make_pair(when, std::move(new_list)));
-                }
-                foo.unlock();
-                custom_event_policies[when].push_back(instance);
-                break;
+        }
+        auto it = _retired.begin();
+        while (it != _retired.end()) {
+            if (it->first <= oldest) {
+                delete it->second;
+                it = _retired.erase(it);
+            } else {
+                ++it;
             }
         }
-        apex_options::use_policy(old_policy_setting);
+    }
+
+    int policy_handler::register_policy(const apex_event_type & when,
+            std::function<int(apex_context const&)> f) {
+        int id = next_id++;
+        std::unique_lock<std::mutex> l(_write_mutex);
+        policy_table * table = new policy_table(*(_policies.load()));
+        table->get(when).push_back(policy_instance(id, f));
+        if (when == APEX_PERIODIC) {
+            update_timer(*table);
+        }
+        publish(table);
         return id;
+    }
 
+    int policy_handler::register_stop_batch_policy(
+            std::function<int(apex_stop_event const*, size_t)> f) {
+        int id = next_id++;
+        std::unique_lock<std::mutex> l(_write_mutex);
+        policy_table * table = new policy_table(*(_policies.load()));
+        table->stop_batch.push_back(stop_batch_instance(id, f));
+        publish(table);
+        if (_batch_thread == nullptr) {
+            _batch_thread = new std::thread(&policy_handler::batch_loop, this);
+        }
+        return id;
     }
 
     int policy_handler::deregister_policy(apex_policy_handle * handle) {
         if (handle == nullptr) {
             return APEX_NOERROR;
         }
-        // save the old policy setting
-        bool old_policy_setting = apex_options::use_policy();
-        // prevent policies from iterating - kind of like a lock, but faster.
-        apex_options::use_policy(false);
-        // Sleep just a tiny bit - that allows other threads that might be
-        // currently processing policies to clear out. This is actually
-        // more efficient than a lock transaction on every policy execution.
-        while (policy_manager::get() > 0) {
-#if defined(_WIN32)
-            Sleep(1);
-#else
-            usleep(apex_options::policy_drain_timeout()); // sleep 1ms
-#endif
+        // a stop batch policy gets the stops it hasn't seen yet
+        if (handle->event_type == APEX_STOP_EVENT && _stop_batch_count > 0) {
+            deliver_batches();
         }
-        switch(handle->event_type) {
-            case APEX_STARTUP: {
-                //write_lock_type l(startup_mutex);
-                std::list<std::shared_ptr<policy_instance> >::iterator it;
-                for(it = startup_policies.begin() ;
-                    it != startup_policies.end() ; it++) {
-                    std::shared_ptr<policy_instance> policy = *it;
-                    if (policy->id == handle->id) {
-                        startup_policies.erase(it);
-                        break;
-                    }
-                }
-                break;
-            }
-            case APEX_SHUTDOWN: {
-                //write_lock_type l(shutdown_mutex);
-                std::list<std::shared_ptr<policy_instance> >::iterator it;
-                for(it = shutdown_policies.begin() ;
-                    it != shutdown_policies.end() ; it++) {
-                    std::shared_ptr<policy_instance> policy = *it;
-                    if (policy->id == handle->id) {
-                        shutdown_policies.erase(it);
-                        break;
-                    }
+        std::unique_lock<std::mutex> l(_write_mutex);
+        policy_table * table = new policy_table(*(_policies.load()));
+        policy_array &policies = table->get(handle->event_type);
+        for (auto it = policies.begin() ; it != policies.end() ; it++) {
+            if (it->id == handle->id) {
+                policies.erase(it);
+                if (handle->event_type == APEX_PERIODIC) {
+                    update_timer(*table);
                 }
                 break;
             }
-            case APEX_NEW_NODE: {
-                //write_lock_type l(new_node_mutex);
-                std::list<std::shared_ptr<policy_instance> >::iterator it;
-                for(it = new_node_policies.begin() ;
-                    it != new_node_policies.end() ; it++) {
-                    std::shared_ptr<policy_instance> policy = *it;
-                    if (policy->id == handle->id) {
-                        new_node_policies.erase(it);
-                        break;
-                    }
-                }
-                break;
-            }
-            case APEX_NEW_THREAD: {
-                //write_lock_type l(new_thread_mutex);
-                std::list<std::shared_ptr<policy_instance> >::iterator it;
-                for(it = new_thread_policies.begin() ;
-                    it != new_thread_policies.end() ; it++) {
-                    std::shared_ptr<policy_instance> policy = *it;
-                    if (policy->id == handle->id) {
-                        new_thread_policies.erase(it);
-                        break;
-                    }
-                }
-                break;
-            }
-            case APEX_EXIT_THREAD: {
-                //write_lock_type l(exit_thread_mutex);
-                std::list<std::shared_ptr<policy_instance> >::iterator it;
-                for(it = exit_thread_policies.begin() ;
-                    it != exit_thread_policies.end() ; it++) {
-                    std::shared_ptr<policy_instance> policy = *it;
-                    if (policy->id == handle->id) {
-                        exit_thread_policies.erase(it);
-                        break;
-                    }
-                }
-                break;
-            }
-            case APEX_START_EVENT: {
-                //write_lock_type l(start_event_mutex);
-                std::list<std::shared_ptr<policy_instance> >::iterator it;
-                for(it = start_event_policies.begin() ;
-                    it != start_event_policies.end() ; it++) {
-                    std::shared_ptr<policy_instance> policy = *it;
-                    if (policy->id == handle->id) {
-                        start_event_policies.erase(it);
-                        break;
-                    }
-                }
-                break;
-            }
-            case APEX_RESUME_EVENT: {
-                //write_lock_type l(resume_event_mutex);
-                std::list<std::shared_ptr<policy_instance> >::iterator it;
-                for(it = resume_event_policies.begin() ;
-                    it != resume_event_policies.end() ; it++) {
-                    std::shared_ptr<policy_instance> policy = *it;
-                    if (policy->id == handle->id) {
-                        resume_event_policies.erase(it);
-                        break;
-                    }
-                }
-                break;
-            }
-            case APEX_STOP_EVENT: {
-                //write_lock_type l(stop_event_mutex);
-                std::list<std::shared_ptr<policy_instance> >::iterator it;
-                for(it = stop_event_policies.begin() ;
-                    it != stop_event_policies.end() ; it++) {
-                    std::shared_ptr<policy_instance> policy = *it;
-                    if (policy->id == handle->id) {
-                        stop_event_policies.erase(it);
-                        break;
-                    }
-                }
-                break;
-            }
-            case APEX_YIELD_EVENT: {
-                //write_lock_type l(yield_event_mutex);
-                std::list<std::shared_ptr<policy_instance> >::iterator it;
-                for(it = yield_event_policies.begin() ;
-                    it != yield_event_policies.end() ; it++) {
-                    std::shared_ptr<policy_instance> policy = *it;
-                    if (policy->id == handle->id) {
-                        yield_event_policies.erase(it);
-                        break;
-                    }
-                }
-                break;
-            }
-            case APEX_SAMPLE_VALUE: {
-                //write_lock_type l(sample_value_mutex);
-                std::list<std::shared_ptr<policy_instance> >::iterator it;
-                for(it = sample_value_policies.begin() ;
-                    it != sample_value_policies.end() ; it++) {
-                    std::shared_ptr<policy_instance> policy = *it;
-                    if (policy->id == handle->id) {
-                        sample_value_policies.erase(it);
-                        break;
-                    }
-                }
-                break;
-            }
-            case APEX_SEND: {
-                //write_lock_type l(send_mutex);
-                std::list<std::shared_ptr<policy_instance> >::iterator it;
-                for(it = send_policies.begin() ;
-                    it != send_policies.end() ; it++) {
-                    std::shared_ptr<policy_instance> policy = *it;
-                    if (policy->id == handle->id) {
-                        send_policies.erase(it);
-                        break;
-                    }
-                }
-                break;
-            }
-            case APEX_RECV: {
-                //write_lock_type l(recv_mutex);
-                std::list<std::shared_ptr<policy_instance> >::iterator it;
-                for(it = recv_policies.begin() ;
-                    it != recv_policies.end() ; it++) {
-                    std::shared_ptr<policy_instance> policy = *it;
-                    if (policy->id == handle->id) {
-                        recv_policies.erase(it);
-                        break;
-                    }
-                }
-                break;
-            }
-            case APEX_PERIODIC: {
-                //write_lock_type l(periodic_mutex);
-                std::list<std::shared_ptr<policy_instance> >::iterator it;
-                for(it = periodic_policies.begin() ;
-                    it != periodic_policies.end() ; it++) {
-                    std::shared_ptr<policy_instance> policy = *it;
-                    if (policy->id == handle->id) {
-                            _terminate = true;
-#ifdef APEX_HAVE_HPX
-                            this->_reset();
-#else
-                            cancel();
-#endif
-                        periodic_policies.erase(it);
-                        break;
-                    }
-                }
-                break;
-            }
-            //case APEX_CUSTOM_EVENT_1:
-            default: {
-                //write_lock_type l(custom_event_mutex);
-                std::list<std::shared_ptr<policy_instance> >::iterator it;
-                for(it = custom_event_policies[handle->event_type].begin() ; it
-                    != custom_event_policies[handle->event_type].end() ; it++) {
-                    std::shared_ptr<policy_instance> policy = *it;
-                    if (policy->id == handle->id) {
-                        custom_event_policies[handle->event_type].erase(it);
-                        break;
-                    }
+        }
+        if (handle->event_type == APEX_STOP_EVENT) {
+            auto &batched = table->stop_batch;
+            for (auto it = batched.begin() ; it != batched.end() ; it++) {
+                if (it->id == handle->id) {
+                    batched.erase(it);
+                    break;
                 }
-                break;
             }
         }
-        handle = nullptr;
-        apex_options::use_policy(old_policy_setting);
+        publish(table);
         return APEX_NOERROR;
     }
 
     inline void policy_handler::call_policies(
-            const std::list<std::shared_ptr<policy_instance> > & policies,
-            void *data, const apex_event_type& event_type) {
-        /* we are using this flag to prevent race conditions on the
-         * list of policies. If the list changes, we can't iterate
-         * over it. */
+            const apex_event_type& event_type, void *data) {
         if (!apex_options::use_policy()) { return; }
-        // scoped variable to increment/decrement active policies
-        policy_manager mgr;
-        APEX_UNUSED(mgr);
-        for(const std::shared_ptr<policy_instance>& policy : policies) {
+        // most events have no policies at all
+        if (event_type < APEX_CUSTOM_EVENT_1) {
+            if (_counts[event_type].load(std::memory_order_relaxed) == 0) {
+                return;
+            }
+        } else if (_custom_count.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+        read_section reading;
+        const policy_array * policies = _policies.load()->find(event_type);
+        if (policies == nullptr) { return; }
+        for (const policy_instance& policy : *policies) {
             apex_context my_context;
             my_context.event_type = event_type;
             my_context.policy_handle = nullptr;
             my_context.data = data;
             // last chance to interrupt policy execution at shutdown
             if (_terminate) return;
-            // to check if policy is already deregistered(race condition).
-            if(policy == nullptr) continue;
-            const bool result = policy->func(my_context);
+            const int result = policy.func(my_context);
+            if(result != APEX_NOERROR) {
+                printf("Warning: registered policy function failed!\n");
+            }
+        }
+    }
+
+    /* The stops waiting for the stop batch policies, per thread */
+    struct stop_event_buffer {
+        std::mutex lock;
+        std::vector<apex_stop_event> events;
+    };
+
+    static std::mutex& stop_buffers_mutex(void) {
+        static std::mutex mtx;
+        return mtx;
+    }
+
+    /* never freed, threads can exit before their stops are delivered */
+    static std::vector<stop_event_buffer*>& stop_buffers(void) {
+        static std::vector<stop_event_buffer*> * all =
+            new std::vector<stop_event_buffer*>();
+        return *all;
+    }
+
+    static stop_event_buffer& my_stop_buffer(void) {
+        static APEX_NATIVE_TLS stop_event_buffer * mine = nullptr;
+        if (mine == nullptr) {
+            mine = new stop_event_buffer();
+            std::unique_lock<std::mutex> l(stop_buffers_mutex());
+            stop_buffers().push_back(mine);
+        }
+        return *mine;
+    }
+
+    /* Collect the stops from every thread, and give them to the stop batch
+     * policies. */
+    void policy_handler::deliver_batches(void) {
+        // a policy can deregister itself, don't deliver from inside it
+        static APEX_NATIVE_TLS bool delivering = false;
+        if (delivering) { return; }
+        std::unique_lock<std::mutex> dl(_deliver_mutex);
+        _batch.clear();
+        {
+            std::unique_lock<std::mutex> l(stop_buffers_mutex());
+            for (auto buffer : stop_buffers()) {
+                std::unique_lock<std::mutex> bl(buffer->lock);
+                _batch.insert(_batch.end(), buffer->events.begin(),
+                    buffer->events.end());
+                buffer->events.clear();
+            }
+        }
+        if (_batch.size() == 0) { return; }
+        read_section reading;
+        delivering = true;
+        for (const stop_batch_instance& policy :
+            _policies.load()->stop_batch) {
+            const int result = policy.func(_batch.data(), _batch.size());
             if(result != APEX_NOERROR) {
                 printf("Warning: registered policy function failed!\n");
             }
-            if (!apex_options::use_policy()) { return; }
         }
+        delivering = false;
+    }
+
+    void policy_handler::batch_loop(void) {
+        // make sure APEX knows this is NOT a worker thread.
+        thread_instance::instance(false);
+        std::chrono::microseconds period(apex_options::policy_batch_period());
+        std::unique_lock<std::mutex> l(_batch_mutex);
+        while (!_batch_done) {
+            _batch_cv.wait_for(l, period, [this]{ return _batch_done; });
+            if (_batch_done) { break; }
+            l.unlock();
+            deliver_batches();
+            l.lock();
+        }
+    }
+
+    /* Stop the batch thread, and deliver whatever it hadn't yet. */
+    void policy_handler::stop_batch_thread(void) {
+        if (_batch_thread == nullptr) { return; }
+        {
+            std::unique_lock<std::mutex> l(_batch_mutex);
+            _batch_done = true;
+        }
+        _batch_cv.notify_all();
+        _batch_thread->join();
+        delete _batch_thread;
+        _batch_thread = nullptr;
+        deliver_batches();
     }
 
     void policy_handler::on_startup(startup_event_data &data) {
-        call_policies(startup_policies, (void *)&data, data.event_type_);
+        call_policies(APEX_STARTUP, (void *)&data);
     }
 
     void policy_handler::on_dump(dump_event_data &data) {
@@ -483,6 +433,7 @@ namespace apex {
 
     void policy_handler::on_shutdown(shutdown_event_data &data) {
         APEX_UNUSED(data);
+        stop_batch_thread();
         if (_terminate) return;
         // prevent periodic policies from executing while we are shutting down.
         _terminate = true;
@@ -492,94 +443,78 @@ namespace apex {
         cancel();
 #endif
         if (!apex_options::use_policy()) { return; }
-        for(const std::shared_ptr<policy_instance>& policy : shutdown_policies) {
+        // the shutdown policies run even though we are terminating
+        read_section reading;
+        for(const policy_instance& policy :
+            _policies.load()->builtin[APEX_SHUTDOWN]) {
             apex_context my_context;
             my_context.event_type = APEX_SHUTDOWN;
             my_context.policy_handle = nullptr;
             my_context.data = nullptr;
-            const bool result = policy->func(my_context);
+            const int result = policy.func(my_context);
             if(result != APEX_NOERROR) {
                 printf("Warning: registered policy function failed!\n");
             }
-            if (!apex_options::use_policy()) { return; }
         }
     }
 
     void policy_handler::on_new_node(node_event_data &data) {
-        call_policies(new_node_policies, (void *)&data, APEX_NEW_NODE);
+        call_policies(APEX_NEW_NODE, (void *)&data);
     }
 
     void policy_handler::on_new_thread(new_thread_event_data &data) {
-        call_policies(new_thread_policies, (void *)&data, APEX_NEW_THREAD);
+        call_policies(APEX_NEW_THREAD, (void *)&data);
     }
 
     void policy_handler::on_exit_thread(event_data &data) {
-        call_policies(exit_thread_policies, (void *)&data, APEX_EXIT_THREAD);
+        call_policies(APEX_EXIT_THREAD, (void *)&data);
     }
 
     bool policy_handler::on_start(std::shared_ptr<task_wrapper> &tt_ptr) {
-        call_policies(start_event_policies, (void *)tt_ptr->get_task_id(),
-            APEX_START_EVENT);
+        call_policies(APEX_START_EVENT, (void *)tt_ptr->get_task_id());
         return true;
     }
 
     bool policy_handler::on_resume(std::shared_ptr<task_wrapper> &tt_ptr) {
-        call_policies(resume_event_policies, (void *)tt_ptr->get_task_id(),
-            APEX_RESUME_EVENT);
+        call_policies(APEX_RESUME_EVENT, (void *)tt_ptr->get_task_id());
         return true;
     }
 
     void policy_handler::on_stop(std::shared_ptr<profiler> &p) {
-        call_policies(stop_event_policies, (void *)p->tt_ptr->get_task_id(),
-            APEX_STOP_EVENT);
+        call_policies(APEX_STOP_EVENT, (void *)p->tt_ptr->get_task_id());
+        if (_stop_batch_count.load(std::memory_order_relaxed) == 0) { return; }
+        apex_stop_event e;
+        e.task_id = (void *)p->get_task_id();
+        e.duration = p->elapsed();
+        e.guid = p->guid;
+        e.thread = thread_instance::get_id();
+        stop_event_buffer& buffer = my_stop_buffer();
+        std::unique_lock<std::mutex> l(buffer.lock);
+        buffer.events.push_back(e);
     }
 
     void policy_handler::on_yield(std::shared_ptr<profiler> &p) {
-        call_policies(yield_event_policies, (void *)p->tt_ptr->get_task_id(),
-            APEX_YIELD_EVENT);
+        call_policies(APEX_YIELD_EVENT, (void *)p->tt_ptr->get_task_id());
     }
 
     void policy_handler::on_sample_value(sample_value_event_data &data) {
-        call_policies(sample_value_policies, &data, APEX_SAMPLE_VALUE);
+        call_policies(APEX_SAMPLE_VALUE, &data);
     }
 
     void policy_handler::on_send(message_event_data &data) {
-        call_policies(send_policies, &data, APEX_SEND);
+        call_policies(APEX_SEND, &data);
     }
 
     void policy_handler::on_recv(message_event_data &data) {
-        call_policies(recv_policies, &data, APEX_RECV);
+        call_policies(APEX_RECV, &data);
     }
 
     void policy_handler::on_custom_event(custom_event_data &data) {
-        if (!apex_options::use_policy()) { return; }
-        // scoped variable to increment/decrement active policies
-        policy_manager mgr;
-        APEX_UNUSED(mgr);
-        for(const std::shared_ptr<policy_instance>& policy :
-            custom_event_policies[data.event_type_]) {
-            apex_context my_context;
-            my_context.event_type = data.event_type_;
-            my_context.policy_handle = nullptr;
-            my_context.data = data.data;
-            // last chance to interrupt policy execution at shutdown
-            // HOWEVER, if the event is shutdown, run the policy.
-            if (_terminate) return;
-            const bool result = policy->func(my_context);
-            if(result != APEX_NOERROR) {
-                printf("Warning: registered policy function failed!\n");
-            }
-            if (!apex_options::use_policy()) { return; }
-        }
+        call_policies(data.event_type_, data.data);
     }
 
     void policy_handler::on_periodic(periodic_event_data &data) {
-        // get the read lock first. Because if we are shutting down,
-        // the _terminate flag will be set after the write lock has
-        // been acquired.  Yes, the periodic lock will be held a few
-        // instructions longer, but this prevents race condition
-        // SegVs during shutdown.
-        call_policies(periodic_policies, (void *)&data, APEX_PERIODIC);
+        call_policies(APEX_PERIODIC, (void *)&data);
     }
 
 } // end namespace apex
@@ -20,7 +20,10 @@
 #include <vector>
 #include <map>
 #include <set>
-#include <list>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include <functional>
 #include <chrono>
 #include <memory>
@@ -40,47 +43,75 @@ class policy_instance
 {
 public:
     int id;
-    std::function<bool(apex_context const&)> func;
-    policy_instance(int id_, std::function<bool(apex_context const&)> func_) : id(id_),
-        func(func_) {};
+    std::function<int(apex_context const&)> func;
+    policy_instance(int id_, std::function<int(apex_context const&)> func_) :
+        id(id_), func(func_) {};
+};
+
+typedef std::vector<policy_instance> policy_array;
+
+class stop_batch_instance
+{
+public:
+    int id;
+    std::function<int(apex_stop_event const*, size_t)> func;
+    stop_batch_instance(int id_,
+        std::function<int(apex_stop_event const*, size_t)> func_) :
+        id(id_), func(func_) {};
+};
+
+/* All of the registered policies.  A table is never changed once it is
+ * published: registering or deregistering a policy copies the table,
+ * changes the copy and publishes it, and the old table is deleted once
+ * no thread can still be reading it. */
+class policy_table
+{
+public:
+    std::array<policy_array, APEX_CUSTOM_EVENT_1> builtin;
+    std::map<apex_event_type, policy_array> custom;
+    std::vector<stop_batch_instance> stop_batch;
+    const policy_array * find(apex_event_type when) const {
+        if (when < APEX_CUSTOM_EVENT_1) {
+            return &(builtin[when]);
+        }
+        auto it = custom.find(when);
+        return it == custom.end() ? nullptr : &(it->second);
+    }
+    policy_array & get(apex_event_type when) {
+        if (when < APEX_CUSTOM_EVENT_1) {
+            return builtin[when];
+        }
+        return custom[when];
+    }
 };
 
 class policy_handler : public handler, public event_listener
 {
 private:
     void _init(void);
-    std::list<std::shared_ptr<policy_instance> > startup_policies;
-    std::list<std::shared_ptr<policy_instance> > shutdown_policies;
-    std::list<std::shared_ptr<policy_instance> > new_node_policies;
-    std::list<std::shared_ptr<policy_instance> > new_thread_policies;
-    std::list<std::shared_ptr<policy_instance> > exit_thread_policies;
-    std::list<std::shared_ptr<policy_instance> > start_event_policies;
-    std::list<std::shared_ptr<policy_instance> > stop_event_policies;
-    std::list<std::shared_ptr<policy_instance> > yield_event_policies;
-    std::list<std::shared_ptr<policy_instance> > resume_event_policies;
-    std::list<std::shared_ptr<policy_instance> > sample_value_policies;
-    std::list<std::shared_ptr<policy_instance> > send_policies;
-    std::list<std::shared_ptr<policy_instance> > recv_policies;
-    std::list<std::shared_ptr<policy_instance> > periodic_policies;
-    std::map<apex_event_type, std::list<std::shared_ptr<policy_instance > > >
-        custom_event_policies;
-    shared_mutex_type startup_mutex;
-    shared_mutex_type shutdown_mutex;
-    shared_mutex_type new_node_mutex;
-    shared_mutex_type new_thread_mutex;
-    shared_mutex_type exit_thread_mutex;
-    shared_mutex_type start_event_mutex;
-    shared_mutex_type stop_event_mutex;
-    shared_mutex_type yield_event_mutex;
-    shared_mutex_type resume_event_mutex;
-    shared_mutex_type sample_value_mutex;
-    shared_mutex_type send_mutex;
-    shared_mutex_type recv_mutex;
-    shared_mutex_type custom_event_mutex;
-    shared_mutex_type periodic_mutex;
-    void call_policies(
-        const std::list<std::shared_ptr<policy_instance> > & policies,
-        void *event_data, const apex_event_type& event_type);
+    std::atomic<const policy_table*> _policies;
+    /* the number of policies for each built in event, so the events
+     * without any can return without looking at the table */
+    std::array<std::atomic<size_t>, APEX_CUSTOM_EVENT_1> _counts;
+    std::atomic<size_t> _custom_count;
+    /* held by writers only */
+    std::mutex _write_mutex;
+    std::vector<std::pair<uint64_t, const policy_table*> > _retired;
+    void publish(policy_table * table);
+    void update_timer(const policy_table & table);
+    void reclaim(void);
+    void call_policies(const apex_event_type& event_type, void *event_data);
+    /* The stops for the stop batch policies are delivered by this thread */
+    std::atomic<size_t> _stop_batch_count;
+    std::thread * _batch_thread;
+    std::mutex _batch_mutex;
+    std::condition_variable _batch_cv;
+    bool _batch_done;
+    std::mutex _deliver_mutex;
+    std::vector<apex_stop_event> _batch;
+    void batch_loop(void);
+    void deliver_batches(void);
+    void stop_batch_thread(void);
 #ifdef APEX_HAVE_HPX
     hpx::util::interval_timer hpx_timer;
 #endif
@@ -91,7 +122,7 @@ public:
     policy_handler (std::chrono::duration<Rep, Period> const& period);
 */
     policy_handler(uint64_t period_microseconds);
-    ~policy_handler (void) { };
+    ~policy_handler (void);
     void on_startup(startup_event_data &data);
     void on_dump(dump_event_data &data);
     void on_reset(task_identifier * id)
@@ -118,6 +149,8 @@ public:
 
     int register_policy(const apex_event_type & when,
                         std::function<int(apex_context const&)> f);
+    int register_stop_batch_policy(
+        std::function<int(apex_stop_event const*, size_t)> f);
     int deregister_policy(apex_policy_handle * handle);
     bool _handler(void);
     void _reset(void);
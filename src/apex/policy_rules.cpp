@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2014-2021 Kevin Huck
+ * Copyright (c) 2014-2021 University of Oregon
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include "policy_rules.hpp"
+#include "apex_api.hpp"
+#include "apex_options.hpp"
+#include "profiler.hpp"
+#include <string.h>
+#include <fstream>
+#include <iostream>
+#include <rapidjson/document.h>
+#include <rapidjson/istreamwrapper.h>
+
+namespace apex {
+
+static bool rule_error(size_t index, const std::string &message) {
+    std::cerr << "APEX: policy rule " << index << ": " << message
+              << ", ignoring it." << std::endl;
+    return false;
+}
+
+static bool compile_rule(const rapidjson::Value &r, size_t index,
+    std::vector<compiled_rule> &rules) {
+    if (!r.IsObject()) {
+        return rule_error(index, "not an object");
+    }
+    std::string watched;
+    if (r.HasMember("timer") && r["timer"].IsString()) {
+        watched = r["timer"].GetString();
+    } else if (r.HasMember("counter") && r["counter"].IsString()) {
+        watched = r["counter"].GetString();
+    } else {
+        return rule_error(index, "no timer or counter");
+    }
+    compiled_rule rule(watched);
+    std::string metric(r.HasMember("metric") && r["metric"].IsString() ?
+        r["metric"].GetString() : "mean");
+    if (metric == "mean" || metric == "value") {
+        rule.metric = rule_metric::MEAN;
+    } else if (metric == "rate") {
+        rule.metric = rule_metric::RATE;
+    } else if (metric == "calls") {
+        rule.metric = rule_metric::CALLS;
+    } else if (metric == "accumulated") {
+        rule.metric = rule_metric::ACCUMULATED;
+    } else {
+        return rule_error(index, "unknown metric '" + metric + "'");
+    }
+    if (r.HasMember("above") && r["above"].IsNumber()) {
+        rule.above = true;
+        rule.threshold = r["above"].GetDouble();
+    } else if (r.HasMember("below") && r["below"].IsNumber()) {
+        rule.above = false;
+        rule.threshold = r["below"].GetDouble();
+    } else {
+        return rule_error(index, "no 'above' or 'below' threshold");
+    }
+    if (r.HasMember("periods")) {
+        if (!r["periods"].IsUint() || r["periods"].GetUint() == 0) {
+            return rule_error(index, "'periods' must be a positive integer");
+        }
+        rule.periods = r["periods"].GetUint();
+    }
+    std::string action(r.HasMember("action") && r["action"].IsString() ?
+        r["action"].GetString() : "");
+    if (action == "set_thread_cap") {
+        if (!r.HasMember("value") || !r["value"].IsInt() ||
+            r["value"].GetInt() < 1) {
+            return rule_error(index, "set_thread_cap needs a 'value' > 0");
+        }
+        rule.action = rule_action::SET_THREAD_CAP;
+        rule.thread_cap = r["value"].GetInt();
+    } else if (action == "custom_event") {
+        if (!r.HasMember("event") || !r["event"].IsString()) {
+            return rule_error(index, "custom_event needs an 'event' name");
+        }
+        rule.action = rule_action::CUSTOM_EVENT;
+        rule.event = register_custom_event(r["event"].GetString());
+    } else if (action == "trace_window") {
+        rule.action = rule_action::TRACE_WINDOW;
+        if (r.HasMember("seconds") && r["seconds"].IsNumber()) {
+            rule.seconds = r["seconds"].GetDouble();
+        }
+    } else if (action == "dump") {
+        rule.action = rule_action::DUMP;
+    } else {
+        return rule_error(index, "unknown action '" + action + "'");
+    }
+    rules.push_back(rule);
+    return true;
+}
+
+bool policy_rules::load(const std::string &filename) {
+    std::ifstream cfg(filename);
+    if (!cfg.good()) {
+        std::cerr << "APEX: could not read policy rules from " << filename
+                  << std::endl;
+        return false;
+    }
+    rapidjson::IStreamWrapper file_wrapper(cfg);
+    rapidjson::Document configuration;
+    configuration.ParseStream(file_wrapper);
+    if (configuration.HasParseError() || !configuration.IsObject() ||
+        !configuration.HasMember("rules") ||
+        !configuration["rules"].IsArray()) {
+        std::cerr << "APEX: " << filename << " has no \"rules\" array"
+                  << std::endl;
+        return false;
+    }
+    auto &rules = configuration["rules"];
+    for (rapidjson::SizeType i = 0 ; i < rules.Size() ; i++) {
+        compile_rule(rules[i], i, _rules);
+    }
+    return true;
+}
+
+void policy_rules::take_action(compiled_rule &rule) {
+    if (apex_options::use_verbose()) {
+        std::cout << "APEX: policy rule for '" << rule.name << "' triggered"
+                  << std::endl;
+    }
+    switch (rule.action) {
+        case rule_action::SET_THREAD_CAP:
+            set_thread_cap(rule.thread_cap);
+            break;
+        case rule_action::CUSTOM_EVENT:
+            custom_event(rule.event, nullptr);
+            break;
+        case rule_action::TRACE_WINDOW:
+            begin_trace_window(rule.seconds);
+            break;
+        case rule_action::DUMP:
+            dump(false);
+            break;
+    }
+}
+
+void policy_rules::evaluate(void) {
+    uint64_t now = profiler::now_ns();
+    double period = _last_ns == 0 ? 0.0 : (now - _last_ns) * 1.0e-9;
+    _last_ns = now;
+    for (auto &rule : _rules) {
+        // a consistent copy, so the calls and time are from the same update
+        apex_profile p;
+        if (!get_profile(rule.id, p)) { continue; }
+        // the profile may have been reset since the last period
+        if (p.calls < rule.last_calls) {
+            rule.last_calls = 0.0;
+            rule.last_accumulated = 0.0;
+        }
+        double calls = p.calls - rule.last_calls;
+        double accumulated = p.accumulated - rule.last_accumulated;
+        rule.last_calls = p.calls;
+        rule.last_accumulated = p.accumulated;
+        // timers are measured in nanoseconds, report seconds
+        if (p.type == APEX_TIMER) {
+            accumulated = accumulated * 1.0e-9;
+        }
+        // nothing to compare against yet
+        if (period == 0.0) { continue; }
+        double value = 0.0;
+        switch (rule.metric) {
+            case rule_metric::MEAN:
+                if (calls == 0.0) {
+                    rule.held = 0;
+                    continue;
+                }
+                value = accumulated / calls;
+                break;
+            case rule_metric::RATE:
+                value = calls / period;
+                break;
+            case rule_metric::CALLS:
+                value = calls;
+                break;
+            case rule_metric::ACCUMULATED:
+                value = accumulated;
+                break;
+        }
+        bool crossed = rule.above ? value > rule.threshold :
+            value < rule.threshold;
+        if (!crossed) {
+            rule.held = 0;
+            continue;
+        }
+        // act once, when the condition has held long enough
+        if (rule.held < rule.periods && ++rule.held == rule.periods) {
+            take_action(rule);
+        }
+    }
+}
+
+void policy_rules::initialize(void) {
+    const char * filename = apex_options::policy_rules_file();
+    if (filename == nullptr || strlen(filename) == 0) { return; }
+    // never freed, the policy may run until the end
+    policy_rules * rules = new policy_rules();
+    if (!rules->load(filename) || rules->size() == 0) {
+        delete rules;
+        return;
+    }
+    if (apex_options::use_verbose()) {
+        std::cout << "APEX: " << rules->size() << " policy rules from "
+                  << filename << std::endl;
+    }
+    register_periodic_policy(apex_options::policy_rules_period(),
+        [rules](apex_context const &context) {
+            APEX_UNUSED(context);
+            rules->evaluate();
+            return APEX_NOERROR;
+        });
+}
+
+}
+
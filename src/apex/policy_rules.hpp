@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2014-2021 Kevin Huck
+ * Copyright (c) 2014-2021 University of Oregon
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+
+/* Rule based policies, read from the JSON file in APEX_POLICY_RULES_FILE:
+ *
+ * { "rules": [
+ *     { "timer": "solve", "metric": "mean", "above": 0.5, "periods": 3,
+ *       "action": "set_thread_cap", "value": 4 },
+ *     { "counter": "CPU Load %", "metric": "value", "below": 10,
+ *       "action": "custom_event", "event": "idle" } ] }
+ *
+ * Every rule watches one timer or counter.  The metrics are computed over
+ * the last period only: "mean" (seconds per call for timers), "value" (the
+ * mean of the samples, for counters), "rate" (calls per second), "calls"
+ * and "accumulated".  When the metric has been above (or below) the
+ * threshold for "periods" periods in a row, the action is taken once, and
+ * the rule is armed again when the condition stops holding.  The actions
+ * are "set_thread_cap" (value), "custom_event" (event, the name of a custom
+ * event), "trace_window" (seconds) and "dump".  The rules are compiled once,
+ * and evaluated by one periodic policy every APEX_POLICY_RULES_PERIOD
+ * microseconds, so the cost is one profile lookup per rule per period.
+ */
+
+#include "apex_types.h"
+#include "task_identifier.hpp"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace apex {
+
+enum class rule_metric { MEAN, RATE, CALLS, ACCUMULATED };
+enum class rule_action { SET_THREAD_CAP, CUSTOM_EVENT, TRACE_WINDOW, DUMP };
+
+class compiled_rule {
+public:
+    std::string name;
+    task_identifier id;
+    rule_metric metric;
+    bool above;
+    double threshold;
+    unsigned int periods;
+    rule_action action;
+    int thread_cap;
+    apex_event_type event;
+    double seconds;
+    /* the state of the rule */
+    double last_calls;
+    double last_accumulated;
+    unsigned int held;
+    compiled_rule(const std::string &timer) : name(timer), id(timer),
+        metric(rule_metric::MEAN), above(true), threshold(0.0), periods(1),
+        action(rule_action::DUMP), thread_cap(0), event(APEX_CUSTOM_EVENT_1),
+        seconds(0.0), last_calls(0.0), last_accumulated(0.0), held(0) {}
+};
+
+class policy_rules {
+private:
+    std::vector<compiled_rule> _rules;
+    uint64_t _last_ns;
+    void take_action(compiled_rule &rule);
+public:
+    policy_rules(void) : _last_ns(0) {}
+    /* Read and compile the rules, returns false if the file is bad */
+    bool load(const std::string &filename);
+    size_t size(void) const { return _rules.size(); }
+    /* Evaluate every rule once, called by the periodic policy */
+    void evaluate(void);
+    /* Load the rules in APEX_POLICY_RULES_FILE, if any, and register the
+     * policy that evaluates them. */
+    static void initialize(void);
+};
+
+}
+
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2014-2021 Kevin Huck
+ * Copyright (c) 2014-2021 University of Oregon
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+
+/* A pool of fixed size blocks, with a free list per thread, and an
+ * allocator that uses it for single objects.  It is meant for objects that
+ * are created and destroyed at a high rate, like the task_wrapper objects
+ * (with std::allocate_shared, the shared_ptr control block and the object
+ * come from the same block).
+ *
+ * Every block remembers the thread that allocated it, and goes back to that
+ * thread when it is freed: onto its own free list if that thread frees it,
+ * or onto a lock-free stack of returned blocks that the owner takes back
+ * all at once when its list is empty.  So a thread that creates tasks that
+ * other threads finish still reuses its blocks.  Each free list is bounded,
+ * anything above that is given back to the heap.  When a thread exits, its
+ * blocks are given back to the heap, and any that are still in use are
+ * freed to the heap when they come back.
+ */
+
+#include "apex_types.h"
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+namespace apex {
+
+template <size_t Size>
+class fixed_size_pool {
+private:
+    struct owner;
+    /* The start of every block.  The next pointer is only used while the
+     * block is free, and the object comes after the header. */
+    struct block {
+        owner * pool;
+        block * next;
+    };
+    static const size_t header_size =
+        (sizeof(block) + alignof(std::max_align_t) - 1) /
+        alignof(std::max_align_t) * alignof(std::max_align_t);
+    /* blocks kept on each thread's free list, at most */
+    static const size_t max_free = 4096;
+    /* The blocks of one thread.  It is freed when the thread has exited
+     * and all of its blocks are back. */
+    struct owner {
+        block * head;                  // only used by the owning thread
+        size_t count;
+        std::atomic<block*> returned;  // freed by other threads
+        std::atomic<bool> alive;
+        std::atomic<size_t> references;  // the thread, and its blocks
+        owner(void) : head(nullptr), count(0), returned(nullptr),
+            alive(true), references(1) {}
+    };
+    struct thread_state {
+        owner * pool;
+        bool exited;
+    };
+    static thread_state& state(void) {
+        static APEX_NATIVE_TLS thread_state s = {nullptr, false};
+        return s;
+    }
+    static void release(owner * pool) {
+        if (pool->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete pool;
+        }
+    }
+    /* Give a list of blocks, all from the same pool, back to the heap */
+    static void free_blocks(block * b) {
+        while (b != nullptr) {
+            block * next = b->next;
+            owner * pool = b->pool;
+            ::operator delete(b);
+            release(pool);
+            b = next;
+        }
+    }
+    /* Empties the free lists when the thread exits.  Blocks that come back
+     * after that are freed by the thread that returns them. */
+    struct drain {
+        ~drain() {
+            thread_state& s = state();
+            owner * pool = s.pool;
+            s.pool = nullptr;
+            s.exited = true;
+            pool->alive.store(false);
+            block * b = pool->head;
+            pool->head = nullptr;
+            free_blocks(b);
+            free_blocks(pool->returned.exchange(nullptr));
+            release(pool);
+        }
+    };
+    static owner * my_pool(void) {
+        thread_state& s = state();
+        if (s.pool == nullptr && !s.exited) {
+            s.pool = new owner();
+            static thread_local drain d;
+            (void)(&d);
+        }
+        return s.pool;
+    }
+public:
+    static const size_t block_size = header_size + (Size > 0 ? Size : 1);
+    static void * allocate(void) {
+        owner * pool = my_pool();
+        if (pool != nullptr && pool->head == nullptr &&
+            pool->returned.load(std::memory_order_relaxed) != nullptr) {
+            // take back everything the other threads have freed
+            pool->head = pool->returned.exchange(nullptr,
+                std::memory_order_acquire);
+            pool->count = 0;
+            for (block * b = pool->head ; b != nullptr ; b = b->next) {
+                pool->count++;
+            }
+        }
+        block * b;
+        if (pool != nullptr && pool->head != nullptr) {
+            b = pool->head;
+            pool->head = b->next;
+            pool->count--;
+        } else {
+            b = static_cast<block*>(::operator new(block_size));
+            b->pool = pool;
+            if (pool != nullptr) {
+                pool->references.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        return reinterpret_cast<char*>(b) + header_size;
+    }
+    static void deallocate(void * p) {
+        block * b = reinterpret_cast<block*>(static_cast<char*>(p) -
+            header_size);
+        owner * pool = b->pool;
+        if (pool == nullptr) {
+            // allocated while its thread was exiting
+            ::operator delete(b);
+            return;
+        }
+        if (pool == state().pool) {
+            if (pool->count >= max_free) {
+                ::operator delete(b);
+                release(pool);
+                return;
+            }
+            b->next = pool->head;
+            pool->head = b;
+            pool->count++;
+            return;
+        }
+        /* Another thread's block.  Hold on to its pool, because the owner
+         * could exit and take back this block as soon as it is pushed. */
+        pool->references.fetch_add(1, std::memory_order_relaxed);
+        block * head = pool->returned.load(std::memory_order_relaxed);
+        do {
+            b->next = head;
+        } while (!pool->returned.compare_exchange_weak(head, b));
+        // if the owner has exited, nobody else will take it back
+        if (!pool->alive.load()) {
+            free_blocks(pool->returned.exchange(nullptr));
+        }
+        release(pool);
+    }
+};
+
+template <typename T>
+class pool_allocator {
+public:
+    typedef T value_type;
+    pool_allocator(void) noexcept {}
+    template <typename U>
+    pool_allocator(const pool_allocator<U>&) noexcept {}
+    T * allocate(size_t n) {
+        static_assert(alignof(T) <= alignof(std::max_align_t),
+            "the pool only supports the default alignment");
+        if (n == 1) {
+            return static_cast<T*>(fixed_size_pool<sizeof(T)>::allocate());
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+    void deallocate(T * p, size_t n) noexcept {
+        if (n == 1) {
+            fixed_size_pool<sizeof(T)>::deallocate(p);
+            return;
+        }
+        ::operator delete(p);
+    }
+};
+
+template <typename T, typename U>
+inline bool operator==(const pool_allocator<T>&, const pool_allocator<U>&) {
+    return true;
+}
+
+template <typename T, typename U>
+inline bool operator!=(const pool_allocator<T>&, const pool_allocator<U>&) {
+    return false;
+}
+
+} // namespace apex
@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <chrono>
 #include <iostream>
 #include <sstream>
@@ -20,12 +21,52 @@
 
 namespace apex {
 
+/* A profile is updated by the threads that stop its timers (or by the
+ * consumer thread), and read by policies at any time.  Each profile has a
+ * sequence lock: a writer takes it by moving the sequence from even to
+ * odd, updates the values, and makes it even again.  Readers never block,
+ * they copy the values and retry if the sequence was odd or changed while
+ * they were copying, so a copy never mixes two updates (see read()). */
 class profile {
 private:
     apex_profile _profile;
+    // entry in the shared memory profile, if used
+    std::atomic<int> _shared_index;
+    std::atomic<uint64_t> _sequence;
+    uint64_t begin_write(void) {
+        uint64_t seq = _sequence.load(std::memory_order_relaxed);
+        do {
+            while (seq & 1) {
+                seq = _sequence.load(std::memory_order_relaxed);
+            }
+        } while (!_sequence.compare_exchange_weak(seq, seq + 1,
+            std::memory_order_acquire, std::memory_order_relaxed));
+        std::atomic_thread_fence(std::memory_order_release);
+        return seq;
+    }
+    void end_write(uint64_t seq) {
+        _sequence.store(seq + 2, std::memory_order_release);
+    }
+    void _increment(double increase, int num_metrics, double * papi_metrics,
+        bool yielded, double weight) {
+        _profile.accumulated += increase * weight;
+        for (int i = 0 ; i < num_metrics ; i++) {
+            _profile.papi_metrics[i] += papi_metrics[i] * weight;
+        }
+#ifdef FULL_STATISTICS
+        _profile.sum_squares += (increase * increase) * weight;
+        // if not a fully completed task, don't modify these until it is done
+        _profile.minimum = _profile.minimum > increase ? increase : _profile.minimum;
+        _profile.maximum = _profile.maximum < increase ? increase : _profile.maximum;
+#endif
+        if (!yielded) {
+          _profile.calls = _profile.calls + weight;
+        }
+    }
 public:
     profile(double initial, int num_metrics, double * papi_metrics, bool
-        yielded = false, apex_profile_type type = APEX_TIMER) {
+        yielded = false, apex_profile_type type = APEX_TIMER) :
+        _shared_index(-1), _sequence(0) {
         _profile.type = type;
         if (!yielded) {
             _profile.calls = 1.0;
@@ -49,7 +90,7 @@ public:
     };
     profile(double initial, int num_metrics, double * papi_metrics, bool
         yielded, double allocations, double frees, double bytes_allocated,
-        double bytes_freed) {
+        double bytes_freed) : _shared_index(-1), _sequence(0) {
         _profile.type = APEX_TIMER;
         if (!yielded) {
             _profile.calls = 1.0;
@@ -71,39 +112,76 @@ public:
         _profile.bytes_allocated = bytes_allocated;
         _profile.bytes_freed = bytes_freed;
     };
+    /* A sampled call (see APEX_OVERHEAD_BUDGET) stands for weight calls,
+     * so it is counted that many times. */
     void increment(double increase, int num_metrics, double * papi_metrics,
-        bool yielded) {
-        _profile.accumulated += increase;
-        for (int i = 0 ; i < num_metrics ; i++) {
-            _profile.papi_metrics[i] += papi_metrics[i];
-        }
-#ifdef FULL_STATISTICS
-        _profile.sum_squares += (increase * increase);
-        // if not a fully completed task, don't modify these until it is done
-        _profile.minimum = _profile.minimum > increase ? increase : _profile.minimum;
-        _profile.maximum = _profile.maximum < increase ? increase : _profile.maximum;
-#endif
-        if (!yielded) {
-          _profile.calls = _profile.calls + 1.0;
-        }
+        bool yielded, double weight = 1.0) {
+        uint64_t seq = begin_write();
+        _increment(increase, num_metrics, papi_metrics, yielded, weight);
+        end_write(seq);
     }
     void increment(double increase, int num_metrics, double * papi_metrics,
         double allocations, double frees, double bytes_allocated, double bytes_freed,
-        bool yielded) {
-        increment(increase, num_metrics, papi_metrics, yielded);
-        _profile.allocations += allocations;
-        _profile.frees += frees;
-        _profile.bytes_allocated += bytes_allocated;
-        _profile.bytes_freed += bytes_freed;
+        bool yielded, double weight = 1.0) {
+        uint64_t seq = begin_write();
+        _increment(increase, num_metrics, papi_metrics, yielded, weight);
+        _profile.allocations += allocations * weight;
+        _profile.frees += frees * weight;
+        _profile.bytes_allocated += bytes_allocated * weight;
+        _profile.bytes_freed += bytes_freed * weight;
+        end_write(seq);
+    }
+    /* Add a batch of samples that were already aggregated by the
+     * thread that took them (see apex::sample_value(handle, value)). */
+    void increment_aggregate(double count, double sum, double sum_squares,
+        double minimum, double maximum) {
+        if (count <= 0.0) { return; }
+        uint64_t seq = begin_write();
+#ifdef FULL_STATISTICS
+        if (_profile.calls == 0.0) {
+            _profile.minimum = minimum;
+            _profile.maximum = maximum;
+        } else {
+            _profile.minimum = _profile.minimum > minimum ? minimum : _profile.minimum;
+            _profile.maximum = _profile.maximum < maximum ? maximum : _profile.maximum;
+        }
+        _profile.sum_squares += sum_squares;
+#else
+        APEX_UNUSED(sum_squares);
+        APEX_UNUSED(minimum);
+        APEX_UNUSED(maximum);
+#endif
+        _profile.accumulated += sum;
+        _profile.calls += count;
+        end_write(seq);
     }
     void reset() {
+        uint64_t seq = begin_write();
         _profile.calls = 0.0;
         _profile.accumulated = 0.0;
         _profile.sum_squares = 0.0;
         _profile.minimum = 0.0;
         _profile.maximum = 0.0;
         _profile.times_reset++;
+        end_write(seq);
     };
+    /* Copy the values, without ever seeing half of an update.  Returns the
+     * number of updates in the copy. */
+    uint64_t read(apex_profile &values) const {
+        uint64_t before, after;
+        do {
+            before = _sequence.load(std::memory_order_acquire);
+            if (before & 1) { continue; }
+            values = _profile;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = _sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+        return before / 2;
+    }
+    /* The number of updates so far, an update in progress isn't counted */
+    uint64_t updates(void) const {
+        return _sequence.load(std::memory_order_acquire) / 2;
+    }
     double get_calls() { return _profile.calls; }
     double get_mean() {
         return (get_accumulated() / _profile.calls);
@@ -145,7 +223,22 @@ public:
     double get_bytes_allocated() { return _profile.bytes_allocated; }
     double get_bytes_freed() { return _profile.bytes_freed; }
     apex_profile_type get_type() { return _profile.type; }
+    /* The live values, which may change while they are read, see read() */
     apex_profile * get_profile() { return &_profile; };
+    /* The shared memory entry is -1 until a thread claims the profile
+     * (see claim_shared_index()) and sets it. */
+    int get_shared_index() {
+        return _shared_index.load(std::memory_order_acquire);
+    }
+    void set_shared_index(int index) {
+        _shared_index.store(index, std::memory_order_release);
+    }
+    /* Only one of the threads updating a new profile assigns its entry */
+    bool claim_shared_index() {
+        int none = -1;
+        return _shared_index.compare_exchange_strong(none, -2,
+            std::memory_order_acq_rel);
+    }
 
 };
 
@@ -0,0 +1,291 @@
+/*
+ * Copyright (c) 2014-2021 Kevin Huck
+ * Copyright (c) 2014-2021 University of Oregon
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include "profile_snapshot.hpp"
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <future>
+
+namespace apex {
+
+const char * snapshot_column_name(snapshot_column c) {
+    static const char * names[SNAPSHOT_NUM_COLUMNS] = {
+        "calls", "accumulated", "sum_squares", "minimum", "maximum",
+        "allocations", "frees", "bytes_allocated", "bytes_freed" };
+    return names[c];
+}
+
+void profile_snapshot::add(const std::string &name, uint64_t type,
+    const double * values) {
+    auto it = _index.find(name);
+    if (it == _index.end()) {
+        _index[name] = names.size();
+        names.push_back(name);
+        types.push_back(type);
+        for (int c = 0 ; c < SNAPSHOT_NUM_COLUMNS ; c++) {
+            columns[c].push_back(values[c]);
+        }
+        return;
+    }
+    size_t i = it->second;
+    // rows with no calls don't have a meaningful min/max
+    bool empty = columns[SNAPSHOT_CALLS][i] == 0.0;
+    bool incoming = values[SNAPSHOT_CALLS] != 0.0;
+    for (int c = 0 ; c < SNAPSHOT_NUM_COLUMNS ; c++) {
+        double& current = columns[c][i];
+        switch (c) {
+            case SNAPSHOT_MINIMUM:
+                if (incoming && (empty || values[c] < current)) {
+                    current = values[c];
+                }
+                break;
+            case SNAPSHOT_MAXIMUM:
+                if (incoming && (empty || values[c] > current)) {
+                    current = values[c];
+                }
+                break;
+            default:
+                current += values[c];
+                break;
+        }
+    }
+}
+
+void profile_snapshot::add(const std::string &name, apex_profile &p) {
+    double values[SNAPSHOT_NUM_COLUMNS];
+    values[SNAPSHOT_CALLS] = p.calls;
+    values[SNAPSHOT_ACCUMULATED] = p.accumulated;
+    values[SNAPSHOT_SUM_SQUARES] = p.sum_squares;
+    values[SNAPSHOT_MINIMUM] = p.minimum;
+    values[SNAPSHOT_MAXIMUM] = p.maximum;
+    values[SNAPSHOT_ALLOCATIONS] = (double)p.allocations;
+    values[SNAPSHOT_FREES] = (double)p.frees;
+    values[SNAPSHOT_BYTES_ALLOCATED] = (double)p.bytes_allocated;
+    values[SNAPSHOT_BYTES_FREED] = (double)p.bytes_freed;
+    add(name, (uint64_t)p.type, values);
+}
+
+void profile_snapshot::merge(const profile_snapshot &other) {
+    double values[SNAPSHOT_NUM_COLUMNS];
+    for (size_t i = 0 ; i < other.size() ; i++) {
+        for (int c = 0 ; c < SNAPSHOT_NUM_COLUMNS ; c++) {
+            values[c] = other.columns[c][i];
+        }
+        add(other.names[i], other.types[i], values);
+    }
+}
+
+void profile_snapshot::merge(const snapshot_reader &other) {
+    double values[SNAPSHOT_NUM_COLUMNS];
+    const double * cols[SNAPSHOT_NUM_COLUMNS];
+    for (int c = 0 ; c < SNAPSHOT_NUM_COLUMNS ; c++) {
+        cols[c] = other.column((snapshot_column)c);
+    }
+    for (size_t i = 0 ; i < other.size() ; i++) {
+        for (int c = 0 ; c < SNAPSHOT_NUM_COLUMNS ; c++) {
+            values[c] = cols[c][i];
+        }
+        add(other.name(i), other.type(i), values);
+    }
+}
+
+static inline uint64_t align8(uint64_t offset) {
+    return (offset + 7) & ~((uint64_t)7);
+}
+
+bool profile_snapshot::write(const std::string &filename) const {
+    // lay out the file
+    uint64_t n = names.size();
+    snapshot_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, snapshot_magic, sizeof(header.magic));
+    header.version = snapshot_version;
+    header.node_id = node_id;
+    header.num_profiles = n;
+    uint64_t offset = align8(sizeof(snapshot_header));
+    header.names_offset = offset;
+    offset += n * sizeof(uint64_t);
+    header.types_offset = offset;
+    offset += n * sizeof(uint64_t);
+    for (int c = 0 ; c < SNAPSHOT_NUM_COLUMNS ; c++) {
+        header.column_offsets[c] = offset;
+        offset += n * sizeof(double);
+    }
+    header.strings_offset = offset;
+    for (auto &name : names) {
+        header.strings_size += name.size() + 1;
+    }
+    header.file_size = align8(offset + header.strings_size);
+
+    // fill in one buffer, so the file can be written in one call
+    std::vector<char> buffer(header.file_size, 0);
+    char * base = buffer.data();
+    memcpy(base, &header, sizeof(header));
+    uint64_t * name_offsets = (uint64_t*)(base + header.names_offset);
+    char * strings = base + header.strings_offset;
+    uint64_t string_offset = 0;
+    for (uint64_t i = 0 ; i < n ; i++) {
+        name_offsets[i] = string_offset;
+        memcpy(strings + string_offset, names[i].c_str(), names[i].size() + 1);
+        string_offset += names[i].size() + 1;
+    }
+    if (n > 0) {
+        memcpy(base + header.types_offset, types.data(), n * sizeof(uint64_t));
+        for (int c = 0 ; c < SNAPSHOT_NUM_COLUMNS ; c++) {
+            memcpy(base + header.column_offsets[c], columns[c].data(),
+                n * sizeof(double));
+        }
+    }
+
+    FILE * f = fopen(filename.c_str(), "wb");
+    if (f == nullptr) {
+        perror("opening profile snapshot file");
+        return false;
+    }
+    size_t written = fwrite(base, 1, buffer.size(), f);
+    fclose(f);
+    return written == buffer.size();
+}
+
+snapshot_reader::snapshot_reader(const std::string &filename) :
+    _data(nullptr), _size(0), _header(nullptr), _error("") {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        _error = "could not open " + filename;
+        return;
+    }
+    struct stat sb;
+    if (fstat(fd, &sb) != 0 || (size_t)sb.st_size < sizeof(snapshot_header)) {
+        _error = filename + " is not a profile snapshot";
+        close(fd);
+        return;
+    }
+    _size = sb.st_size;
+    _data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (_data == MAP_FAILED) {
+        _data = nullptr;
+        _error = "could not map " + filename;
+        return;
+    }
+    const snapshot_header * header = (const snapshot_header*)_data;
+    if (memcmp(header->magic, snapshot_magic, sizeof(snapshot_magic)) != 0) {
+        _error = filename + " is not a profile snapshot";
+        return;
+    }
+    if (header->version != snapshot_version) {
+        _error = filename + " has an unsupported snapshot version";
+        return;
+    }
+    if (header->file_size > _size || !check(header)) {
+        _error = filename + " is truncated or corrupt";
+        return;
+    }
+    _header = header;
+}
+
+/* Is this section inside the file, and 8-byte aligned? */
+bool snapshot_reader::fits(uint64_t offset, uint64_t length) const {
+    return offset % 8 == 0 && offset <= _size && length <= _size - offset;
+}
+
+/* Check every offset in the file before any of them is used, so a
+ * truncated or corrupt snapshot can't make us read past the end. */
+bool snapshot_reader::check(const snapshot_header * header) const {
+    uint64_t n = header->num_profiles;
+    if (n > _size / sizeof(uint64_t)) { return false; }
+    uint64_t length = n * sizeof(uint64_t);
+    if (!fits(header->names_offset, length) ||
+        !fits(header->types_offset, length)) {
+        return false;
+    }
+    for (int c = 0 ; c < SNAPSHOT_NUM_COLUMNS ; c++) {
+        if (!fits(header->column_offsets[c], n * sizeof(double))) {
+            return false;
+        }
+    }
+    // the strings don't have to be aligned
+    if (header->strings_offset > _size ||
+        header->strings_size > _size - header->strings_offset) {
+        return false;
+    }
+    const char * base = (const char*)_data;
+    const char * strings = base + header->strings_offset;
+    if (n > 0 && (header->strings_size == 0 ||
+        strings[header->strings_size - 1] != 0)) {
+        return false;
+    }
+    // every name starts inside the string table, which ends with a NUL
+    const uint64_t * offsets = (const uint64_t*)(base + header->names_offset);
+    for (uint64_t i = 0 ; i < n ; i++) {
+        if (offsets[i] >= header->strings_size) { return false; }
+    }
+    return true;
+}
+
+snapshot_reader::~snapshot_reader(void) {
+    if (_data != nullptr) {
+        munmap(_data, _size);
+    }
+}
+
+const char * snapshot_reader::name(size_t i) const {
+    const char * base = (const char*)_data;
+    const uint64_t * offsets = (const uint64_t*)(base + _header->names_offset);
+    return base + _header->strings_offset + offsets[i];
+}
+
+uint64_t snapshot_reader::type(size_t i) const {
+    const char * base = (const char*)_data;
+    return ((const uint64_t*)(base + _header->types_offset))[i];
+}
+
+const double * snapshot_reader::column(snapshot_column c) const {
+    const char * base = (const char*)_data;
+    return (const double*)(base + _header->column_offsets[c]);
+}
+
+/* Each thread merges a contiguous slice of the files, and then the
+ * partial results are merged together. */
+profile_snapshot merge_snapshots(const std::vector<std::string> &filenames,
+    unsigned int num_threads) {
+    num_threads = std::max(1u, std::min(num_threads,
+        (unsigned int)filenames.size()));
+    size_t chunk = (filenames.size() + num_threads - 1) / num_threads;
+    auto merge_slice = [&filenames](size_t first, size_t last) {
+        profile_snapshot partial;
+        for (size_t i = first ; i < last ; i++) {
+            snapshot_reader reader(filenames[i]);
+            if (!reader.valid()) {
+                fprintf(stderr, "Skipping %s\n", reader.error().c_str());
+                continue;
+            }
+            partial.merge(reader);
+        }
+        return partial;
+    };
+    std::vector<std::future<profile_snapshot> > partials;
+    for (size_t first = 0 ; first < filenames.size() ; first += chunk) {
+        size_t last = std::min(first + chunk, filenames.size());
+        partials.push_back(std::async(std::launch::async, merge_slice,
+            first, last));
+    }
+    profile_snapshot result;
+    for (auto &p : partials) {
+        result.merge(p.get());
+    }
+    return result;
+}
+
+}
+
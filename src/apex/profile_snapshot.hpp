@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2014-2021 Kevin Huck
+ * Copyright (c) 2014-2021 University of Oregon
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+
+/* Binary profile snapshots.
+ *
+ * A snapshot is a versioned, columnar file with one row per timer/counter.
+ * The layout is:
+ *   snapshot_header
+ *   uint64_t name_offsets[num_profiles]   (offsets into the string table)
+ *   uint64_t types[num_profiles]          (apex_profile_type values)
+ *   double   <column>[num_profiles]       (one array per snapshot_column)
+ *   char     strings[strings_size]        (NUL-terminated names)
+ * All sections are 8-byte aligned, so the file can be mapped into memory
+ * and the columns used in place.  The whole file is written with one call.
+ */
+
+#include "apex_types.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace apex {
+
+enum snapshot_column {
+    SNAPSHOT_CALLS = 0,
+    SNAPSHOT_ACCUMULATED,
+    SNAPSHOT_SUM_SQUARES,
+    SNAPSHOT_MINIMUM,
+    SNAPSHOT_MAXIMUM,
+    SNAPSHOT_ALLOCATIONS,
+    SNAPSHOT_FREES,
+    SNAPSHOT_BYTES_ALLOCATED,
+    SNAPSHOT_BYTES_FREED,
+    SNAPSHOT_NUM_COLUMNS
+};
+
+const char * snapshot_column_name(snapshot_column c);
+
+static const char snapshot_magic[8] = {'A','P','E','X','S','N','A','P'};
+static const uint32_t snapshot_version = 1;
+static const char snapshot_filename[] = "apex_profile.";
+static const char snapshot_extension[] = ".snap";
+
+struct snapshot_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t node_id;
+    uint64_t num_profiles;
+    uint64_t file_size;
+    uint64_t names_offset;
+    uint64_t types_offset;
+    uint64_t strings_offset;
+    uint64_t strings_size;
+    uint64_t column_offsets[SNAPSHOT_NUM_COLUMNS];
+};
+
+class snapshot_reader;
+
+/* An in-memory snapshot, used to build a file or to merge several. */
+class profile_snapshot {
+private:
+    std::unordered_map<std::string, size_t> _index;
+public:
+    uint32_t node_id;
+    std::vector<std::string> names;
+    std::vector<uint64_t> types;
+    std::vector<double> columns[SNAPSHOT_NUM_COLUMNS];
+    profile_snapshot(uint32_t node = 0) : node_id(node) {}
+    size_t size(void) const { return names.size(); }
+    /* Add a row, or combine it with the existing row of the same name */
+    void add(const std::string &name, uint64_t type, const double * values);
+    void add(const std::string &name, apex_profile &p);
+    void merge(const profile_snapshot &other);
+    void merge(const snapshot_reader &other);
+    bool write(const std::string &filename) const;
+};
+
+/* Read-only view of a snapshot file, mapped into memory. */
+class snapshot_reader {
+private:
+    void * _data;
+    size_t _size;
+    const snapshot_header * _header;
+    std::string _error;
+    bool fits(uint64_t offset, uint64_t length) const;
+    bool check(const snapshot_header * header) const;
+public:
+    snapshot_reader(const std::string &filename);
+    ~snapshot_reader(void);
+    snapshot_reader(const snapshot_reader&) = delete;
+    snapshot_reader& operator=(const snapshot_reader&) = delete;
+    bool valid(void) const { return _header != nullptr; }
+    const std::string& error(void) const { return _error; }
+    uint32_t node_id(void) const { return _header->node_id; }
+    size_t size(void) const { return _header->num_profiles; }
+    const char * name(size_t i) const;
+    uint64_t type(size_t i) const;
+    const double * column(snapshot_column c) const;
+};
+
+/* Merge any number of snapshot files, using up to num_threads threads. */
+profile_snapshot merge_snapshots(const std::vector<std::string> &filenames,
+    unsigned int num_threads);
+
+}
+
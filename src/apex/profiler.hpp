@@ -21,6 +21,7 @@ class profiler;
 // #include "apex_assert.h"
 #include <chrono>
 #include <memory>
+#include <atomic>
 #include "task_wrapper.hpp"
 
 namespace apex {
@@ -37,12 +38,6 @@ class disabled_profiler_exception : public std::exception {
     }
 };
 
-#ifdef APEX_USE_CLOCK_TIMESTAMP
-#define APEX_THROTTLE_PERCALL 0.00001 // 10 microseconds.
-#else
-#define APEX_THROTTLE_PERCALL 50000 // 50k cycles.
-#endif
-
 #define MYCLOCK std::chrono::system_clock
 
 class profiler {
@@ -63,10 +58,12 @@ public:
     double value;
     double children_value;
     uint64_t guid;
+    uint32_t sample_period; // this call stands for sample_period calls
     bool is_counter;
     bool is_resume; // for yield or resume
     reset_type is_reset;
     bool stopped;
+    bool traced; // started inside a trace window, see begin_trace_window
     task_identifier * get_task_id(void) {
         return task_id;
     }
@@ -88,9 +85,11 @@ public:
         value(0.0),
         children_value(0.0),
         guid(task->guid),
+        sample_period(1),
         is_counter(false),
         is_resume(resume),
-        is_reset(reset), stopped(false) { task->prof = this; };
+        is_reset(reset), stopped(false),
+        traced(in_trace_window(start_ns)) { task->prof = this; };
     // this constructor is for resetting profile values
     profiler(task_identifier * id,
              bool resume = false,
@@ -106,9 +105,10 @@ public:
         value(0.0),
         children_value(0.0),
         guid(0),
+        sample_period(1),
         is_counter(false),
         is_resume(resume),
-        is_reset(reset), stopped(false) { };
+        is_reset(reset), stopped(false), traced(false) { };
     // this constructor is for counters
     profiler(task_identifier * id, double value_) :
         task_id(id),
@@ -121,9 +121,10 @@ public:
         allocations(0), frees(0), bytes_allocated(0), bytes_freed(0),
         value(value_),
         children_value(0.0),
+        sample_period(1),
         is_counter(true),
         is_resume(false),
-        is_reset(reset_type::NONE), stopped(true) { };
+        is_reset(reset_type::NONE), stopped(true), traced(false) { };
     //copy constructor
     profiler(const profiler& in) :
         task_id(in.task_id),
@@ -137,10 +138,12 @@ public:
         value(in.value),
         children_value(in.children_value),
         guid(in.guid),
+        sample_period(in.sample_period),
         is_counter(in.is_counter),
         is_resume(in.is_resume), // for yield or resume
         is_reset(in.is_reset),
-        stopped(in.stopped)
+        stopped(in.stopped),
+        traced(in.traced)
     {
         //printf("COPY!\n"); fflush(stdout);
 #if APEX_HAVE_PAPI
@@ -170,6 +173,8 @@ public:
     void restart() {
         this->is_resume = true;
         start_ns = now_ns();
+        // the yield ended the last traced segment, so decide again
+        traced = in_trace_window(start_ns);
     };
     uint64_t get_start_ns() {
         return start_ns;
@@ -232,6 +237,15 @@ public:
         static uint64_t global_now = now_ns();
         return global_now;
     }
+    /* With APEX_TRACE_WINDOWS, the tracing listeners only see timers that
+     * start before this time.  0 means no window is open. */
+    static std::atomic<uint64_t>& trace_window_end(void) {
+        static std::atomic<uint64_t> end(UINT64_MAX);
+        return end;
+    }
+    static bool in_trace_window(uint64_t stamp) {
+        return stamp < trace_window_end().load(std::memory_order_relaxed);
+    }
     /* this is for getting the endpoint of the trace. */
     static uint64_t get_global_end(void) {
         return now_ns();
@@ -51,11 +51,11 @@
 #include <thread>
 #include <future>
 
-#if defined(APEX_THROTTLE)
-#include "apex_cxx_shared_lock.hpp"
-apex::shared_mutex_type throttled_event_set_mutex;
-#define APEX_THROTTLE_CALLS 1000
-#endif
+/* Timers are not sampled until they have been called this many times */
+#define APEX_SAMPLING_MIN_CALLS 1000
+#define APEX_MAX_SAMPLE_PERIOD 65536
+/* Measure APEX's own cost on one in this many stops */
+#define APEX_OVERHEAD_MEASURE_PERIOD 64
 
 #if APEX_HAVE_PAPI
 #include "papi.h"
@@ -80,6 +80,12 @@ const int num_non_worker_threads_registered = 1; // including the main thread
 
 #include "tau_listener.hpp"
 #include "utils.hpp"
+#include "profile_snapshot.hpp"
+#include "scatterplot_samples.hpp"
+#include "queue_wait.hpp"
+#ifdef APEX_HAVE_BFD
+#include "address_resolution.hpp"
+#endif
 
 #include <cstdlib>
 #include <ctime>
@@ -119,21 +125,20 @@ std::unordered_set<profile*> free_profiles;
     }
 
     /* We do this in two stages, to make the common case fast. */
-    dependency_queue_t * profiler_listener::_construct_dependency_queue() {
-        dependency_queue_t * _thequeue = new dependency_queue_t();
+    taskgraph_edges * profiler_listener::_construct_taskgraph_edges() {
+        taskgraph_edges * _edges = new taskgraph_edges();
         /* We are locking to make sure the vector is only updated by
          * one thread at a time. */
         std::unique_lock<std::mutex> queue_lock(queue_mtx);
-        dependency_queues.push_back(_thequeue);
-        return _thequeue;
+        taskgraph_tables.push_back(_edges);
+        return _edges;
     }
-    /* this is a thread-local pointer to a concurrent queue for each worker thread. */
-    dependency_queue_t * profiler_listener::dependency_queue() {
-        /* This constructor gets called once per thread, the first time this
-         * function is executed (by each thread). */
-        static APEX_NATIVE_TLS dependency_queue_t * _thequeue =
-            _construct_dependency_queue();
-        return _thequeue;
+    /* this is a thread-local pointer to the task graph edge counts for
+     * each worker thread. */
+    taskgraph_edges * profiler_listener::my_taskgraph_edges() {
+        static APEX_NATIVE_TLS taskgraph_edges * _edges =
+            _construct_taskgraph_edges();
+        return _edges;
     }
 
   /* Flag indicating whether a consumer task is currently running */
@@ -149,19 +154,6 @@ std::unordered_set<profile*> free_profiles;
     std::unique_lock<std::mutex> task_map_lock(_task_map_mutex);
     for(it2 = task_map.begin(); it2 != task_map.end(); it2++) {
       profile * p = it2->second;
-#if defined(APEX_THROTTLE)
-      if (!apex_options::use_tau()) {
-        task_identifier id = it2->first;
-        unordered_set<task_identifier>::const_iterator it4;
-        {
-              read_lock_type l(throttled_event_set_mutex);
-              it4 = throttled_tasks.find(id);
-        }
-        if (it4!= throttled_tasks.end()) {
-            continue;
-        }
-      }
-#endif
       if (p->get_type() == APEX_TIMER) {
         non_idle_time += p->get_accumulated();
       }
@@ -239,10 +231,48 @@ std::unordered_set<profile*> free_profiles;
     return nullptr;
   }
 
+  bool profiler_listener::get_profile(const task_identifier &id,
+    apex_profile &values) {
+    profile * p = get_profile(id);
+    if (p == nullptr) { return false; }
+    p->read(values);
+    return true;
+  }
+
+  /* Copy every profile in one pass.  The version is the total number of
+   * updates, so if it hasn't changed (and no profile was created), the last
+   * set is still current and is shared instead of copied again. */
+  std::shared_ptr<const profile_set> profiler_listener::snapshot_profiles() {
+    std::unique_lock<std::mutex> task_map_lock(_task_map_mutex);
+    uint64_t version = 0;
+    for (auto &kv : task_map) {
+      version += kv.second->updates();
+    }
+    if (_last_snapshot != nullptr && _last_snapshot->version == version &&
+        _last_snapshot->size() == task_map.size()) {
+      return _last_snapshot;
+    }
+    std::shared_ptr<profile_set> set = std::make_shared<profile_set>();
+    set->ids.reserve(task_map.size());
+    set->profiles.resize(task_map.size());
+    size_t i = 0;
+    for (auto &kv : task_map) {
+      set->ids.push_back(kv.first);
+      set->version += kv.second->read(set->profiles[i++]);
+    }
+    _last_snapshot = set;
+    return set;
+  }
+
   void profiler_listener::reset_all(void) {
+    queue_wait_reset();
     std::unique_lock<std::mutex> task_map_lock(_task_map_mutex);
     for(auto &it : task_map) {
         it.second->reset();
+        if (_shared_profiles != nullptr) {
+            task_identifier id = it.first;
+            _shared_profiles->update(&id, it.second);
+        }
     }
     if (apex_options::use_jupyter_support()) {
         // restart the main timer
@@ -295,44 +325,15 @@ std::unordered_set<profile*> free_profiles;
             if (apex_options::track_memory()) {
                 theprofile->increment(p.elapsed(), tmp_num_counters,
                     values, p.allocations, p.frees, p.bytes_allocated,
-                    p.bytes_freed, p.is_resume);
+                    p.bytes_freed, p.is_resume, p.sample_period);
             } else {
                 theprofile->increment(p.elapsed(), tmp_num_counters,
-                    values, p.is_resume);
+                    values, p.is_resume, p.sample_period);
             }
         }
-#if defined(APEX_THROTTLE)
-        if (!apex_options::use_tau()) {
-          // Is this a lightweight task? If so, we shouldn't measure it any more,
-          // in order to reduce overhead.
-          if (theprofile->get_calls() > APEX_THROTTLE_CALLS &&
-              theprofile->get_mean() < APEX_THROTTLE_PERCALL) {
-              unordered_set<task_identifier>::const_iterator it2;
-              {
-                  read_lock_type l(throttled_event_set_mutex);
-                it2 = throttled_tasks.find(*(p.get_task_id()));
-              }
-              if (it2 == throttled_tasks.end()) {
-                  // lock the set for insert
-                  {
-                        write_lock_type l(throttled_event_set_mutex);
-                      // was it inserted when we were waiting?
-                      it2 = throttled_tasks.find(*(p.get_task_id()));
-                      // no? OK - insert it.
-                      if (it2 == throttled_tasks.end()) {
-                          throttled_tasks.insert(*(p.get_task_id()));
-                      }
-                  }
-                  if (apex_options::use_verbose()) {
-                      cout << "APEX: disabling lightweight timer "
-                           << p.get_task_id()->get_name()
-                            << endl;
-                      fflush(stdout);
-                  }
-              }
-          }
+        if (!p.is_counter && !p.is_resume) {
+            update_sample_period(p.get_task_id(), theprofile);
         }
-#endif
       } else {
         // Create a new profile for this name.
         if (apex_options::track_memory() && !p.is_counter) {
@@ -375,38 +376,14 @@ std::unordered_set<profile*> free_profiles;
 #endif
 #endif
       }
-      /* write the sample to the file */
+      /* publish the new values to the live (shared memory) profile */
+      if (_shared_profiles != nullptr) {
+        _shared_profiles->update(p.get_task_id(), theprofile);
+      }
+      /* keep a sample for the scatterplot */
       if (apex_options::task_scatterplot()) {
-        if (!p.is_counter) {
-            static int thresh = std::round((double)(RAND_MAX) * apex_options::scatterplot_fraction());
-            if (std::rand() < thresh) {
-                /* before calling p.get_task_id()->get_name(), make sure we create
-                 * a thread_instance object that is NOT a worker. */
-                thread_instance::instance(false);
-                std::unique_lock<std::mutex> task_map_lock(_mtx);
-                task_scatterplot_samples << p.normalized_timestamp() << " "
-                            << p.elapsed() << " "
-                            << "'" << p.get_task_id()->get_name() << "'" << endl;
-                int loc0 = task_scatterplot_samples.tellp();
-                if (loc0 > 32768) {
-                    task_scatterplot_sample_file() << task_scatterplot_samples.rdbuf();
-                    // reset the stringstream
-                    task_scatterplot_samples.str("");
-                }
-            }
-        } else {
-                thread_instance::instance(false);
-                std::unique_lock<std::mutex> task_map_lock(_mtx);
-                counter_scatterplot_samples << p.normalized_timestamp() << " "
-                            << p.elapsed() << " "
-                            << "'" << p.get_task_id()->get_name() << "'" << endl;
-                int loc0 = task_scatterplot_samples.tellp();
-                if (loc0 > 32768) {
-                    counter_scatterplot_sample_file() << counter_scatterplot_samples.rdbuf();
-                    // reset the stringstream
-                    counter_scatterplot_samples.str("");
-                }
-	}
+        scatterplot_add(p.get_task_id(), p.normalized_timestamp(),
+          p.elapsed(), p.is_counter);
       }
     if (apex_options::use_tasktree_output() && !p.is_counter && p.tt_ptr != nullptr) {
         p.tt_ptr->tree_node->addAccumulated(p.elapsed_seconds(), p.is_resume);
@@ -414,33 +391,27 @@ std::unordered_set<profile*> free_profiles;
     return 1;
   }
 
-  inline unsigned int profiler_listener::process_dependency(task_dependency* td)
-  {
-      unordered_map<task_identifier,
-        unordered_map<task_identifier,
-        int>* >::const_iterator it = task_dependencies.find(td->parent);
-      unordered_map<task_identifier, int> * depend;
-      // if this is a new dependency for this parent?
-      if (it == task_dependencies.end()) {
-          depend = new unordered_map<task_identifier, int>();
-          (*depend)[td->child] = 1;
-          task_dependencies[td->parent] = depend;
-      // otherwise, see if this parent has seen this child
-      } else {
-          depend = it->second;
-          unordered_map<task_identifier, int>::const_iterator it2 =
-            depend->find(td->child);
-          // first time for this child
-          if (it2 == depend->end()) {
-              (*depend)[td->child] = 1;
-          // not the first time for this child
-          } else {
-              int tmp = it2->second;
-              (*depend)[td->child] = tmp + 1;
+  /* Each thread counts its own edges by identifier pointer.  Every thread
+   * has its own task_identifier objects, so merge them by value. */
+  void profiler_listener::merge_taskgraph_edges(void) {
+      std::unique_lock<std::mutex> queue_lock(queue_mtx);
+      for (auto table : taskgraph_tables) {
+          std::unique_lock<std::mutex> l(table->lock);
+          for (auto &kv : table->counts) {
+              const task_identifier& parent = *(kv.first.first);
+              const task_identifier& child = *(kv.first.second);
+              unordered_map<task_identifier, int> * depend;
+              auto it = task_dependencies.find(parent);
+              if (it == task_dependencies.end()) {
+                  depend = new unordered_map<task_identifier, int>();
+                  task_dependencies[parent] = depend;
+              } else {
+                  depend = it->second;
+              }
+              (*depend)[child] += (int)(kv.second);
           }
+          table->counts.clear();
       }
-      delete(td);
-      return 1;
   }
 
   /* Cleaning up memory. Not really necessary, because it only gets
@@ -498,22 +469,6 @@ std::unordered_set<profile*> free_profiles;
       } else {
           screen_output << string_format("%41s", shorter.c_str()) << " : ";
       }
-#if defined(APEX_THROTTLE)
-      if (!apex_options::use_tau()) {
-        // if this profile was throttled, don't output the measurements.
-        // they are limited and bogus, anyway.
-        unordered_set<task_identifier>::const_iterator it4;
-        {
-              read_lock_type l(throttled_event_set_mutex);
-            it4 = throttled_tasks.find(task_id);
-          }
-        if (it4!= throttled_tasks.end()) {
-            screen_output << "DISABLED (high frequency, short duration)"
-                << endl;
-            return;
-        }
-      }
-#endif
       if(p->get_calls() == 0 && p->get_times_reset() > 0) {
             screen_output << "Not called since reset." << endl;
             return;
@@ -808,6 +763,9 @@ std::unordered_set<profile*> free_profiles;
     total_ss << std::fixed << ((uint64_t)total_hpx_threads);
         screen_output << total_ss.str() << std::endl;
     //}
+    if (apex_options::use_queue_wait()) {
+        screen_output << queue_wait_report();
+    }
     if (apex_options::use_screen_output() && node_id == 0) {
         cout << screen_output.str();
         data.output = screen_output.str();
@@ -829,16 +787,8 @@ std::unordered_set<profile*> free_profiles;
 
   void profiler_listener::write_taskgraph(void) {
     std::cout << "Writing APEX taskgraph..." << std::endl;
-    { // we need to lock in case another thread appears
-        std::unique_lock<std::mutex> queue_lock(queue_mtx);
-        // get all the remaining dependencies
-        task_dependency* td;
-        for (auto a_queue : dependency_queues) {
-            while(a_queue->try_dequeue(td)) {
-                process_dependency(td);
-            }
-        }
-    }
+    // get all the edges counted so far
+    merge_taskgraph_edges();
 
     /* before calling parent.get_name(), make sure we create
      * a thread_instance object that is NOT a worker. */
@@ -1090,6 +1040,44 @@ std::unordered_set<profile*> free_profiles;
     myfile.close();
   }
 
+  /* Write one binary, columnar snapshot of all profiles for this process.
+   * See profile_snapshot.hpp for the format. */
+  void profiler_listener::write_snapshot() {
+    stringstream filename;
+    filename << apex_options::output_file_path();
+    filename << filesystem_separator() << snapshot_filename << node_id
+             << snapshot_extension;
+    profile_snapshot snapshot(node_id);
+    {
+      std::unique_lock<std::mutex> task_map_lock(_task_map_mutex);
+      for (auto& kv : task_map) {
+        task_identifier task_id = kv.first;
+        apex_profile values;
+        kv.second->read(values);
+        snapshot.add(task_id.get_name(), values);
+      }
+    }
+    snapshot.write(filename.str());
+  }
+
+  /* Write the sampled timers and counters for the scatterplots.
+   * See scatterplot_samples.hpp for the format. */
+  void profiler_listener::write_scatterplot_samples() {
+    /* before calling get_name(), make sure we create
+     * a thread_instance object that is NOT a worker. */
+    thread_instance::instance(false);
+    stringstream tasks;
+    tasks << apex_options::output_file_path() << filesystem_separator()
+          << task_scatterplot_sample_filename << node_id
+          << scatterplot_extension;
+    scatterplot_write(tasks.str(), false);
+    stringstream counters;
+    counters << apex_options::output_file_path() << filesystem_separator()
+             << counter_scatterplot_sample_filename << node_id
+             << scatterplot_extension;
+    scatterplot_write(counters.str(), true);
+  }
+
   /*
    * The main function for the consumer thread has to be static, but
    * the processing needs access to member variables, so get the
@@ -1166,7 +1154,6 @@ std::unordered_set<profile*> free_profiles;
     */
 
     std::shared_ptr<profiler> p;
-    task_dependency* td;
 #ifdef APEX_HAVE_HPX
     //bool schedule_another_task = false;
     {
@@ -1188,25 +1175,6 @@ std::unordered_set<profile*> free_profiles;
             }
         }
     }
-    if (apex_options::use_taskgraph_output()) {
-        size_t num_queues = 0;
-        {
-            std::unique_lock<std::mutex> queue_lock(queue_mtx);
-            num_queues = dependency_queues.size();
-        }
-        for (size_t q = 0 ; q < num_queues ; q++) {
-            int i = 0;
-            while(!_done && dependency_queues[q]->try_dequeue(td)) {
-                process_dependency(td);
-                /*
-                if (++i > 1000 && !synchronous_flush) {
-                    schedule_another_task = true;
-                    break;
-                }
-                */
-            }
-        }
-    }
 #else
     // Main loop. Stay in this loop unless "done".
     while (!_done) {
@@ -1227,18 +1195,6 @@ std::unordered_set<profile*> free_profiles;
                 }
             }
         }
-        if (apex_options::use_taskgraph_output()) {
-            size_t num_queues = 0;
-                std::unique_lock<std::mutex> queue_lock(queue_mtx);
-            {
-                num_queues = dependency_queues.size();
-            }
-            for (size_t q = 0 ; q < num_queues ; q++) {
-                while(!_done && dependency_queues[q]->try_dequeue(td)) {
-                    process_dependency(td);
-                }
-            }
-        }
         if (apex_options::use_tau()) {
             tau_listener::Tau_stop_wrapper(
                 "profiler_listener::process_profiles: main loop");
@@ -1343,6 +1299,14 @@ if (rc != 0) cout << "PAPI error! " << name << ": " << PAPI_strerror(rc) << endl
       event_sets[0] = EventSet;
 #endif
 
+      if (apex_options::use_shared_profile()) {
+        _shared_profiles = new shared_profile_table();
+        if (!_shared_profiles->valid()) {
+          delete _shared_profiles;
+          _shared_profiles = nullptr;
+        }
+      }
+
       /* This commented out code is to change the priority of the consumer thread.
        * IDEALLY, I would like to make this a low priority thread, but that is as
        * yet unsuccessful. */
@@ -1418,6 +1382,26 @@ if (rc != 0) cout << "PAPI error! " << name << ": " << PAPI_strerror(rc) << endl
 #endif
 #endif // APEX_SYNCHRONOUS_PROCESSING
 
+#ifdef APEX_HAVE_BFD
+      /* Resolve all of the timer addresses in one batch, rather than
+       * one at a time as each output is written. */
+      {
+        std::vector<uintptr_t> addresses;
+        {
+          std::unique_lock<std::mutex> task_map_lock(_task_map_mutex);
+          for (auto& kv : task_map) {
+            if (!kv.first.has_name &&
+                kv.first.address != APEX_NULL_FUNCTION_ADDRESS) {
+              addresses.push_back(kv.first.address);
+            }
+          }
+        }
+        if (addresses.size() > 0) {
+          resolve_addresses(addresses);
+        }
+      }
+#endif
+
       // output to screen?
       if ((apex_options::use_screen_output() && node_id == 0) ||
            apex_options::use_taskgraph_output() ||
@@ -1480,11 +1464,12 @@ if (rc != 0) cout << "PAPI error! " << name << ": " << PAPI_strerror(rc) << endl
       if (apex_options::use_profile_output() && !apex_options::use_tau()) {
         write_profile();
       }
+      // output a binary snapshot per process?
+      if (apex_options::use_profile_snapshot()) {
+        write_snapshot();
+      }
       if (apex_options::task_scatterplot()) {
-          task_scatterplot_sample_file() << task_scatterplot_samples.rdbuf();
-          task_scatterplot_sample_file().close();
-          counter_scatterplot_sample_file() << counter_scatterplot_samples.rdbuf();
-          counter_scatterplot_sample_file().close();
+          write_scatterplot_samples();
       }
       if (data.reset) {
           reset_all();
@@ -1522,6 +1507,11 @@ if (rc != 0) cout << "PAPI error! " << name << ": " << PAPI_strerror(rc) << endl
       }
 #endif
 #endif // APEX_SYNCHRONOUS_PROCESSING
+      /* readers that are already attached can still see the final
+       * values, but nobody new can attach. */
+      if (_shared_profiles != nullptr) {
+          _shared_profiles->unlink();
+      }
 
     }
   }
@@ -1556,36 +1546,101 @@ if (rc != 0) cout << "PAPI error! " << name << ": " << PAPI_strerror(rc) << endl
 
   extern "C" int main (int, char**);
 
+  /* Decide whether to measure this call to a timer that is sampled one in
+   * sample_period calls (always a power of 2).  Every thread has its own
+   * xorshift generator, so this doesn't touch any shared state. */
+  static inline bool measure_this_call(uint32_t sample_period) {
+      static APEX_NATIVE_TLS uint32_t state = 0;
+      if (state == 0) {
+          state = (uint32_t)(profiler::now_ns() ^
+              (uint64_t)(&state)) | 1;
+      }
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      return (state & (sample_period - 1)) == 0;
+  }
+
+  /* APEX measures its own cost on every APEX_OVERHEAD_MEASURE_PERIOD'th
+   * stop on each thread: the time from when the timer was stopped until
+   * this listener is done with it.  Starting a timer costs about the same,
+   * so a start/stop pair costs twice that.  Keep a moving average. */
+  void profiler_listener::measure_overhead(uint64_t stop_ns) {
+      static APEX_NATIVE_TLS uint32_t countdown = 0;
+      if (countdown > 0) {
+          countdown--;
+          return;
+      }
+      countdown = APEX_OVERHEAD_MEASURE_PERIOD - 1;
+      uint64_t now = profiler::now_ns();
+      if (now <= stop_ns) { return; }
+      uint64_t cost = (now - stop_ns) * 2;
+      uint64_t average = _event_overhead_ns.load(std::memory_order_relaxed);
+      average = average == 0 ? cost : average - (average / 8) + (cost / 8);
+      _event_overhead_ns.store(average, std::memory_order_relaxed);
+  }
+
+  /* Measuring one call in k costs overhead/k per call, so keep
+   * overhead / (k * mean) within the budget.  The period is rounded up to
+   * a power of 2, so it only changes when the mean moves a lot. */
+  void profiler_listener::update_sample_period(task_identifier * id,
+    profile * theprofile) {
+      double budget = apex_options::overhead_budget();
+      /* TAU, the critical path analysis and the traces need to see every
+       * call, and the listeners after this one only see the calls that
+       * are measured. */
+      if (budget <= 0.0 || apex_options::use_tau() ||
+          apex_options::use_critical_path() ||
+          apex_options::use_otf2() ||
+          apex_options::use_trace_event() ||
+          apex_options::use_trace_windows() ||
+          apex_options::use_flight_recorder() ||
+          apex_options::use_record_events()) { return; }
+      if (theprofile->get_calls() < APEX_SAMPLING_MIN_CALLS) { return; }
+      double overhead = (double)(_event_overhead_ns.load(
+          std::memory_order_relaxed));
+      double mean = theprofile->get_mean();
+      if (overhead == 0.0 || mean <= 0.0) { return; }
+      double wanted = overhead / (budget * mean);
+      uint32_t period = 1;
+      while (period < wanted && period < APEX_MAX_SAMPLE_PERIOD) {
+          period = period << 1;
+      }
+      if (period == id->sample_period.load(std::memory_order_relaxed)) {
+          return;
+      }
+      id->sample_period.store(period, std::memory_order_relaxed);
+      if (apex_options::use_verbose()) {
+          cout << "APEX: measuring 1 in " << period << " calls to "
+               << id->get_name() << endl;
+          fflush(stdout);
+      }
+  }
+
   /* When a start event happens, create a profiler object. Unless this
-   * named event is throttled, in which case do nothing, as quickly as possible */
+   * timer is sampled and this call isn't one of the samples, in which case
+   * do nothing, as quickly as possible */
   inline bool profiler_listener::_common_start(std::shared_ptr<task_wrapper>
     &tt_ptr, bool is_resume) {
     if (!_done) {
-#if defined(APEX_THROTTLE)
-      if (!apex_options::use_tau()) {
-        // if this timer is throttled, return without doing anything
-        unordered_set<task_identifier>::const_iterator it;
-        {
-              read_lock_type l(throttled_event_set_mutex);
-            it = throttled_tasks.find(*tt_ptr->get_task_id());
-        }
-        if (it != throttled_tasks.end()) {
-            /*
-            * The throw is removed, because it is a performance penalty on some
-            * systems on_start now returns a boolean
-            */
-            // to be caught by apex::start/resume
-            //throw disabled_profiler_exception();
-            return false;
-        }
+      // if this timer is sampled, skip all but one in sample_period calls
+      // to it.  Resumed tasks are always measured.
+      uint32_t sample_period = 1;
+      if (!is_resume) {
+          sample_period = tt_ptr->get_task_id()->sample_period.load(
+              std::memory_order_relaxed);
+          if (sample_period > 1 && !measure_this_call(sample_period)) {
+              // to be caught by apex::start
+              return false;
+          }
       }
-#endif
       // start the profiler object, which starts our timers
       //std::shared_ptr<profiler> p = std::make_shared<profiler>(tt_ptr,
       //is_resume);
       // get the right task identifier, based on whether there are aliases
       profiler * p = new profiler(tt_ptr, is_resume);
       p->guid = tt_ptr->guid;
+      p->sample_period = sample_period;
       thread_instance::instance().set_current_profiler(p);
 #if APEX_HAVE_PAPI
       if (num_papi_counters > 0 && !apex_options::papi_suspend()) {
@@ -1662,6 +1717,9 @@ if (rc != 0) cout << "PAPI error! " << name << ": " << PAPI_strerror(rc) << endl
         }
 #endif
         push_profiler(my_tid, p);
+        if (apex_options::overhead_budget() > 0.0) {
+            measure_overhead(p->get_stop_ns());
+        }
       }
     }
   }
@@ -1697,29 +1755,55 @@ if (rc != 0) cout << "PAPI error! " << name << ": " << PAPI_strerror(rc) << endl
   void profiler_listener::async_thread_setup(void) {
       // for asynchronous threads, check to make sure there is a queue!
       thequeue();
-      if (apex_options::use_taskgraph_output()) {
-        dependency_queue();
-      }
   }
 
   /* When a sample value is processed, save it as a profiler object, and queue it. */
   void profiler_listener::on_sample_value(sample_value_event_data &data) {
     if (!_done) {
       // don't make a shared pointer if not necessary!
+      // handle-based counters already know their id, skip the lookup
+      task_identifier * id = data.counter_id != nullptr ? data.counter_id :
+        task_identifier::get_task_id(*data.counter_name);
 #ifdef APEX_SYNCHRONOUS_PROCESSING
-      profiler p(task_identifier::get_task_id(
-        *data.counter_name), data.counter_value);
+      profiler p(id, data.counter_value);
       p.is_counter = data.is_counter;
 #else // APEX_SYNCHRONOUS_PROCESSING
       std::shared_ptr<profiler> p =
-        std::make_shared<profiler>(task_identifier::get_task_id(
-        *data.counter_name), data.counter_value);
+        std::make_shared<profiler>(id, data.counter_value);
       p->is_counter = data.is_counter;
 #endif // APEX_SYNCHRONOUS_PROCESSING
       push_profiler(my_tid, p);
     }
   }
 
+  /* Samples taken through a counter handle arrive here in batches, already
+   * aggregated by the thread that took them, so there is no profiler
+   * object to build or queue.  This runs on the application thread, while
+   * the consumer thread may be updating the same profile; both go through
+   * the profile's write lock (see profile::begin_write()). */
+  void profiler_listener::on_sample_aggregate(task_identifier * id,
+    double count, double sum, double sum_squares, double minimum,
+    double maximum) {
+    if (_done) { return; }
+    profile * theprofile;
+    std::unique_lock<std::mutex> task_map_lock(_task_map_mutex);
+    unordered_map<task_identifier, profile*>::const_iterator it =
+        task_map.find(*id);
+    if (it != task_map.end()) {
+        theprofile = (*it).second;
+    } else {
+        // start with no calls, so the first batch sets the min and max
+        double values[8] = {0};
+        theprofile = new profile(0.0, 0, values, true, APEX_COUNTER);
+        task_map[*id] = theprofile;
+    }
+    task_map_lock.unlock();
+    theprofile->increment_aggregate(count, sum, sum_squares, minimum, maximum);
+    if (_shared_profiles != nullptr) {
+      _shared_profiles->update(id, theprofile);
+    }
+  }
+
   void profiler_listener::on_task_complete(std::shared_ptr<task_wrapper>
     &tt_ptr) {
     //printf("New task: %llu\n", task_id); fflush(stdout);
@@ -1727,13 +1811,13 @@ if (rc != 0) cout << "PAPI error! " << name << ": " << PAPI_strerror(rc) << endl
     // get the right task identifier, based on whether there are aliases
     task_identifier * id = tt_ptr->get_task_id();
     // if the parent task is not null, use it (obviously)
-    if (tt_ptr->parent != nullptr) {
-        task_identifier * pid = tt_ptr->parent->get_task_id();
-        dependency_queue()->enqueue(new task_dependency(pid, id));
-        return;
-    }
-    task_identifier * parent = task_wrapper::get_apex_main_wrapper()->task_id;
-    dependency_queue()->enqueue(new task_dependency(parent, id));
+    task_identifier * parent = tt_ptr->parent_task_id != nullptr ?
+        tt_ptr->parent_task_id :
+        task_wrapper::get_apex_main_wrapper()->task_id;
+    // count the edge on this thread, no allocation unless it is a new edge
+    taskgraph_edges * edges = my_taskgraph_edges();
+    std::unique_lock<std::mutex> l(edges->lock);
+    edges->counts[taskgraph_edges::edge(parent, id)]++;
   }
 
   /* Communication send event. Save the number of bytes. */
@@ -1793,6 +1877,10 @@ if (rc != 0) cout << "PAPI error! " << name << ": " << PAPI_strerror(rc) << endl
       _done = true; // yikes!
       finalize();
       delete_profiles();
+      if (_shared_profiles != nullptr) {
+          delete _shared_profiles;
+          _shared_profiles = nullptr;
+      }
 #ifndef APEX_SYNCHRONOUS_PROCESSING
 #ifndef APEX_HAVE_HPX
 #ifndef APEX_STATIC // unbelievable.  Deleting this object can crash in a static link.
@@ -1806,9 +1894,9 @@ if (rc != 0) cout << "PAPI error! " << name << ": " << PAPI_strerror(rc) << endl
         allqueues.pop_back();
         delete(tmp);
     }
-    while (dependency_queues.size() > 0) {
-        auto tmp = dependency_queues.back();
-        dependency_queues.pop_back();
+    while (taskgraph_tables.size() > 0) {
+        auto tmp = taskgraph_tables.back();
+        taskgraph_tables.pop_back();
         delete(tmp);
     }
     for (auto tmp : free_profiles) {
@@ -52,7 +52,7 @@ using moodycamel::ConcurrentQueue;
 #include "apex_assert.h"
 #include "semaphore.hpp"
 #include "task_identifier.hpp"
-#include "task_dependency.hpp"
+#include "shared_profile.hpp"
 #include <sys/stat.h>
 #if !defined(_MSC_VER)
 //#include <unistd.h>
@@ -76,12 +76,21 @@ public:
   }
 };
 
-class dependency_queue_t : public ConcurrentQueue<task_dependency*> {
+/* The task graph edges seen by one thread, counted by (parent, child)
+ * identifier pointers.  Only the owning thread updates the counts; the
+ * lock is only contended while the graph is being written. */
+class taskgraph_edges {
 public:
-  dependency_queue_t() {}
-  virtual ~dependency_queue_t() {
-      //finalize();
-  }
+  typedef std::pair<task_identifier*, task_identifier*> edge;
+  struct edge_hash {
+    std::size_t operator()(const edge &e) const {
+      std::size_t h1 = std::hash<task_identifier*>()(e.first);
+      std::size_t h2 = std::hash<task_identifier*>()(e.second);
+      return h1 ^ (h2 << 1);
+    }
+  };
+  std::mutex lock;
+  std::unordered_map<edge, uint64_t, edge_hash> counts;
 };
 
 static const char * task_scatterplot_sample_filename = "apex_task_samples.";
@@ -103,15 +112,15 @@ private:
   void write_taskgraph(void);
   void write_tasktree(void);
   void write_profile(void);
+  void write_snapshot(void);
+  void write_scatterplot_samples(void);
   void delete_profiles(void);
 #ifdef APEX_HAVE_HPX
   void schedule_process_profiles(void);
 #endif
   unsigned int process_profile(std::shared_ptr<profiler> &p, unsigned int tid);
   unsigned int process_profile(profiler& p, unsigned int tid);
-  unsigned int process_dependency(task_dependency* td);
   int node_id;
-  std::mutex _mtx;
   bool _common_start(std::shared_ptr<task_wrapper> &tt_ptr,
     bool is_resume); // internal, inline function
   void _common_stop(std::shared_ptr<profiler> &p,
@@ -120,6 +129,8 @@ private:
   void push_profiler(int my_tid, profiler &p);
   std::unordered_map<task_identifier, profile*> task_map;
   std::mutex _task_map_mutex;
+  /* the last set from snapshot_profiles(), guarded by _task_map_mutex */
+  std::shared_ptr<const profile_set> _last_snapshot;
   std::unordered_map<task_identifier, std::unordered_map<task_identifier,
     int>* > task_dependencies;
   /* an vector of profiler queues - so the consumer thread can access them */
@@ -127,14 +138,15 @@ private:
   std::vector<profiler_queue_t*> allqueues;
   profiler_queue_t * _construct_thequeue(void);
   profiler_queue_t * thequeue(void);
-  /* The task dependency queues */
-  std::vector<dependency_queue_t*> dependency_queues;
-  dependency_queue_t * _construct_dependency_queue(void);
-  dependency_queue_t * dependency_queue(void);
-  //ConcurrentQueue<task_dependency*> dependency_queue;
-#if defined(APEX_THROTTLE)
-  std::unordered_set<task_identifier> throttled_tasks;
-#endif
+  /* The task graph edge counts, one table per thread */
+  std::vector<taskgraph_edges*> taskgraph_tables;
+  taskgraph_edges * _construct_taskgraph_edges(void);
+  taskgraph_edges * my_taskgraph_edges(void);
+  void merge_taskgraph_edges(void);
+  /* APEX's own cost for one start/stop pair, see APEX_OVERHEAD_BUDGET */
+  std::atomic<uint64_t> _event_overhead_ns;
+  void measure_overhead(uint64_t stop_ns);
+  void update_sample_period(task_identifier * id, profile * theprofile);
 #if APEX_HAVE_PAPI
   int num_papi_counters;
   std::vector<int> event_sets;
@@ -145,17 +157,15 @@ private:
   std::thread * consumer_thread;
 #endif
   semaphore queue_signal;
-  std::ofstream _task_scatterplot_sample_file;
-  std::ofstream _counter_scatterplot_sample_file;
-  std::stringstream task_scatterplot_samples;
-  std::stringstream counter_scatterplot_samples;
+  shared_profile_table * _shared_profiles;
 public:
   void set_node_id(int node_id, int node_count) {
     APEX_UNUSED(node_count);
     this->node_id = node_id;
   }
   profiler_listener (void) : _initialized(false), _done(false),
-                             node_id(0), task_map()
+                             node_id(0), task_map(), _event_overhead_ns(0),
+                             _shared_profiles(nullptr)
 #if APEX_HAVE_PAPI
                              , num_papi_counters(0), event_sets(8),
                              metric_names(0)
@@ -185,47 +195,21 @@ public:
   bool on_resume(std::shared_ptr<task_wrapper> &tt_ptr);
   void on_task_complete(std::shared_ptr<task_wrapper> &tt_ptr);
   void on_sample_value(sample_value_event_data &data);
+  void on_sample_aggregate(task_identifier * id, double count, double sum,
+    double sum_squares, double minimum, double maximum);
   void on_periodic(periodic_event_data &data);
   void on_custom_event(custom_event_data &event_data);
   void on_send(message_event_data &data);
   void on_recv(message_event_data &data);
   // other methods
-  std::ofstream& task_scatterplot_sample_file() {
-      if (!_task_scatterplot_sample_file.is_open()) {
-        std::stringstream ss;
-        ss << apex_options::output_file_path();
-        ss << filesystem_separator();
-        ss << task_scatterplot_sample_filename << node_id << ".csv";
-        // open the file
-        _task_scatterplot_sample_file.open(ss.str(), std::ofstream::out);
-        if (!_task_scatterplot_sample_file.is_open()) {
-            perror("opening scatterplot sample file");
-        }
-        APEX_ASSERT(_task_scatterplot_sample_file.is_open());
-      }
-      return _task_scatterplot_sample_file;
-  }
-  std::ofstream& counter_scatterplot_sample_file () {
-      if (!_counter_scatterplot_sample_file.is_open()) {
-        std::stringstream ss;
-        ss << apex_options::output_file_path();
-        ss << filesystem_separator();
-        ss << counter_scatterplot_sample_filename << node_id << ".csv";
-        // open the file
-        _counter_scatterplot_sample_file.open(ss.str(), std::ofstream::out);
-        if (!_counter_scatterplot_sample_file.is_open()) {
-            perror("opening scatterplot sample file");
-        }
-        APEX_ASSERT(_counter_scatterplot_sample_file.is_open());
-      }
-      return _counter_scatterplot_sample_file;
-  }
   void reset(task_identifier * id);
   void reset_all(void);
   profile * get_profile(const task_identifier &id);
   double get_non_idle_time(void);
   profile * get_idle_time(void);
   profile * get_idle_rate(void);
+  bool get_profile(const task_identifier &id, apex_profile &values);
+  std::shared_ptr<const profile_set> snapshot_profiles(void);
   std::vector<task_identifier>& get_available_profiles() {
     static std::vector<task_identifier> ids;
     _task_map_mutex.lock();
@@ -238,6 +222,15 @@ public:
     _task_map_mutex.unlock();
     return ids;
   }
+  std::vector<task_identifier> get_available_profiles_copy() {
+    std::vector<task_identifier> ids;
+    std::unique_lock<std::mutex> task_map_lock(_task_map_mutex);
+    ids.reserve(task_map.size());
+    for (auto &kv : task_map) {
+       ids.push_back(kv.first);
+    }
+    return ids;
+  }
   void process_profiles(void);
   static void process_profiles_wrapper(void);
   static void consumer_process_profiles_wrapper(void);
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2014-2021 Kevin Huck
+ * Copyright (c) 2014-2021 University of Oregon
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include "queue_wait.hpp"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+/* 4 buckets per power of 2, up to 2^47 ns (about 39 hours) */
+#define APEX_QUEUE_WAIT_SUB_BUCKETS 4
+#define APEX_QUEUE_WAIT_MAX_EXPONENT 47
+#define APEX_QUEUE_WAIT_BUCKETS \
+    ((APEX_QUEUE_WAIT_MAX_EXPONENT) * APEX_QUEUE_WAIT_SUB_BUCKETS)
+
+namespace apex {
+
+class queue_wait_histogram {
+public:
+    uint64_t count;
+    uint64_t sum;
+    uint64_t maximum;
+    uint64_t buckets[APEX_QUEUE_WAIT_BUCKETS];
+    queue_wait_histogram(void) : count(0), sum(0), maximum(0) {
+        memset(buckets, 0, sizeof(buckets));
+    }
+    /* Values below 4 get their own bucket, above that the two bits after
+     * the leading one pick one of 4 buckets for that power of 2. */
+    static size_t bucket(uint64_t value) {
+        if (value < APEX_QUEUE_WAIT_SUB_BUCKETS) { return (size_t)value; }
+        size_t exponent = 63 - __builtin_clzll(value);
+        if (exponent >= APEX_QUEUE_WAIT_MAX_EXPONENT) {
+            return APEX_QUEUE_WAIT_BUCKETS - 1;
+        }
+        size_t sub = (value >> (exponent - 2)) & 3;
+        return (exponent - 1) * APEX_QUEUE_WAIT_SUB_BUCKETS + sub;
+    }
+    static double midpoint(size_t index) {
+        if (index < APEX_QUEUE_WAIT_SUB_BUCKETS) { return (double)index; }
+        size_t exponent = index / APEX_QUEUE_WAIT_SUB_BUCKETS + 1;
+        size_t sub = index % APEX_QUEUE_WAIT_SUB_BUCKETS;
+        uint64_t width = 1ULL << (exponent - 2);
+        return (double)((4 + sub) * width) + (width * 0.5);
+    }
+    void add(uint64_t value) {
+        count++;
+        sum += value;
+        maximum = std::max(maximum, value);
+        buckets[bucket(value)]++;
+    }
+    void merge(const queue_wait_histogram &other) {
+        count += other.count;
+        sum += other.sum;
+        maximum = std::max(maximum, other.maximum);
+        for (size_t i = 0 ; i < APEX_QUEUE_WAIT_BUCKETS ; i++) {
+            buckets[i] += other.buckets[i];
+        }
+    }
+    double percentile(double fraction) const {
+        if (count == 0) { return 0.0; }
+        uint64_t rank = (uint64_t)(fraction * count);
+        if (rank >= count) { rank = count - 1; }
+        uint64_t seen = 0;
+        for (size_t i = 0 ; i < APEX_QUEUE_WAIT_BUCKETS ; i++) {
+            seen += buckets[i];
+            if (seen > rank) {
+                return std::min(midpoint(i), (double)maximum);
+            }
+        }
+        return (double)maximum;
+    }
+    apex_queue_wait stats(void) const {
+        apex_queue_wait s;
+        s.calls = (double)count;
+        s.mean = count > 0 ? (double)sum / count : 0.0;
+        s.median = percentile(0.5);
+        s.p90 = percentile(0.9);
+        s.p99 = percentile(0.99);
+        s.maximum = (double)maximum;
+        return s;
+    }
+};
+
+typedef std::unordered_map<task_identifier*, queue_wait_histogram>
+    histogram_map;
+
+/* The histograms owned by one thread.  The lock is only contended
+ * when another thread is reading them. */
+class thread_queue_waits {
+public:
+    std::mutex lock;
+    histogram_map tasks;
+};
+
+class queue_wait_registry {
+public:
+    std::mutex lock;
+    std::vector<thread_queue_waits*> threads;
+};
+
+/* Never freed - threads can still be starting tasks during exit. */
+static queue_wait_registry& registry(void) {
+    static queue_wait_registry * r = new queue_wait_registry();
+    return *r;
+}
+
+static thread_queue_waits& my_queue_waits(void) {
+    static APEX_NATIVE_TLS thread_queue_waits * mine = nullptr;
+    if (mine == nullptr) {
+        mine = new thread_queue_waits();
+        queue_wait_registry& r = registry();
+        std::unique_lock<std::mutex> l(r.lock);
+        r.threads.push_back(mine);
+    }
+    return *mine;
+}
+
+void queue_wait_add(task_identifier * id, uint64_t wait_ns) {
+    thread_queue_waits& mine = my_queue_waits();
+    std::unique_lock<std::mutex> l(mine.lock);
+    mine.tasks[id].add(wait_ns);
+}
+
+/* Every thread has its own task_identifier objects, so merge by value. */
+static std::unordered_map<task_identifier, queue_wait_histogram>
+    merge_all(void) {
+    std::unordered_map<task_identifier, queue_wait_histogram> merged;
+    queue_wait_registry& r = registry();
+    std::unique_lock<std::mutex> l(r.lock);
+    for (auto thread : r.threads) {
+        std::unique_lock<std::mutex> tl(thread->lock);
+        for (auto &kv : thread->tasks) {
+            merged[*(kv.first)].merge(kv.second);
+        }
+    }
+    return merged;
+}
+
+apex_queue_wait queue_wait_stats(const task_identifier &id) {
+    queue_wait_histogram merged;
+    queue_wait_registry& r = registry();
+    std::unique_lock<std::mutex> l(r.lock);
+    for (auto thread : r.threads) {
+        std::unique_lock<std::mutex> tl(thread->lock);
+        for (auto &kv : thread->tasks) {
+            if (*(kv.first) == id) {
+                merged.merge(kv.second);
+            }
+        }
+    }
+    return merged.stats();
+}
+
+std::string queue_wait_report(void) {
+    std::unordered_map<task_identifier, queue_wait_histogram> merged =
+        merge_all();
+    if (merged.size() == 0) { return std::string(""); }
+    std::vector<std::pair<std::string, apex_queue_wait> > sorted;
+    for (auto &kv : merged) {
+        task_identifier id_copy(kv.first);
+        sorted.push_back(std::make_pair(id_copy.get_name(),
+            kv.second.stats()));
+    }
+    // the task types that waited the longest in total go first
+    std::sort(sorted.begin(), sorted.end(),
+        [](const std::pair<std::string, apex_queue_wait> &a,
+           const std::pair<std::string, apex_queue_wait> &b) {
+            return a.second.calls * a.second.mean >
+                   b.second.calls * b.second.mean;
+        });
+    std::stringstream ss;
+    char line[256];
+    snprintf(line, sizeof(line), "%52s : %8s %10s %10s %10s %10s %10s\n",
+        "Queue wait (microseconds)", "#tasks", "mean", "median", "p90",
+        "p99", "max");
+    ss << line;
+    for (auto &s : sorted) {
+        const apex_queue_wait& q = s.second;
+        snprintf(line, sizeof(line),
+            "%52.52s : %8.0f %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+            s.first.c_str(), q.calls, q.mean * 1.0e-3, q.median * 1.0e-3,
+            q.p90 * 1.0e-3, q.p99 * 1.0e-3, q.maximum * 1.0e-3);
+        ss << line;
+    }
+    return ss.str();
+}
+
+void queue_wait_reset(void) {
+    queue_wait_registry& r = registry();
+    std::unique_lock<std::mutex> l(r.lock);
+    for (auto thread : r.threads) {
+        std::unique_lock<std::mutex> tl(thread->lock);
+        thread->tasks.clear();
+    }
+}
+
+}
+
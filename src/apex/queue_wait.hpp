@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2014-2021 Kevin Huck
+ * Copyright (c) 2014-2021 University of Oregon
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+
+/* Queue wait (APEX_QUEUE_WAIT) is the time from apex::new_task() to the
+ * first apex::start() of that task, i.e. how long the task waited for the
+ * scheduler.  Each thread keeps a log-linear histogram per task type, so
+ * the percentiles are within 25% of the real values, and the histograms
+ * are merged by task type when the statistics are requested.
+ */
+
+#include "apex_types.h"
+#include "task_identifier.hpp"
+#include <string>
+
+namespace apex {
+
+/* record the queue wait of one task */
+void queue_wait_add(task_identifier * id, uint64_t wait_ns);
+/* the statistics for one task type, from all threads */
+apex_queue_wait queue_wait_stats(const task_identifier &id);
+/* a table of all task types, for the screen output */
+std::string queue_wait_report(void);
+void queue_wait_reset(void);
+
+}
+
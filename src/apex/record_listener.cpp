@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2014-2021 Kevin Huck
+ * Copyright (c) 2014-2021 University of Oregon
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include "record_listener.hpp"
+#include "thread_instance.hpp"
+#include "apex_options.hpp"
+#include "profiler.hpp"
+#include "task_wrapper.hpp"
+#include "utils.hpp"
+#include <string.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+/* events per thread, between writes */
+#define APEX_RECORD_BUFFER_SIZE 4096
+
+namespace apex {
+
+record_listener::record_listener (void) : _terminate(false), _node_id(0),
+    _file(nullptr) {
+}
+
+void record_listener::on_startup(startup_event_data &data) {
+    _node_id = (int)data.comm_rank;
+}
+
+/* Call with the file lock held. */
+bool record_listener::open_file(void) {
+    if (_file != nullptr) { return true; }
+    std::stringstream ss;
+    ss << apex_options::output_file_path() << filesystem_separator()
+       << "apex_events." << _node_id << ".bin";
+    _file = fopen(ss.str().c_str(), "wb");
+    if (_file == nullptr) {
+        perror("opening event log");
+        _terminate = true;
+        return false;
+    }
+    event_log_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, event_log_magic, sizeof(header.magic));
+    header.version = event_log_version;
+    header.node_id = (uint32_t)_node_id;
+    fwrite(&header, sizeof(header), 1, _file);
+    if (apex_options::use_verbose()) {
+        std::cout << "APEX: recording events to " << ss.str() << std::endl;
+    }
+    return true;
+}
+
+record_buffer * record_listener::my_buffer(void) {
+    static APEX_NATIVE_TLS record_buffer * mine = nullptr;
+    if (mine == nullptr) {
+        mine = new record_buffer((uint32_t)thread_instance::get_id());
+        mine->events.reserve(APEX_RECORD_BUFFER_SIZE);
+        std::unique_lock<std::mutex> l(_buffers_mutex);
+        _buffers.push_back(mine);
+    }
+    return mine;
+}
+
+/* Every thread has its own task_identifier objects, so the names are
+ * numbered by value.  A new name is written right away, so it is always
+ * in the file before the events that use it.  Call with the buffer lock
+ * held. */
+uint32_t record_listener::name_id(record_buffer * buffer,
+    task_identifier * id) {
+    auto it = buffer->name_ids.find(id);
+    if (it != buffer->name_ids.end()) { return it->second; }
+    std::unique_lock<std::mutex> l(_file_mutex);
+    uint32_t index;
+    auto known = _names.find(*id);
+    if (known != _names.end()) {
+        index = known->second;
+    } else {
+        index = (uint32_t)_names.size();
+        _names[*id] = index;
+        if (open_file()) {
+            std::string name(id->get_name());
+            uint32_t length = (uint32_t)name.size();
+            event_log_block block{event_log_block_type::NAMES, 1};
+            fwrite(&block, sizeof(block), 1, _file);
+            fwrite(&index, sizeof(index), 1, _file);
+            fwrite(&length, sizeof(length), 1, _file);
+            fwrite(name.c_str(), 1, length, _file);
+        }
+    }
+    buffer->name_ids[id] = index;
+    return index;
+}
+
+/* Call with the buffer lock held. */
+void record_listener::flush(record_buffer * buffer) {
+    if (buffer->events.size() == 0) { return; }
+    std::unique_lock<std::mutex> l(_file_mutex);
+    if (open_file()) {
+        event_log_block block{event_log_block_type::EVENTS,
+            (uint32_t)buffer->events.size()};
+        fwrite(&block, sizeof(block), 1, _file);
+        fwrite(buffer->events.data(), sizeof(recorded_event),
+            buffer->events.size(), _file);
+    }
+    buffer->events.clear();
+}
+
+void record_listener::record(recorded_event_type type, task_identifier * id,
+    uint64_t timestamp, uint64_t guid, uint64_t parent_guid) {
+    if (_terminate) { return; }
+    record_buffer * buffer = my_buffer();
+    std::unique_lock<std::mutex> l(buffer->lock);
+    recorded_event e;
+    memset(&e, 0, sizeof(e));
+    e.timestamp = timestamp;
+    e.guid = guid;
+    e.parent_guid = parent_guid;
+    e.thread = buffer->thread_id;
+    e.name = name_id(buffer, id);
+    e.type = type;
+    buffer->events.push_back(e);
+    if (buffer->events.size() >= APEX_RECORD_BUFFER_SIZE) {
+        flush(buffer);
+    }
+}
+
+/* The profiler_listener has just started the timer for this task on this
+ * thread, so use its start time.  tt_ptr->prof isn't set yet when timers
+ * are started or resumed by name or address, so don't use that. */
+static uint64_t start_time(std::shared_ptr<task_wrapper> &tt_ptr) {
+    profiler * p = thread_instance::get_current_profiler();
+    if (p != nullptr && p->guid == tt_ptr->guid) {
+        return p->get_start_ns();
+    }
+    return profiler::now_ns();
+}
+
+bool record_listener::on_start(std::shared_ptr<task_wrapper> &tt_ptr) {
+    record(recorded_event_type::START, tt_ptr->get_task_id(),
+        start_time(tt_ptr), tt_ptr->guid, tt_ptr->parent_guid);
+    return true;
+}
+
+bool record_listener::on_resume(std::shared_ptr<task_wrapper> &tt_ptr) {
+    record(recorded_event_type::RESUME, tt_ptr->get_task_id(),
+        start_time(tt_ptr), tt_ptr->guid, tt_ptr->parent_guid);
+    return true;
+}
+
+void record_listener::on_stop(std::shared_ptr<profiler> &p) {
+    uint64_t parent_guid = p->tt_ptr != nullptr ? p->tt_ptr->parent_guid : 0;
+    record(recorded_event_type::STOP, p->get_task_id(), p->get_stop_ns(),
+        p->guid, parent_guid);
+}
+
+void record_listener::on_yield(std::shared_ptr<profiler> &p) {
+    uint64_t parent_guid = p->tt_ptr != nullptr ? p->tt_ptr->parent_guid : 0;
+    record(recorded_event_type::YIELD, p->get_task_id(), p->get_stop_ns(),
+        p->guid, parent_guid);
+}
+
+void record_listener::on_sample_value(sample_value_event_data &data) {
+    if (_terminate) { return; }
+    task_identifier * id = data.counter_id;
+    if (id == nullptr) {
+        id = task_identifier::get_task_id(*(data.counter_name));
+    }
+    record_buffer * buffer = my_buffer();
+    std::unique_lock<std::mutex> l(buffer->lock);
+    recorded_event e;
+    memset(&e, 0, sizeof(e));
+    e.timestamp = profiler::now_ns();
+    e.value = data.counter_value;
+    e.thread = buffer->thread_id;
+    e.name = name_id(buffer, id);
+    e.type = recorded_event_type::SAMPLE;
+    buffer->events.push_back(e);
+    if (buffer->events.size() >= APEX_RECORD_BUFFER_SIZE) {
+        flush(buffer);
+    }
+}
+
+void record_listener::on_send(message_event_data &data) {
+    if (_terminate) { return; }
+    record_buffer * buffer = my_buffer();
+    std::unique_lock<std::mutex> l(buffer->lock);
+    recorded_event e;
+    memset(&e, 0, sizeof(e));
+    e.timestamp = profiler::now_ns();
+    e.guid = data.tag;
+    e.parent_guid = data.size;
+    e.rank = data.target;
+    e.thread = buffer->thread_id;
+    e.type = recorded_event_type::SEND;
+    buffer->events.push_back(e);
+    if (buffer->events.size() >= APEX_RECORD_BUFFER_SIZE) {
+        flush(buffer);
+    }
+}
+
+void record_listener::on_recv(message_event_data &data) {
+    if (_terminate) { return; }
+    record_buffer * buffer = my_buffer();
+    std::unique_lock<std::mutex> l(buffer->lock);
+    recorded_event e;
+    memset(&e, 0, sizeof(e));
+    e.timestamp = profiler::now_ns();
+    e.guid = data.tag;
+    e.parent_guid = data.size;
+    e.rank = data.source_rank;
+    e.thread = buffer->thread_id;
+    e.name = (uint32_t)data.source_thread;
+    e.type = recorded_event_type::RECV;
+    buffer->events.push_back(e);
+    if (buffer->events.size() >= APEX_RECORD_BUFFER_SIZE) {
+        flush(buffer);
+    }
+}
+
+void record_listener::on_exit_thread(event_data &data) {
+    APEX_UNUSED(data);
+    if (_terminate) { return; }
+    record_buffer * buffer = my_buffer();
+    std::unique_lock<std::mutex> l(buffer->lock);
+    flush(buffer);
+}
+
+void record_listener::on_shutdown(shutdown_event_data &data) {
+    APEX_UNUSED(data);
+    if (_terminate) { return; }
+    {
+        std::unique_lock<std::mutex> l(_buffers_mutex);
+        for (auto buffer : _buffers) {
+            std::unique_lock<std::mutex> bl(buffer->lock);
+            flush(buffer);
+        }
+    }
+    _terminate = true;
+    std::unique_lock<std::mutex> l(_file_mutex);
+    if (_file != nullptr) {
+        fclose(_file);
+        _file = nullptr;
+    }
+    // the buffers are not freed, threads may still be recording
+}
+
+}
+
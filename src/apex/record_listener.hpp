@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2014-2021 Kevin Huck
+ * Copyright (c) 2014-2021 University of Oregon
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+
+/* The record listener (APEX_RECORD_EVENTS) writes every event that the
+ * listeners see to apex_events.<node>.bin, so that apex_replay can issue
+ * the same events again against any listener configuration.  See
+ * event_log.hpp for the format.
+ */
+
+#include "event_listener.hpp"
+#include "event_log.hpp"
+#include <stdio.h>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace apex {
+
+/* The events of one thread, written out when the buffer is full. */
+class record_buffer {
+public:
+    std::mutex lock;
+    uint32_t thread_id;
+    std::vector<recorded_event> events;
+    /* names this thread has already looked up */
+    std::unordered_map<task_identifier*, uint32_t> name_ids;
+    record_buffer(uint32_t tid) : thread_id(tid) {}
+};
+
+class record_listener : public event_listener {
+private:
+    bool _terminate;
+    int _node_id;
+    FILE * _file;
+    std::mutex _file_mutex;
+    std::unordered_map<task_identifier, uint32_t> _names;
+    std::mutex _buffers_mutex;
+    std::vector<record_buffer*> _buffers;
+    record_buffer * my_buffer(void);
+    uint32_t name_id(record_buffer * buffer, task_identifier * id);
+    void record(recorded_event_type type, task_identifier * id,
+        uint64_t timestamp, uint64_t guid, uint64_t parent_guid);
+    void flush(record_buffer * buffer);
+    bool open_file(void);
+public:
+    record_listener (void);
+    ~record_listener (void) {};
+    void on_startup(startup_event_data &data);
+    void on_dump(dump_event_data &data) { APEX_UNUSED(data); };
+    void on_reset(task_identifier * id) { APEX_UNUSED(id); };
+    void on_pre_shutdown(void) {};
+    void on_shutdown(shutdown_event_data &data);
+    void on_new_node(node_event_data &data) { APEX_UNUSED(data); };
+    void on_new_thread(new_thread_event_data &data) { APEX_UNUSED(data); };
+    void on_exit_thread(event_data &data);
+    bool on_start(std::shared_ptr<task_wrapper> &tt_ptr);
+    void on_stop(std::shared_ptr<profiler> &p);
+    void on_yield(std::shared_ptr<profiler> &p);
+    bool on_resume(std::shared_ptr<task_wrapper> &tt_ptr);
+    void on_task_complete(std::shared_ptr<task_wrapper> &tt_ptr) {
+        APEX_UNUSED(tt_ptr);
+    };
+    void on_sample_value(sample_value_event_data &data);
+    void on_periodic(periodic_event_data &data) { APEX_UNUSED(data); };
+    void on_custom_event(custom_event_data &data) { APEX_UNUSED(data); };
+    void on_send(message_event_data &data);
+    void on_recv(message_event_data &data);
+    void set_node_id(int node_id, int node_count) {
+        APEX_UNUSED(node_count);
+        _node_id = node_id;
+    }
+    void set_metadata(const char * name, const char * value) {
+        APEX_UNUSED(name);
+        APEX_UNUSED(value);
+    };
+};
+
+}
+
@@ -0,0 +1,277 @@
+/*
+ * Copyright (c) 2014-2021 Kevin Huck
+ * Copyright (c) 2014-2021 University of Oregon
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include "scatterplot_samples.hpp"
+#include "apex_options.hpp"
+#include "apex_types.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+
+namespace apex {
+
+/* xorshift64*, much cheaper than std::rand() and not shared between threads */
+class scatterplot_random {
+private:
+    uint64_t _state;
+public:
+    scatterplot_random(uint64_t seed) : _state(seed | 1) {}
+    uint64_t next(void) {
+        _state ^= _state >> 12;
+        _state ^= _state << 25;
+        _state ^= _state >> 27;
+        return _state * 2685821657736338717ULL;
+    }
+    /* uniform in (0,1), never exactly 0 or 1 */
+    double uniform(void) {
+        return ((double)(next() >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+    }
+    size_t below(size_t n) {
+        return (size_t)(next() % n);
+    }
+};
+
+/* A uniform sample of the calls to one timer on one thread.  This is
+ * Li's "Algorithm L": once the reservoir is full, it computes how many
+ * calls to skip before the next replacement, so most calls only compare
+ * two integers. */
+class sample_reservoir {
+public:
+    std::vector<scatterplot_sample> samples;
+    uint64_t seen;
+    uint64_t next;
+    double w;
+    sample_reservoir(void) : seen(0), next(0), w(1.0) {}
+    void skip(size_t capacity, scatterplot_random &rng) {
+        w *= exp(log(rng.uniform()) / capacity);
+        next += (uint64_t)(floor(log(rng.uniform()) / log(1.0 - w))) + 1;
+    }
+    void add(double timestamp, double value, size_t capacity,
+        scatterplot_random &rng) {
+        seen++;
+        if (samples.size() < capacity) {
+            samples.push_back({timestamp, value, 0, 0});
+            if (samples.size() == capacity) {
+                next = seen;
+                skip(capacity, rng);
+            }
+            return;
+        }
+        if (seen < next) { return; }
+        scatterplot_sample& s = samples[rng.below(capacity)];
+        s.timestamp = timestamp;
+        s.value = value;
+        skip(capacity, rng);
+    }
+};
+
+typedef std::unordered_map<task_identifier*, sample_reservoir> reservoir_map;
+
+/* The reservoirs owned by one thread.  The lock is only contended
+ * when another thread is writing the samples out. */
+class thread_reservoirs {
+public:
+    std::mutex lock;
+    reservoir_map tasks;
+    reservoir_map counters;
+    scatterplot_random rng;
+    thread_reservoirs(uint64_t seed) : rng(seed) {}
+};
+
+class reservoir_registry {
+public:
+    std::mutex lock;
+    std::vector<thread_reservoirs*> threads;
+};
+
+/* Never freed - threads can still be stopping timers during exit. */
+static reservoir_registry& registry(void) {
+    static reservoir_registry * r = new reservoir_registry();
+    return *r;
+}
+
+static thread_reservoirs& my_reservoirs(void) {
+    static APEX_NATIVE_TLS thread_reservoirs * mine = nullptr;
+    if (mine == nullptr) {
+        uint64_t seed = std::chrono::high_resolution_clock::now()
+            .time_since_epoch().count();
+        mine = new thread_reservoirs(seed ^ (uint64_t)(&mine));
+        reservoir_registry& r = registry();
+        std::unique_lock<std::mutex> l(r.lock);
+        r.threads.push_back(mine);
+    }
+    return *mine;
+}
+
+void scatterplot_add(task_identifier * id, double timestamp, double value,
+    bool is_counter) {
+    size_t capacity = apex_options::scatterplot_reservoir_size();
+    if (capacity == 0) { return; }
+    thread_reservoirs& mine = my_reservoirs();
+    std::unique_lock<std::mutex> l(mine.lock);
+    reservoir_map& reservoirs = is_counter ? mine.counters : mine.tasks;
+    reservoirs[id].add(timestamp, value, capacity, mine.rng);
+}
+
+struct weighted_sample {
+    scatterplot_sample sample;
+    double key;
+};
+
+bool scatterplot_write(const std::string &filename, bool is_counter) {
+    size_t capacity = apex_options::scatterplot_reservoir_size();
+    /* Each thread's reservoir is a uniform sample of that thread's calls,
+     * so a sample stands for seen/size calls.  Merge them with weighted
+     * sampling without replacement (Efraimidis & Spirakis): give each
+     * sample the key log(u)/weight and keep the largest keys. */
+    /* Every thread has its own task_identifier objects, so merge by value. */
+    std::unordered_map<task_identifier, std::vector<weighted_sample> > merged;
+    scatterplot_random rng(std::chrono::high_resolution_clock::now()
+        .time_since_epoch().count());
+    {
+        reservoir_registry& r = registry();
+        std::unique_lock<std::mutex> l(r.lock);
+        for (auto thread : r.threads) {
+            std::unique_lock<std::mutex> tl(thread->lock);
+            reservoir_map& reservoirs = is_counter ?
+                thread->counters : thread->tasks;
+            for (auto &kv : reservoirs) {
+                sample_reservoir& res = kv.second;
+                if (res.samples.size() == 0) { continue; }
+                double weight = (double)(res.seen) / res.samples.size();
+                std::vector<weighted_sample>& out = merged[*(kv.first)];
+                for (auto &s : res.samples) {
+                    out.push_back({s, log(rng.uniform()) / weight});
+                }
+            }
+        }
+    }
+    std::vector<std::string> names;
+    std::vector<scatterplot_sample> samples;
+    for (auto &kv : merged) {
+        std::vector<weighted_sample>& candidates = kv.second;
+        if (candidates.size() > capacity) {
+            std::nth_element(candidates.begin(),
+                candidates.begin() + capacity, candidates.end(),
+                [](const weighted_sample &a, const weighted_sample &b) {
+                    return a.key > b.key;
+                });
+            candidates.resize(capacity);
+        }
+        uint32_t id = (uint32_t)(names.size());
+        task_identifier id_copy(kv.first);
+        names.push_back(id_copy.get_name());
+        for (auto &c : candidates) {
+            c.sample.id = id;
+            samples.push_back(c.sample);
+        }
+    }
+    std::sort(samples.begin(), samples.end(),
+        [](const scatterplot_sample &a, const scatterplot_sample &b) {
+            return a.timestamp < b.timestamp;
+        });
+
+    // fill in one buffer, so the file can be written in one call
+    scatterplot_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, scatterplot_magic, sizeof(header.magic));
+    header.version = scatterplot_version;
+    header.num_names = names.size();
+    header.num_samples = samples.size();
+    size_t size = sizeof(header);
+    for (auto &name : names) {
+        size += sizeof(uint32_t) + name.size();
+    }
+    size += samples.size() * sizeof(scatterplot_sample);
+    std::vector<char> buffer(size, 0);
+    char * p = buffer.data();
+    memcpy(p, &header, sizeof(header));
+    p += sizeof(header);
+    for (auto &name : names) {
+        uint32_t length = name.size();
+        memcpy(p, &length, sizeof(length));
+        p += sizeof(length);
+        memcpy(p, name.c_str(), length);
+        p += length;
+    }
+    if (samples.size() > 0) {
+        memcpy(p, samples.data(), samples.size() * sizeof(scatterplot_sample));
+    }
+    FILE * f = fopen(filename.c_str(), "wb");
+    if (f == nullptr) {
+        perror("opening scatterplot sample file");
+        return false;
+    }
+    size_t written = fwrite(buffer.data(), 1, buffer.size(), f);
+    fclose(f);
+    return written == buffer.size();
+}
+
+scatterplot_reader::scatterplot_reader(const std::string &filename) :
+    _error("") {
+    FILE * f = fopen(filename.c_str(), "rb");
+    if (f == nullptr) {
+        _error = "could not open " + filename;
+        return;
+    }
+    scatterplot_header header;
+    if (fread(&header, sizeof(header), 1, f) != 1 ||
+        memcmp(header.magic, scatterplot_magic, sizeof(header.magic)) != 0) {
+        _error = filename + " is not a scatterplot sample file";
+        fclose(f);
+        return;
+    }
+    if (header.version != scatterplot_version) {
+        _error = filename + " has an unsupported version";
+        fclose(f);
+        return;
+    }
+    for (uint32_t i = 0 ; i < header.num_names ; i++) {
+        uint32_t length;
+        if (fread(&length, sizeof(length), 1, f) != 1) { break; }
+        std::string name(length, '\0');
+        if (length > 0 && fread(&name[0], 1, length, f) != length) { break; }
+        names.push_back(name);
+    }
+    // check the size before allocating anything
+    long start = ftell(f);
+    fseek(f, 0, SEEK_END);
+    long end = ftell(f);
+    fseek(f, start, SEEK_SET);
+    if (names.size() != header.num_names || (uint64_t)(end - start) !=
+        header.num_samples * sizeof(scatterplot_sample)) {
+        _error = filename + " is truncated";
+        names.clear();
+        fclose(f);
+        return;
+    }
+    samples.resize(header.num_samples);
+    if ((header.num_samples > 0 &&
+        fread(samples.data(), sizeof(scatterplot_sample), header.num_samples,
+        f) != header.num_samples)) {
+        _error = filename + " is truncated";
+        names.clear();
+        samples.clear();
+    }
+    fclose(f);
+    // don't trust ids from a damaged file
+    for (auto &s : samples) {
+        if (s.id >= names.size()) {
+            _error = filename + " has a bad sample";
+            samples.clear();
+            break;
+        }
+    }
+}
+
+}
+
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2014-2021 Kevin Huck
+ * Copyright (c) 2014-2021 University of Oregon
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+
+/* Samples for the task and counter scatterplots (APEX_TASK_SCATTERPLOT).
+ *
+ * Every thread keeps a fixed-size reservoir for each timer and counter it
+ * sees, so every timer gets a uniform sample of its calls no matter how
+ * often it is called, and memory use is bounded.  At dump time the
+ * reservoirs from all threads are merged (weighted by how many calls each
+ * one saw) and written as a binary file, apex_task_samples.N.bin and
+ * apex_counter_samples.N.bin.  The apex_samples utility converts them to
+ * the CSV files read by task_scatterplot.py and counter_scatterplot.py.
+ */
+
+#include "task_identifier.hpp"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace apex {
+
+static const char scatterplot_magic[8] = {'A','P','E','X','S','M','P','L'};
+static const uint32_t scatterplot_version = 1;
+static const char scatterplot_extension[] = ".bin";
+
+/* File layout: the header, then num_names strings (each a uint32_t length
+ * followed by the characters), then num_samples scatterplot_samples. */
+struct scatterplot_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t num_names;
+    uint64_t num_samples;
+};
+
+struct scatterplot_sample {
+    double timestamp; // nanoseconds since APEX started
+    double value;     // duration in nanoseconds, or the counter value
+    uint32_t id;      // index into the names
+    uint32_t padding;
+};
+
+/* Called from process_profile, on the thread that owns the sample. */
+void scatterplot_add(task_identifier * id, double timestamp, double value,
+    bool is_counter);
+
+/* Merge the reservoirs from all threads and write them to filename. */
+bool scatterplot_write(const std::string &filename, bool is_counter);
+
+class scatterplot_reader {
+private:
+    std::string _error;
+public:
+    std::vector<std::string> names;
+    std::vector<scatterplot_sample> samples;
+    scatterplot_reader(const std::string &filename);
+    bool valid(void) const { return _error.size() == 0; }
+    const std::string& error(void) const { return _error; }
+};
+
+}
+
@@ -0,0 +1,586 @@
+/*
+ * Copyright (c) 2014-2021 Kevin Huck
+ * Copyright (c) 2014-2021 University of Oregon
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include "search_strategy.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <numeric>
+
+namespace apex {
+
+namespace search {
+
+size_t variable::size(void) const {
+    if (vtype == variable_type::doubletype) {
+        return dvalues.size();
+    } else if (vtype == variable_type::longtype) {
+        return lvalues.size();
+    }
+    return svalues.size();
+}
+
+void variable::set(size_t index) const {
+    if (vtype == variable_type::doubletype) {
+        *((double*)(value)) = dvalues[index];
+    } else if (vtype == variable_type::longtype) {
+        *((long*)(value)) = lvalues[index];
+    } else {
+        *((const char**)(value)) = svalues[index].c_str();
+    }
+}
+
+std::string variable::to_string(size_t index) const {
+    if (vtype == variable_type::doubletype) {
+        return std::to_string(dvalues[index]);
+    } else if (vtype == variable_type::longtype) {
+        return std::to_string(lvalues[index]);
+    }
+    return svalues[index];
+}
+
+bool exhaustive::next(point &p) {
+    if (_done) { return false; }
+    p = _next;
+    // count in mixed radix, the last dimension changes fastest
+    size_t d = _dims.size();
+    while (true) {
+        if (d == 0) {
+            _done = true;
+            break;
+        }
+        d--;
+        if (++_next[d] < _dims[d].size) { break; }
+        _next[d] = 0;
+    }
+    return true;
+}
+
+nelder_mead::nelder_mead(const std::vector<dimension> &dims, uint64_t seed) :
+    strategy(dims, seed), _step(step::INIT), _index(0),
+    _reflected_cost(0.0), _radius(0.5), _restarts(1), _done(false) {
+    for (size_t d = 0 ; d < _dims.size() ; d++) {
+        if (_dims[d].size > 1) { _active.push_back(d); }
+    }
+    build_simplex(initial_point());
+}
+
+/* The first vertex is the center, and each of the others is moved away
+ * from it in one dimension, by the radius (as a fraction of the size). */
+void nelder_mead::build_simplex(const point &center) {
+    _simplex.clear();
+    vertex c(center.begin(), center.end());
+    _simplex.push_back(c);
+    for (auto d : _active) {
+        vertex v(c);
+        double top = (double)(_dims[d].size - 1);
+        double delta = std::max(1.0, _radius * top);
+        if (v[d] + delta <= top) {
+            v[d] += delta;
+        } else {
+            v[d] = std::max(0.0, v[d] - delta);
+        }
+        _simplex.push_back(v);
+    }
+    _costs.assign(_simplex.size(), 0.0);
+    _step = step::INIT;
+    _index = 0;
+}
+
+point nelder_mead::to_point(const vertex &v) const {
+    point p(v.size());
+    for (size_t d = 0 ; d < v.size() ; d++) {
+        double top = (double)(_dims[d].size - 1);
+        p[d] = (size_t)std::lround(std::min(std::max(v[d], 0.0), top));
+    }
+    return p;
+}
+
+/* from + t * (to - from), kept inside the grid */
+nelder_mead::vertex nelder_mead::along(const vertex &from, const vertex &to,
+    double t) const {
+    vertex v(from.size());
+    for (size_t d = 0 ; d < from.size() ; d++) {
+        double top = (double)(_dims[d].size - 1);
+        v[d] = std::min(std::max(from[d] + t * (to[d] - from[d]), 0.0), top);
+    }
+    return v;
+}
+
+/* The simplex can't get any smaller once all its vertices round to the
+ * same point. */
+bool nelder_mead::collapsed(void) const {
+    point first(to_point(_simplex[0]));
+    for (size_t i = 1 ; i < _simplex.size() ; i++) {
+        if (to_point(_simplex[i]) != first) { return false; }
+    }
+    return true;
+}
+
+void nelder_mead::begin_iteration(void) {
+    // sort the vertices, best first
+    std::vector<size_t> order(_simplex.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+        [this](size_t a, size_t b) { return _costs[a] < _costs[b]; });
+    std::vector<vertex> simplex;
+    std::vector<double> costs;
+    for (auto i : order) {
+        simplex.push_back(_simplex[i]);
+        costs.push_back(_costs[i]);
+    }
+    _simplex.swap(simplex);
+    _costs.swap(costs);
+    if (collapsed()) {
+        if (_restarts > 0) {
+            _restarts--;
+            _radius = _radius * 0.5;
+            build_simplex(to_point(_simplex[0]));
+            return;
+        }
+        _done = true;
+        return;
+    }
+    // the centroid of all but the worst vertex
+    size_t n = _simplex.size() - 1;
+    _centroid.assign(_dims.size(), 0.0);
+    for (size_t i = 0 ; i < n ; i++) {
+        for (size_t d = 0 ; d < _dims.size() ; d++) {
+            _centroid[d] += _simplex[i][d] / n;
+        }
+    }
+    _reflected = along(_centroid, _simplex[n], -1.0);
+    _step = step::REFLECT;
+}
+
+bool nelder_mead::next(point &p) {
+    if (_done) { return false; }
+    switch (_step) {
+        case step::INIT:
+        case step::SHRINK:
+            p = to_point(_simplex[_index]);
+            break;
+        case step::REFLECT:
+            p = to_point(_reflected);
+            break;
+        case step::EXPAND:
+        case step::CONTRACT:
+            p = to_point(_trial);
+            break;
+    }
+    return true;
+}
+
+void nelder_mead::report(const point &p, double cost) {
+    APEX_UNUSED(p);
+    size_t n = _simplex.size() - 1;
+    switch (_step) {
+        case step::INIT:
+        case step::SHRINK:
+            _costs[_index] = cost;
+            if (++_index < _simplex.size()) { return; }
+            begin_iteration();
+            return;
+        case step::REFLECT:
+            _reflected_cost = cost;
+            if (cost < _costs[0]) {
+                _trial = along(_centroid, _reflected, 2.0);
+                _step = step::EXPAND;
+                return;
+            }
+            if (cost < _costs[n-1]) {
+                _simplex[n] = _reflected;
+                _costs[n] = cost;
+                begin_iteration();
+                return;
+            }
+            // contract, outside if the reflection was better than the worst
+            _trial = cost < _costs[n] ?
+                along(_centroid, _reflected, 0.5) :
+                along(_centroid, _simplex[n], 0.5);
+            _step = step::CONTRACT;
+            return;
+        case step::EXPAND:
+            if (cost < _reflected_cost) {
+                _simplex[n] = _trial;
+                _costs[n] = cost;
+            } else {
+                _simplex[n] = _reflected;
+                _costs[n] = _reflected_cost;
+            }
+            begin_iteration();
+            return;
+        case step::CONTRACT:
+            if (cost < std::min(_reflected_cost, _costs[n])) {
+                _simplex[n] = _trial;
+                _costs[n] = cost;
+                begin_iteration();
+                return;
+            }
+            // shrink everything toward the best vertex
+            for (size_t i = 1 ; i < _simplex.size() ; i++) {
+                _simplex[i] = along(_simplex[0], _simplex[i], 0.5);
+            }
+            _step = step::SHRINK;
+            _index = 1;
+            return;
+    }
+}
+
+coordinate_descent::coordinate_descent(const std::vector<dimension> &dims,
+    uint64_t seed, size_t restarts) : strategy(dims, seed),
+    _steps(dims.size(), 1), _center_cost(0.0), _have_center(false),
+    _dim(0), _down(false), _stalled(0), _restarts(restarts) {
+    for (size_t d = 0 ; d < _dims.size() ; d++) {
+        if (_dims[d].size > 1) { _active.push_back(d); }
+    }
+    restart(initial_point());
+}
+
+void coordinate_descent::restart(const point &start) {
+    _start = start;
+    _have_center = false;
+    for (size_t d = 0 ; d < _dims.size() ; d++) {
+        _steps[d] = std::max((size_t)1, _dims[d].size / 4);
+    }
+    _dim = 0;
+    _down = false;
+    _stalled = 0;
+}
+
+/* Try the other direction, or the next dimension.  A dimension that
+ * didn't improve in either direction gets a smaller step, and once its
+ * step is one, it counts as stalled. */
+void coordinate_descent::advance(void) {
+    if (!_down) {
+        _down = true;
+        return;
+    }
+    _down = false;
+    size_t d = _active[_dim];
+    if (_steps[d] > 1) {
+        _steps[d] = _steps[d] / 2;
+        _stalled = 0;
+    } else {
+        _stalled++;
+    }
+    _dim = (_dim + 1) % _active.size();
+}
+
+bool coordinate_descent::next(point &p) {
+    if (!_have_center) {
+        p = _start;
+        return true;
+    }
+    if (_active.empty()) { return false; }
+    while (true) {
+        if (_stalled >= _active.size()) {
+            // a local optimum, start over somewhere else
+            if (_restarts == 0) { return false; }
+            _restarts--;
+            restart(random_point());
+            p = _start;
+            return true;
+        }
+        size_t d = _active[_dim];
+        size_t step = _steps[d];
+        if (!_down && _center[d] + step < _dims[d].size) {
+            p = _center;
+            p[d] += step;
+            return true;
+        }
+        if (_down && _center[d] >= step) {
+            p = _center;
+            p[d] -= step;
+            return true;
+        }
+        advance();
+    }
+}
+
+void coordinate_descent::report(const point &p, double cost) {
+    if (!_have_center) {
+        _center = p;
+        _center_cost = cost;
+        _have_center = true;
+        return;
+    }
+    if (cost < _center_cost) {
+        // keep going the same way
+        _center = p;
+        _center_cost = cost;
+        _stalled = 0;
+        return;
+    }
+    advance();
+}
+
+tpe::tpe(const std::vector<dimension> &dims, uint64_t seed) :
+    strategy(dims, seed), _since_best(0),
+    _best_cost(std::numeric_limits<double>::max()), _polishing(false) {
+    size_t active = 0;
+    for (auto &d : _dims) {
+        if (d.size > 1) { active++; }
+    }
+    _startup = std::max((size_t)5, 2 * active + 1);
+    _patience = std::max((size_t)10, 3 * active);
+}
+
+/* Narrower as the group grows, but never narrower than one index, so the
+ * neighbours of a good point are always likely. */
+double tpe::bandwidth(size_t d, size_t count) const {
+    double width = (double)(_dims[d].size - 1);
+    return std::max(1.0, width / (double)(count + 1));
+}
+
+/* The weight of the uniform prior, in points.  An enum gets one point per
+ * value, so the values that were rarely tried keep a fair chance, instead
+ * of the search settling on the value of the first good points. */
+double tpe::prior_weight(size_t d) const {
+    return _dims[d].ordered ? 1.0 : (double)_dims[d].size;
+}
+
+/* The density of one dimension of a group, at an index.  The group is
+ * mixed with the uniform prior, so no index ever has a density of zero. */
+double tpe::density(size_t d, size_t index,
+    const std::vector<const observation*> &group) const {
+    double prior = prior_weight(d);
+    double sum = prior / (double)_dims[d].size;
+    if (_dims[d].ordered) {
+        double bw = bandwidth(d, group.size());
+        double norm = 1.0 / (bw * std::sqrt(2.0 * std::acos(-1.0)));
+        for (auto o : group) {
+            double z = ((double)index - (double)o->p[d]) / bw;
+            sum += norm * std::exp(-0.5 * z * z);
+        }
+    } else {
+        for (auto o : group) {
+            if (o->p[d] == index) { sum += 1.0; }
+        }
+    }
+    return sum / ((double)group.size() + prior);
+}
+
+/* Draw an index from the density of one dimension of a group: pick one of
+ * the points (or the prior), then a neighbour of it. */
+size_t tpe::sample(size_t d, const std::vector<const observation*> &group) {
+    double prior = prior_weight(d);
+    double which = std::uniform_real_distribution<double>(0.0,
+        (double)group.size() + prior)(_random);
+    if (which >= (double)group.size()) { return random_index(d); }
+    size_t center = group[(size_t)which]->p[d];
+    if (!_dims[d].ordered) { return center; }
+    double top = (double)(_dims[d].size - 1);
+    std::normal_distribution<double> kernel((double)center,
+        bandwidth(d, group.size()));
+    return (size_t)std::lround(std::min(std::max(kernel(_random), 0.0),
+        top));
+}
+
+/* The neighbours of the best point: one index away in an ordered
+ * dimension, or any other value of an enum. */
+void tpe::queue_neighbours(void) {
+    _neighbours.clear();
+    for (size_t d = 0 ; d < _dims.size() ; d++) {
+        point p(_best);
+        if (!_dims[d].ordered) {
+            for (size_t i = 0 ; i < _dims[d].size ; i++) {
+                if (i == _best[d]) { continue; }
+                p[d] = i;
+                _neighbours.push_back(p);
+            }
+            continue;
+        }
+        if (_best[d] > 0) {
+            p[d] = _best[d] - 1;
+            _neighbours.push_back(p);
+        }
+        if (_best[d] + 1 < _dims[d].size) {
+            p[d] = _best[d] + 1;
+            _neighbours.push_back(p);
+        }
+    }
+    _polishing = true;
+}
+
+bool tpe::next(point &p) {
+    if (_observations.size() >= _startup && _since_best >= _patience) {
+        /* The model treats the dimensions independently, so it can miss
+         * an enum value whose effect is hidden by the other parameters.
+         * Before giving up, try the neighbours of the best point, the
+         * model goes on if one of them is better. */
+        if (!_polishing) { queue_neighbours(); }
+        while (!_neighbours.empty()) {
+            p = _neighbours.back();
+            _neighbours.pop_back();
+            if (_seen.count(p) == 0) { return true; }
+        }
+        return false;
+    }
+    if (_observations.empty()) {
+        p = initial_point();
+        return true;
+    }
+    if (_observations.size() < _startup) {
+        p = random_point();
+        return true;
+    }
+    // the best quarter of the points, and the rest
+    std::vector<const observation*> sorted;
+    for (auto &o : _observations) { sorted.push_back(&o); }
+    std::stable_sort(sorted.begin(), sorted.end(),
+        [](const observation * a, const observation * b) {
+            return a->cost < b->cost; });
+    size_t n_good = std::max((size_t)1, (sorted.size() + 3) / 4);
+    std::vector<const observation*> good(sorted.begin(),
+        sorted.begin() + n_good);
+    std::vector<const observation*> bad(sorted.begin() + n_good,
+        sorted.end());
+    /* Score the candidates drawn from the good density by the log of the
+     * ratio of the densities, known points are left out. */
+    static const size_t candidates = 24;
+    double best_score = -std::numeric_limits<double>::max();
+    bool found = false;
+    point candidate(_dims.size());
+    for (size_t c = 0 ; c < candidates ; c++) {
+        double score = 0.0;
+        for (size_t d = 0 ; d < _dims.size() ; d++) {
+            candidate[d] = sample(d, good);
+            score += std::log(density(d, candidate[d], good)) -
+                std::log(density(d, candidate[d], bad));
+        }
+        if (score > best_score && _seen.count(candidate) == 0) {
+            best_score = score;
+            p = candidate;
+            found = true;
+        }
+    }
+    // the model only likes known points, explore instead
+    if (!found) { p = random_point(); }
+    return true;
+}
+
+void tpe::report(const point &p, double cost) {
+    // a random point can be a known one, it tells nothing new
+    if (!_seen.insert(p).second) { return; }
+    _observations.push_back({p, cost});
+    if (cost < _best_cost) {
+        _best_cost = cost;
+        _best = p;
+        _since_best = 0;
+        _polishing = false;
+        _neighbours.clear();
+    } else {
+        _since_best++;
+    }
+}
+
+void search_session::start(strategy_type type, size_t max_evaluations,
+    uint64_t seed) {
+    std::vector<dimension> dims;
+    _space_size = 1;
+    for (auto &v : _vars) {
+        size_t n = v.second.size();
+        dims.push_back({n, v.second.vtype != variable_type::stringtype,
+            std::min(v.second.initial, n - 1)});
+        // don't overflow, a space this big is never covered anyway
+        if (_space_size > std::numeric_limits<size_t>::max() / n) {
+            _space_size = std::numeric_limits<size_t>::max();
+        } else {
+            _space_size = _space_size * n;
+        }
+    }
+    size_t default_evaluations = 1000;
+    switch (type) {
+        case strategy_type::EXHAUSTIVE:
+            _strategy.reset(new exhaustive(dims, seed));
+            default_evaluations = _space_size;
+            break;
+        case strategy_type::RANDOM:
+            _strategy.reset(new random_search(dims, seed));
+            default_evaluations = 100;
+            break;
+        case strategy_type::NELDER_MEAD:
+            _strategy.reset(new nelder_mead(dims, seed));
+            break;
+        case strategy_type::COORDINATE_DESCENT:
+            _strategy.reset(new coordinate_descent(dims, seed));
+            break;
+        case strategy_type::TPE:
+            _strategy.reset(new tpe(dims, seed));
+            default_evaluations = 100;
+            break;
+    }
+    _max_evaluations = max_evaluations > 0 ? max_evaluations :
+        default_evaluations;
+    _best_cost = std::numeric_limits<double>::max();
+    _evaluations = 0;
+    _converged = false;
+    _cache.clear();
+    _best.clear();
+}
+
+void search_session::set(const point &p) const {
+    for (size_t d = 0 ; d < p.size() ; d++) {
+        _vars[d].second.set(p[d]);
+    }
+}
+
+void search_session::get_new_settings(void) {
+    if (_converged || _strategy == nullptr) { return; }
+    /* Points that were already evaluated are answered from the cache.
+     * A strategy that only proposes known points for this long is stuck. */
+    static const size_t max_repeats = 10000;
+    size_t repeats = 0;
+    point p;
+    while (_evaluations < _max_evaluations && _cache.size() < _space_size &&
+        repeats++ < max_repeats) {
+        if (!_strategy->next(p)) { break; }
+        auto known = _cache.find(p);
+        if (known == _cache.end()) {
+            _current = p;
+            set(p);
+            return;
+        }
+        _strategy->report(p, known->second);
+    }
+    _converged = true;
+    save_best_settings();
+}
+
+void search_session::evaluate(double cost) {
+    if (_converged || _strategy == nullptr) { return; }
+    _cache[_current] = cost;
+    _evaluations++;
+    if (cost < _best_cost) {
+        _best_cost = cost;
+        _best = _current;
+    }
+    _strategy->report(_current, cost);
+}
+
+void search_session::save_best_settings(void) const {
+    if (_best.size() != _vars.size()) { return; }
+    set(_best);
+}
+
+void search_session::print_best_settings(void) const {
+    if (_best.size() != _vars.size()) { return; }
+    std::string d("[");
+    for (size_t i = 0 ; i < _best.size() ; i++) {
+        std::cout << d << _vars[i].second.to_string(_best[i]);
+        d = ",";
+    }
+    std::cout << "]" << std::endl;
+}
+
+} // search
+
+} // apex
+
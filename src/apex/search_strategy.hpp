@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2014-2021 Kevin Huck
+ * Copyright (c) 2014-2021 University of Oregon
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+
+/* Search strategies for custom tuning that don't need Active Harmony.
+ *
+ * Every parameter is a list of its possible values, so the search space is a
+ * grid of indices, one dimension per parameter.  A strategy only proposes
+ * points of the grid and is told their cost (lower is better), it never
+ * evaluates anything itself.  The search_session owns the parameters, writes
+ * the values of the proposed point where the application reads them, and
+ * remembers every cost it was given, so a strategy that proposes a point
+ * again (e.g. after rounding) gets the answer right away instead of costing
+ * another evaluation.
+ */
+
+#include "apex_types.h"
+#include <stdint.h>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace apex {
+
+namespace search {
+
+enum class variable_type { doubletype, longtype, stringtype };
+
+/* One tuning parameter: its possible values, and where the application
+ * reads the chosen one. */
+class variable {
+public:
+    variable_type vtype;
+    std::vector<double> dvalues;
+    std::vector<long> lvalues;
+    std::vector<std::string> svalues;
+    void * value; // for the client to get the values
+    size_t initial; // the index of the initial value
+    variable(variable_type vtype, void * ptr) : vtype(vtype), value(ptr),
+        initial(0) {}
+    size_t size(void) const;
+    /* Write the value at this index for the client */
+    void set(size_t index) const;
+    std::string to_string(size_t index) const;
+};
+
+/* One dimension of the grid, as the strategies see it.  Ordered
+ * dimensions are numbers, the others (enums) are categories, so being
+ * close to a good index means nothing. */
+struct dimension {
+    size_t size;
+    bool ordered;
+    size_t initial;
+};
+
+typedef std::vector<size_t> point;
+
+class strategy {
+protected:
+    std::vector<dimension> _dims;
+    std::mt19937_64 _random;
+    size_t random_index(size_t d) {
+        return std::uniform_int_distribution<size_t>(0,
+            _dims[d].size - 1)(_random);
+    }
+    point random_point(void) {
+        point p(_dims.size());
+        for (size_t d = 0 ; d < _dims.size() ; d++) {
+            p[d] = random_index(d);
+        }
+        return p;
+    }
+    point initial_point(void) const {
+        point p(_dims.size());
+        for (size_t d = 0 ; d < _dims.size() ; d++) {
+            p[d] = _dims[d].initial;
+        }
+        return p;
+    }
+public:
+    strategy(const std::vector<dimension> &dims, uint64_t seed) :
+        _dims(dims), _random(seed) {}
+    virtual ~strategy(void) {}
+    /* The next point to evaluate, false when the search is over */
+    virtual bool next(point &p) = 0;
+    /* The cost of the point from the last call to next() */
+    virtual void report(const point &p, double cost) = 0;
+};
+
+/* Every point, in order */
+class exhaustive : public strategy {
+private:
+    point _next;
+    bool _done;
+public:
+    exhaustive(const std::vector<dimension> &dims, uint64_t seed) :
+        strategy(dims, seed), _next(dims.size(), 0), _done(false) {}
+    bool next(point &p);
+    void report(const point &p, double cost) {
+        APEX_UNUSED(p);
+        APEX_UNUSED(cost);
+    }
+};
+
+/* Uniformly random points, until the session runs out of evaluations */
+class random_search : public strategy {
+public:
+    random_search(const std::vector<dimension> &dims, uint64_t seed) :
+        strategy(dims, seed) {}
+    bool next(point &p) {
+        p = random_point();
+        return true;
+    }
+    void report(const point &p, double cost) {
+        APEX_UNUSED(p);
+        APEX_UNUSED(cost);
+    }
+};
+
+/* The Nelder-Mead simplex method, over the grid as a continuous space.
+ * The proposed points are rounded to the grid.  When the simplex has
+ * collapsed to one point, it is restarted once around the best point with
+ * half the size, to get out of a premature collapse. */
+class nelder_mead : public strategy {
+private:
+    enum class step { INIT, REFLECT, EXPAND, CONTRACT, SHRINK };
+    typedef std::vector<double> vertex;
+    std::vector<size_t> _active; // the dimensions with more than one value
+    std::vector<vertex> _simplex;
+    std::vector<double> _costs;
+    step _step;
+    size_t _index; // the vertex being evaluated, for INIT and SHRINK
+    vertex _centroid;
+    vertex _reflected;
+    double _reflected_cost;
+    vertex _trial;
+    double _radius;
+    size_t _restarts;
+    bool _done;
+    point _start;
+    void build_simplex(const point &center);
+    void begin_iteration(void);
+    bool collapsed(void) const;
+    point to_point(const vertex &v) const;
+    vertex along(const vertex &from, const vertex &to, double t) const;
+public:
+    nelder_mead(const std::vector<dimension> &dims, uint64_t seed);
+    bool next(point &p);
+    void report(const point &p, double cost);
+};
+
+/* Coordinate descent: move along one dimension at a time, with a step
+ * that starts at a quarter of the dimension and is halved when neither
+ * direction improves.  At a local optimum (no improvement with a step of
+ * one in any dimension) the search restarts from a random point, a few
+ * times, and the session keeps the best point of all of them. */
+class coordinate_descent : public strategy {
+private:
+    std::vector<size_t> _active;
+    std::vector<size_t> _steps;
+    point _center;
+    double _center_cost;
+    bool _have_center;
+    point _start;
+    size_t _dim;
+    bool _down;
+    size_t _stalled;
+    size_t _restarts;
+    void restart(const point &start);
+    void advance(void);
+public:
+    coordinate_descent(const std::vector<dimension> &dims, uint64_t seed,
+        size_t restarts = 2);
+    bool next(point &p);
+    void report(const point &p, double cost);
+};
+
+/* Bayesian optimization with a tree-structured Parzen estimator (TPE),
+ * for metrics that are expensive to evaluate.  After a few random points,
+ * the points seen so far are split into the best quarter and the rest, and
+ * each group gets a density per dimension: Gaussian kernels for ordered
+ * dimensions, smoothed frequencies for enums.  The next point is the
+ * candidate, drawn from the density of the best points, with the highest
+ * ratio of the two densities.  When the best cost hasn't improved for a
+ * while, the neighbours of the best point are tried, and the search ends
+ * if none of them is better. */
+class tpe : public strategy {
+private:
+    struct observation {
+        point p;
+        double cost;
+    };
+    std::vector<observation> _observations;
+    std::set<point> _seen;
+    size_t _startup; // random points before the model is used
+    size_t _patience; // points without improvement before stopping
+    size_t _since_best;
+    double _best_cost;
+    point _best;
+    bool _polishing;
+    std::vector<point> _neighbours; // of the best point, still to try
+    void queue_neighbours(void);
+    double prior_weight(size_t d) const;
+    double bandwidth(size_t d, size_t count) const;
+    double density(size_t d, size_t index,
+        const std::vector<const observation*> &group) const;
+    size_t sample(size_t d, const std::vector<const observation*> &group);
+public:
+    tpe(const std::vector<dimension> &dims, uint64_t seed);
+    bool next(point &p);
+    void report(const point &p, double cost);
+};
+
+enum class strategy_type { EXHAUSTIVE, RANDOM, NELDER_MEAD,
+    COORDINATE_DESCENT, TPE };
+
+class search_session {
+private:
+    std::vector<std::pair<std::string, variable> > _vars;
+    std::unique_ptr<strategy> _strategy;
+    std::map<point, double> _cache;
+    point _current;
+    point _best;
+    double _best_cost;
+    size_t _evaluations;
+    size_t _max_evaluations;
+    size_t _space_size;
+    bool _converged;
+    void set(const point &p) const;
+public:
+    search_session(void) : _best_cost(0.0), _evaluations(0),
+        _max_evaluations(0), _space_size(0), _converged(false) {}
+    void add_var(const std::string &name, variable var) {
+        _vars.push_back(std::make_pair(name, std::move(var)));
+    }
+    /* Start the search, after all the variables are added.  With no
+     * maximum, the exhaustive search evaluates every point, and the others
+     * stop after 1000 evaluations (100 for the random search and TPE). */
+    void start(strategy_type type, size_t max_evaluations = 0,
+        uint64_t seed = 0);
+    bool started(void) const { return _strategy != nullptr; }
+    bool converged(void) const { return _converged; }
+    /* Write the values of the next point to evaluate */
+    void get_new_settings(void);
+    /* The cost of the point from the last call to get_new_settings() */
+    void evaluate(double cost);
+    void save_best_settings(void) const;
+    void print_best_settings(void) const;
+    double get_best_cost(void) const { return _best_cost; }
+    size_t get_evaluations(void) const { return _evaluations; }
+};
+
+} // search
+
+} // apex
+
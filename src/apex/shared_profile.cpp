@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2014-2021 Kevin Huck
+ * Copyright (c) 2014-2021 University of Oregon
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include "shared_profile.hpp"
+#include "apex_options.hpp"
+#include "profiler.hpp"
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sstream>
+#include <iomanip>
+
+namespace apex {
+
+std::string shared_profile_segment_name(uint32_t pid) {
+    std::stringstream ss;
+    ss << "/apex_profile." << pid;
+    return ss.str();
+}
+
+shared_profile_table::shared_profile_table(void) :
+    _segment_name(shared_profile_segment_name(getpid())), _size(0),
+    _header(nullptr), _entries(nullptr) {
+    uint64_t capacity = apex_options::shared_profile_size();
+    _size = sizeof(shared_profile_header) +
+        (capacity * sizeof(shared_profile_entry));
+    int fd = shm_open(_segment_name.c_str(), O_CREAT | O_RDWR, 0600);
+    if (fd < 0) {
+        perror("APEX: opening shared profile segment");
+        return;
+    }
+    // ftruncate zero-fills the segment, so every entry starts unused.
+    if (ftruncate(fd, _size) != 0) {
+        perror("APEX: sizing shared profile segment");
+        close(fd);
+        shm_unlink(_segment_name.c_str());
+        return;
+    }
+    void * data = mmap(nullptr, _size, PROT_READ | PROT_WRITE,
+        MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        perror("APEX: mapping shared profile segment");
+        shm_unlink(_segment_name.c_str());
+        return;
+    }
+    shared_profile_header * header = (shared_profile_header*)data;
+    header->version = shared_profile_version;
+    header->pid = getpid();
+    header->capacity = capacity;
+    header->entry_size = sizeof(shared_profile_entry);
+    header->start_time_ns = profiler::now_ns();
+    header->num_entries.store(0, std::memory_order_relaxed);
+    _entries = (shared_profile_entry*)(header + 1);
+    // write the magic last, so readers don't attach to a partial header
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(header->magic, shared_profile_magic, sizeof(header->magic));
+    _header = header;
+}
+
+shared_profile_table::~shared_profile_table(void) {
+    if (_header != nullptr) {
+        unlink();
+        munmap((void*)_header, _size);
+    }
+}
+
+void shared_profile_table::unlink(void) {
+    if (_segment_name.size() > 0) {
+        shm_unlink(_segment_name.c_str());
+        _segment_name = "";
+    }
+}
+
+void shared_profile_table::update(task_identifier * id, profile * p) {
+    int index = p->get_shared_index();
+    if (index < 0 && !p->claim_shared_index()) {
+        // another thread is assigning the entry, it won't be long
+        while ((index = p->get_shared_index()) < 0) { }
+    } else if (index < 0) {
+        uint64_t slot = _header->num_entries.fetch_add(1,
+            std::memory_order_relaxed);
+        if (slot >= _header->capacity) {
+            // the table is full, so don't try again for this profile
+            p->set_shared_index(INT32_MAX);
+            return;
+        }
+        index = (int)slot;
+        std::string name = id->get_name(false);
+        if (name.size() == 0) {
+            std::stringstream ss;
+            ss << "UNRESOLVED ADDR 0x" << std::hex << id->address;
+            name = ss.str();
+        }
+        shared_profile_entry& e = _entries[index];
+        // the entry isn't visible until its sequence is non-zero
+        strncpy(e.name, name.c_str(), APEX_SHARED_PROFILE_NAME_LENGTH - 1);
+        e.type = p->get_type();
+        p->set_shared_index(index);
+    }
+    if (index == INT32_MAX) {
+        return;
+    }
+    // a consistent copy, another thread may be updating the profile
+    apex_profile values;
+    p->read(values);
+    shared_profile_entry& e = _entries[index];
+    /* Profiles can be updated by more than one thread, so take the
+     * "lock" by moving the sequence from even to odd. */
+    uint64_t seq = e.sequence.load(std::memory_order_relaxed);
+    do {
+        while (seq & 1) {
+            seq = e.sequence.load(std::memory_order_relaxed);
+        }
+    } while (!e.sequence.compare_exchange_weak(seq, seq + 1,
+        std::memory_order_acquire, std::memory_order_relaxed));
+    std::atomic_thread_fence(std::memory_order_release);
+    e.calls = values.calls;
+    e.accumulated = values.accumulated;
+    e.sum_squares = values.sum_squares;
+    e.minimum = values.minimum;
+    e.maximum = values.maximum;
+    e.bytes_allocated = values.bytes_allocated;
+    e.bytes_freed = values.bytes_freed;
+    e.sequence.store(seq + 2, std::memory_order_release);
+}
+
+shared_profile_reader::shared_profile_reader(uint32_t pid) :
+    _size(0), _header(nullptr), _entries(nullptr), _error("") {
+    std::string segment_name(shared_profile_segment_name(pid));
+    int fd = shm_open(segment_name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        _error = "could not open shared memory segment " + segment_name;
+        return;
+    }
+    struct stat sb;
+    if (fstat(fd, &sb) != 0 ||
+        (size_t)sb.st_size < sizeof(shared_profile_header)) {
+        _error = segment_name + " is not an APEX profile";
+        close(fd);
+        return;
+    }
+    _size = sb.st_size;
+    void * data = mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        _error = "could not map " + segment_name;
+        return;
+    }
+    const shared_profile_header * header = (const shared_profile_header*)data;
+    if (memcmp(header->magic, shared_profile_magic,
+        sizeof(shared_profile_magic)) != 0 ||
+        header->version != shared_profile_version ||
+        header->entry_size != sizeof(shared_profile_entry) ||
+        _size < sizeof(shared_profile_header) +
+            (header->capacity * sizeof(shared_profile_entry))) {
+        _error = segment_name + " is not a compatible APEX profile";
+        munmap(data, _size);
+        return;
+    }
+    _header = header;
+    _entries = (const shared_profile_entry*)(header + 1);
+}
+
+shared_profile_reader::~shared_profile_reader(void) {
+    if (_header != nullptr) {
+        munmap((void*)_header, _size);
+    }
+}
+
+void shared_profile_reader::read(std::vector<shared_profile_row> &rows) const {
+    rows.clear();
+    uint64_t count = _header->num_entries.load(std::memory_order_acquire);
+    if (count > _header->capacity) { count = _header->capacity; }
+    rows.reserve(count);
+    for (uint64_t i = 0 ; i < count ; i++) {
+        const shared_profile_entry& e = _entries[i];
+        shared_profile_row row;
+        uint64_t before, after;
+        do {
+            before = e.sequence.load(std::memory_order_acquire);
+            if (before & 1) { continue; }
+            row.type = e.type;
+            row.calls = e.calls;
+            row.accumulated = e.accumulated;
+            row.sum_squares = e.sum_squares;
+            row.minimum = e.minimum;
+            row.maximum = e.maximum;
+            row.bytes_allocated = e.bytes_allocated;
+            row.bytes_freed = e.bytes_freed;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = e.sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+        // never written (yet)
+        if (before == 0) { continue; }
+        row.name.assign(e.name, strnlen(e.name, APEX_SHARED_PROFILE_NAME_LENGTH));
+        rows.push_back(row);
+    }
+}
+
+}
+
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2014-2021 Kevin Huck
+ * Copyright (c) 2014-2021 University of Oregon
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+
+/* Live profile export through POSIX shared memory.
+ *
+ * When APEX_SHARED_PROFILE is set, the profiler_listener keeps a copy of
+ * its aggregated profiles in the shared memory segment "/apex_profile.<pid>".
+ * Each entry is protected by its own sequence lock: the writer makes the
+ * sequence odd, updates the entry, and makes it even again.  A reader
+ * (e.g. apex_top) copies an entry and retries if the sequence was odd or
+ * changed while it was copying, so it always sees a consistent entry
+ * without ever blocking the application.
+ */
+
+#include "apex_types.h"
+#include "profile.hpp"
+#include "task_identifier.hpp"
+#include <atomic>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#define APEX_SHARED_PROFILE_NAME_LENGTH 256
+
+namespace apex {
+
+static const char shared_profile_magic[8] = {'A','P','E','X','L','I','V','E'};
+static const uint32_t shared_profile_version = 1;
+
+struct shared_profile_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t pid;
+    uint64_t capacity;
+    uint64_t entry_size;
+    uint64_t start_time_ns;
+    std::atomic<uint64_t> num_entries;
+};
+
+struct shared_profile_entry {
+    std::atomic<uint64_t> sequence;
+    uint64_t type;
+    double calls;
+    double accumulated;
+    double sum_squares;
+    double minimum;
+    double maximum;
+    double bytes_allocated;
+    double bytes_freed;
+    char name[APEX_SHARED_PROFILE_NAME_LENGTH];
+};
+
+/* A consistent copy of one entry, as seen by a reader. */
+struct shared_profile_row {
+    std::string name;
+    uint64_t type;
+    double calls;
+    double accumulated;
+    double sum_squares;
+    double minimum;
+    double maximum;
+    double bytes_allocated;
+    double bytes_freed;
+};
+
+std::string shared_profile_segment_name(uint32_t pid);
+
+/* The writer side, owned by the profiler_listener. */
+class shared_profile_table {
+private:
+    std::string _segment_name;
+    size_t _size;
+    shared_profile_header * _header;
+    shared_profile_entry * _entries;
+public:
+    shared_profile_table(void);
+    ~shared_profile_table(void);
+    bool valid(void) const { return _header != nullptr; }
+    /* Copy the current values of a profile into its entry, assigning
+     * an entry the first time the profile is seen. */
+    void update(task_identifier * id, profile * p);
+    /* Remove the name, so no new readers can attach. */
+    void unlink(void);
+};
+
+/* The reader side, used by apex_top. */
+class shared_profile_reader {
+private:
+    size_t _size;
+    const shared_profile_header * _header;
+    const shared_profile_entry * _entries;
+    std::string _error;
+public:
+    shared_profile_reader(uint32_t pid);
+    ~shared_profile_reader(void);
+    shared_profile_reader(const shared_profile_reader&) = delete;
+    shared_profile_reader& operator=(const shared_profile_reader&) = delete;
+    bool valid(void) const { return _header != nullptr; }
+    const std::string& error(void) const { return _error; }
+    uint64_t start_time_ns(void) const { return _header->start_time_ns; }
+    /* Take a consistent copy of every entry. */
+    void read(std::vector<shared_profile_row> &rows) const;
+};
+
+}
+
@@ -14,6 +14,7 @@
 #include <string>
 #include <unordered_map>
 #include <mutex>
+#include <atomic>
 #include <utility>
 #include <cstddef>
 
@@ -45,20 +46,35 @@ public:
   std::string name;
   std::string _resolved_name;
   bool has_name;
+  // Measure one in sample_period calls to this timer (set by the
+  // profiler_listener to stay within APEX_OVERHEAD_BUDGET).  It is not
+  // part of the identity, so copies start over at 1.
+  std::atomic<uint32_t> sample_period;
   task_identifier(void) :
-      address(0L), name(""), _resolved_name(""), has_name(false) {};
+      address(0L), name(""), _resolved_name(""), has_name(false),
+      sample_period(1) {};
   task_identifier(apex_function_address a) :
-      address(a), name(""), _resolved_name(""), has_name(false) {};
+      address(a), name(""), _resolved_name(""), has_name(false),
+      sample_period(1) {};
   task_identifier(const std::string& n) :
-      address(0L), name(n), _resolved_name(""), has_name(true) {};
+      address(0L), name(n), _resolved_name(""), has_name(true),
+      sample_period(1) {};
   // The copy constructor doesn't copy the resolved name.  That's because
   // it would be too expensive to lock control to it, since it can be
   // updated by another thread. Therefore, leave it unresolved, no one will
   // ask for the resolved name until program exit, or in policies.
   task_identifier(const task_identifier& rhs) :
       address(rhs.address), name(rhs.name),
-      _resolved_name(""), has_name(rhs.has_name) { };
-  task_identifier& operator=(const task_identifier& rhs) = default;
+      _resolved_name(""), has_name(rhs.has_name), sample_period(1) { };
+  // Assignment is the same as the copy constructor, for the same reasons.
+  task_identifier& operator=(const task_identifier& rhs) {
+      address = rhs.address;
+      name = rhs.name;
+      _resolved_name = "";
+      has_name = rhs.has_name;
+      sample_period.store(1, std::memory_order_relaxed);
+      return *this;
+  }
 
   static task_identifier * get_task_id (apex_function_address a);
   static task_identifier * get_task_id (const std::string& n);
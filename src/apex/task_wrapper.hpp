@@ -50,8 +50,21 @@ struct task_wrapper {
   \brief An internally generated GUID for the parent task of this task.
   */
     uint64_t parent_guid;
+/**
+  \brief The task_identifier of the parent task, when this task was created.
+  */
+    task_identifier * parent_task_id;
+/**
+  \brief The node in the task tree of the parent task, when this task
+         was created.
+  */
+    dependency::Node* parent_tree_node;
 /**
   \brief A managed pointer to the parent task_wrapper for this task.
+         It keeps every ancestor of a live task alive, so it is only set
+         when a listener needs the parent itself (the critical path).
+         Everything else uses the parent_guid, parent_task_id and
+         parent_tree_node.
   */
     std::shared_ptr<task_wrapper> parent;
 /**
@@ -69,6 +82,16 @@ struct task_wrapper {
          becomes the new task_identifier for the task.
   */
     task_identifier* alias;
+/**
+  \brief When the task was created by apex::new_task, in nanoseconds.
+         Zero once the task has been started, or if the queue wait
+         isn't measured.
+  */
+    uint64_t create_ns;
+/**
+  \brief The thread that created the task.
+  */
+    long unsigned int create_thread;
 /**
   \brief Constructor.
   */
@@ -77,9 +100,13 @@ struct task_wrapper {
         prof(nullptr),
         guid(0ull),
         parent_guid(0ull),
+        parent_task_id(nullptr),
+        parent_tree_node(nullptr),
         parent(nullptr),
         tree_node(nullptr),
-        alias(nullptr)
+        alias(nullptr),
+        create_ns(0ull),
+        create_thread(0)
     { }
 /**
   \brief Get the task_identifier for this task_wrapper.
@@ -112,11 +139,11 @@ struct task_wrapper {
     }
     void assign_heritage() {
         // make/find a node for ourselves
-        tree_node = parent->tree_node->appendChild(task_id);
+        tree_node = parent_tree_node->appendChild(task_id);
     }
     void update_heritage() {
         // make/find a node for ourselves
-        tree_node = parent->tree_node->replaceChild(task_id, alias);
+        tree_node = parent_tree_node->replaceChild(task_id, alias);
     }
 }; // struct task_wrapper
 
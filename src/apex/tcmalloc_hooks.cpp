@@ -26,20 +26,37 @@ bool& inWrapper() {
     return _inWrapper;
 }
 
+/* Look the counter names up once, these are sampled on every allocation. */
+struct memory_counters {
+    apex_counter_handle allocated;
+    apex_counter_handle freed;
+    apex_counter_handle occupied;
+    memory_counters() :
+        allocated(apex::register_counter("Memory: Bytes Allocated")),
+        freed(apex::register_counter("Memory: Bytes Freed")),
+        occupied(apex::register_counter("Memory: Total Bytes Occupied")) {}
+};
+
+memory_counters& getCounters() {
+    static memory_counters counters;
+    return counters;
+}
+
 void NewHook(const void* ptr, size_t size) {
     // prevent infinite recursion...
     if (inWrapper() || apex::in_apex::get() > 0) { return; }
     inWrapper() = true;
     tracker& t = getTracker();
+    memory_counters& counters = getCounters();
     double value = (double)(size);
-    apex::sample_value("Memory: Bytes Allocated", value, true);
+    apex::sample_value(counters.allocated, value);
     t.hostMapMutex.lock();
     //std::cout << "Address " << ptr << " has " << size << " bytes." << std::endl;
     t.hostMemoryMap[ptr] = value;
     t.hostMapMutex.unlock();
     t.hostTotalAllocated.fetch_add(size, std::memory_order_relaxed);
     value = (double)(t.hostTotalAllocated);
-    apex::sample_value("Memory: Total Bytes Occupied", value);
+    apex::sample_value(counters.occupied, value);
     inWrapper() = false;
 }
 
@@ -48,6 +65,7 @@ void DeleteHook(const void* ptr) {
     if (inWrapper() || apex::in_apex::get() > 0) { return; }
     inWrapper() = true;
     tracker& t = getTracker();
+    memory_counters& counters = getCounters();
     size_t size = 0;
     t.hostMapMutex.lock();
     if (t.hostMemoryMap.count(ptr) > 0) {
@@ -60,10 +78,10 @@ void DeleteHook(const void* ptr) {
     }
     t.hostMapMutex.unlock();
     double value = (double)(size);
-    apex::sample_value("Memory: Bytes Freed", value, true);
+    apex::sample_value(counters.freed, value);
     t.hostTotalAllocated.fetch_sub(size, std::memory_order_relaxed);
     value = (double)(t.hostTotalAllocated);
-    apex::sample_value("Memory: Total Bytes Occupied", value);
+    apex::sample_value(counters.occupied, value);
     inWrapper() = true;
 }
 
@@ -93,10 +93,26 @@ void trace_event_listener::on_exit_thread(event_data &data) {
 }
 
 bool trace_event_listener::on_start(std::shared_ptr<task_wrapper> &tt_ptr) {
-    APEX_UNUSED(tt_ptr);
     /*
-     * Do nothing - we can do a "complete" record at stop
+     * Do nothing - we can do a "complete" record at stop.  The exception
+     * is the first start of a task, where we draw a flow arrow from where
+     * it was created to where it started.
     */
+    if (!_terminate && tt_ptr->create_ns != 0 && tt_ptr->prof != nullptr) {
+        int tid = get_thread_id();
+        std::stringstream ss;
+        ss << "{\"name\":\"queue wait\",\"cat\":\"queue wait\""
+           << ",\"ph\":\"s\",\"id\":" << tt_ptr->guid
+           << ",\"pid\":" << saved_node_id
+           << ",\"tid\":" << tt_ptr->create_thread
+           << ",\"ts\":" << fixed << tt_ptr->create_ns * 1.0e-3 << "},\n";
+        ss << "{\"name\":\"queue wait\",\"cat\":\"queue wait\""
+           << ",\"ph\":\"f\",\"bp\":\"e\",\"id\":" << tt_ptr->guid
+           << ",\"pid\":" << saved_node_id << ",\"tid\":" << tid
+           << ",\"ts\":" << fixed << tt_ptr->prof->get_start_us() << "},\n";
+        write_to_trace(ss);
+        flush_trace_if_necessary();
+    }
     return true;
 }
 
@@ -124,13 +140,18 @@ int trace_event_listener::get_thread_id_metadata() {
     return tid;
 }
 
-inline void trace_event_listener::_common_stop(std::shared_ptr<profiler> &p) {
+int trace_event_listener::get_thread_id() {
     static APEX_NATIVE_TLS int tid = get_thread_id_metadata();
+    return tid;
+}
+
+inline void trace_event_listener::_common_stop(std::shared_ptr<profiler> &p) {
+    int tid = get_thread_id();
     if (!_terminate) {
         std::stringstream ss;
         uint64_t pguid = 0;
-        if (p->tt_ptr != nullptr && p->tt_ptr->parent != nullptr) {
-            pguid = p->tt_ptr->parent->guid;
+        if (p->tt_ptr != nullptr) {
+            pguid = p->tt_ptr->parent_guid;
         }
         ss << "{\"name\":\"" << p->get_task_id()->get_name()
               << "\",\"ph\":\"X\",\"pid\":"
@@ -239,8 +260,8 @@ void trace_event_listener::on_async_event(async_thread_node &node,
         std::stringstream ss;
         std::string tid{make_tid(node)};
         uint64_t pguid = 0;
-        if (p->tt_ptr != nullptr && p->tt_ptr->parent != nullptr) {
-            pguid = p->tt_ptr->parent->guid;
+        if (p->tt_ptr != nullptr) {
+            pguid = p->tt_ptr->parent_guid;
         }
         ss << "{\"name\":\"" << p->get_task_id()->get_name()
               << "\",\"ph\":\"X\",\"pid\":"
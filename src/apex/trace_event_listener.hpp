@@ -62,6 +62,7 @@ private:
   	void _common_stop(std::shared_ptr<profiler> &p);
     std::string make_tid (async_thread_node &node);
     int get_thread_id_metadata();
+    int get_thread_id();
   	static bool _initialized;
     size_t get_thread_index(void);
     std::mutex * get_thread_mutex(size_t index);
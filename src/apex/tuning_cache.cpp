@@ -0,0 +1,375 @@
+/*
+ * Copyright (c) 2014-2021 Kevin Huck
+ * Copyright (c) 2014-2021 University of Oregon
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#include "tuning_cache.hpp"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+
+namespace apex {
+
+/* FNV-1a, to find records that were only partly written */
+static uint32_t checksum(const char * data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0 ; i < size ; i++) {
+        hash ^= (uint8_t)data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void put(std::string &buffer, const void * data, size_t size) {
+    buffer.append((const char*)data, size);
+}
+
+static void put_string(std::string &buffer, const std::string &s) {
+    uint32_t length = (uint32_t)s.size();
+    put(buffer, &length, sizeof(length));
+    buffer.append(s);
+}
+
+/* Reads the payload of a record, and remembers if it ran out */
+class payload_reader {
+private:
+    const char * _data;
+    size_t _size;
+    size_t _offset;
+    bool _ok;
+public:
+    payload_reader(const char * data, size_t size) : _data(data),
+        _size(size), _offset(0), _ok(true) {}
+    bool ok(void) const { return _ok && _offset == _size; }
+    bool failed(void) const { return !_ok; }
+    void get(void * data, size_t size) {
+        if (!_ok || _offset + size > _size) {
+            _ok = false;
+            memset(data, 0, size);
+            return;
+        }
+        memcpy(data, _data + _offset, size);
+        _offset += size;
+    }
+    std::string get_string(void) {
+        uint32_t length = 0;
+        get(&length, sizeof(length));
+        if (!_ok || _offset + length > _size) {
+            _ok = false;
+            return std::string();
+        }
+        std::string s(_data + _offset, length);
+        _offset += length;
+        return s;
+    }
+};
+
+static std::string make_record(tuning_cache_record_type type,
+    const std::string &payload) {
+    tuning_cache_record record;
+    record.type = type;
+    record.size = (uint32_t)payload.size();
+    std::string buffer;
+    put(buffer, &record, sizeof(record));
+    buffer.append(payload);
+    uint32_t sum = checksum(payload.data(), payload.size());
+    put(buffer, &sum, sizeof(sum));
+    return buffer;
+}
+
+static std::string variable_record(const tuning_variable &variable) {
+    std::string payload;
+    put(payload, &variable.id, sizeof(variable.id));
+    put(payload, &variable.type, sizeof(variable.type));
+    put(payload, &variable.category, sizeof(variable.category));
+    put(payload, &variable.quantity, sizeof(variable.quantity));
+    put_string(payload, variable.name);
+    return make_record(tuning_cache_record_type::VARIABLE, payload);
+}
+
+static std::string context_record(const std::string &name,
+    const std::vector<tuning_value> &values) {
+    std::string payload;
+    put_string(payload, name);
+    uint32_t count = (uint32_t)values.size();
+    put(payload, &count, sizeof(count));
+    for (auto &v : values) {
+        put(payload, &v.id, sizeof(v.id));
+        put(payload, &v.type, sizeof(v.type));
+        switch (v.type) {
+            case tuning_value_type::DOUBLE:
+                put(payload, &v.dvalue, sizeof(v.dvalue));
+                break;
+            case tuning_value_type::INT64:
+                put(payload, &v.lvalue, sizeof(v.lvalue));
+                break;
+            case tuning_value_type::STRING:
+                put_string(payload, v.svalue);
+                break;
+        }
+    }
+    return make_record(tuning_cache_record_type::CONTEXT, payload);
+}
+
+static bool read_variable(payload_reader &in, tuning_variable &variable) {
+    in.get(&variable.id, sizeof(variable.id));
+    in.get(&variable.type, sizeof(variable.type));
+    in.get(&variable.category, sizeof(variable.category));
+    in.get(&variable.quantity, sizeof(variable.quantity));
+    variable.name = in.get_string();
+    return in.ok();
+}
+
+static bool read_context(payload_reader &in, std::string &name,
+    std::vector<tuning_value> &values) {
+    name = in.get_string();
+    uint32_t count = 0;
+    in.get(&count, sizeof(count));
+    for (uint32_t i = 0 ; i < count ; i++) {
+        tuning_value v;
+        in.get(&v.id, sizeof(v.id));
+        in.get(&v.type, sizeof(v.type));
+        switch (v.type) {
+            case tuning_value_type::DOUBLE:
+                in.get(&v.dvalue, sizeof(v.dvalue));
+                break;
+            case tuning_value_type::INT64:
+                in.get(&v.lvalue, sizeof(v.lvalue));
+                break;
+            case tuning_value_type::STRING:
+                v.svalue = in.get_string();
+                break;
+            default:
+                return false;
+        }
+        if (in.failed()) { return false; }
+        values.push_back(v);
+    }
+    return in.ok();
+}
+
+/* The length of the part of the contents that has whole, valid records,
+ * starting at offset, and a callback for every record in it. */
+template <typename F>
+static size_t scan(const std::string &contents, size_t offset,
+    F record_callback) {
+    while (offset + sizeof(tuning_cache_record) <= contents.size()) {
+        tuning_cache_record record;
+        memcpy(&record, contents.data() + offset, sizeof(record));
+        size_t end = offset + sizeof(record) + record.size + sizeof(uint32_t);
+        if (end > contents.size()) { break; }
+        const char * payload = contents.data() + offset + sizeof(record);
+        uint32_t sum;
+        memcpy(&sum, payload + record.size, sizeof(sum));
+        if (sum != checksum(payload, record.size)) { break; }
+        if (!record_callback(record.type, payload, record.size)) { break; }
+        offset = end;
+    }
+    return offset;
+}
+
+static bool has_header(const std::string &contents) {
+    if (contents.size() < sizeof(tuning_cache_header)) { return false; }
+    const tuning_cache_header * header =
+        (const tuning_cache_header*)contents.data();
+    return memcmp(header->magic, tuning_cache_magic,
+        sizeof(tuning_cache_magic)) == 0;
+}
+
+bool tuning_cache::is_cache(const std::string &filename) {
+    std::ifstream f(filename, std::ios::binary);
+    char magic[sizeof(tuning_cache_magic)];
+    if (!f.read(magic, sizeof(magic))) { return false; }
+    return memcmp(magic, tuning_cache_magic, sizeof(magic)) == 0;
+}
+
+bool tuning_cache::read(const std::string &filename, std::string &error) {
+    std::ifstream f(filename, std::ios::binary);
+    if (!f.good()) {
+        error = "could not open " + filename;
+        return false;
+    }
+    std::string contents((std::istreambuf_iterator<char>(f)),
+        std::istreambuf_iterator<char>());
+    if (!has_header(contents)) {
+        error = filename + " is not a tuning cache";
+        return false;
+    }
+    const tuning_cache_header * header =
+        (const tuning_cache_header*)contents.data();
+    if (header->version != tuning_cache_version) {
+        error = filename + " has an unsupported tuning cache version";
+        return false;
+    }
+    size_t valid = scan(contents, sizeof(tuning_cache_header),
+        [this](tuning_cache_record_type type,
+        const char * payload, size_t size) {
+        payload_reader in(payload, size);
+        if (type == tuning_cache_record_type::VARIABLE) {
+            tuning_variable variable;
+            if (!read_variable(in, variable)) { return false; }
+            variables[variable.id] = variable;
+        } else if (type == tuning_cache_record_type::CONTEXT) {
+            std::string name;
+            std::vector<tuning_value> values;
+            if (!read_context(in, name, values)) { return false; }
+            add(name, values);
+        }
+        // skip the records of newer versions
+        return true;
+    });
+    if (valid < contents.size()) {
+        error = filename + " has an incomplete record at the end";
+    }
+    return true;
+}
+
+bool tuning_cache::add(const std::string &name,
+    const std::vector<tuning_value> &values) {
+    if (!contexts.insert(std::make_pair(name, values)).second) {
+        return false;
+    }
+    names.push_back(name);
+    return true;
+}
+
+static bool write_all(int fd, const std::string &buffer) {
+    size_t written = 0;
+    while (written < buffer.size()) {
+        ssize_t n = ::write(fd, buffer.data() + written,
+            buffer.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) { continue; }
+            return false;
+        }
+        written += (size_t)n;
+    }
+    return true;
+}
+
+static std::string make_header(void) {
+    tuning_cache_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, tuning_cache_magic, sizeof(header.magic));
+    header.version = tuning_cache_version;
+    return std::string((const char*)&header, sizeof(header));
+}
+
+/* How much of each file this process has already checked, so that an
+ * append only reads the records added since by other processes. */
+struct checked_file {
+    dev_t device;
+    ino_t inode;
+    off_t size;
+};
+static std::mutex checked_mutex;
+static std::map<std::string, checked_file> checked_files;
+
+/* Append a record, with the file locked so that records from several
+ * processes don't mix.  A new file gets its header first, and a file that
+ * ends with part of a record (from a crash) is cut back to its last whole
+ * record, or the records after it could never be read. */
+static bool append_record(const std::string &filename,
+    const std::string &record) {
+    int fd = open(filename.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        perror("opening the tuning cache");
+        return false;
+    }
+    if (flock(fd, LOCK_EX) != 0) {
+        perror("locking the tuning cache");
+        close(fd);
+        return false;
+    }
+    bool ok = true;
+    struct stat sb;
+    if (fstat(fd, &sb) != 0) {
+        ok = false;
+    } else if (sb.st_size == 0) {
+        ok = write_all(fd, make_header());
+    } else {
+        // the whole file the first time, then only what is new
+        off_t from = 0;
+        {
+            std::unique_lock<std::mutex> l(checked_mutex);
+            auto it = checked_files.find(filename);
+            if (it != checked_files.end() &&
+                it->second.device == sb.st_dev &&
+                it->second.inode == sb.st_ino &&
+                it->second.size <= sb.st_size) {
+                from = it->second.size;
+            }
+        }
+        std::string contents(sb.st_size - from, '\0');
+        ok = pread(fd, &contents[0], contents.size(), from) ==
+            (ssize_t)contents.size() && (from > 0 || has_header(contents));
+        if (ok) {
+            size_t offset = from > 0 ? 0 : sizeof(tuning_cache_header);
+            size_t valid = scan(contents, offset, [](tuning_cache_record_type,
+                const char *, size_t) { return true; });
+            if (valid < contents.size()) {
+                ok = ftruncate(fd, from + valid) == 0;
+            }
+        }
+    }
+    ok = ok && write_all(fd, record);
+    {
+        std::unique_lock<std::mutex> l(checked_mutex);
+        if (ok && fstat(fd, &sb) == 0) {
+            checked_files[filename] = {sb.st_dev, sb.st_ino, sb.st_size};
+        } else {
+            checked_files.erase(filename);
+        }
+    }
+    flock(fd, LOCK_UN);
+    close(fd);
+    return ok;
+}
+
+bool tuning_cache::append(const std::string &filename,
+    const tuning_variable &variable) {
+    return append_record(filename, variable_record(variable));
+}
+
+bool tuning_cache::append(const std::string &filename,
+    const std::string &name, const std::vector<tuning_value> &values) {
+    return append_record(filename, context_record(name, values));
+}
+
+bool tuning_cache::write(const std::string &filename) const {
+    std::string buffer(make_header());
+    for (auto &v : variables) {
+        buffer.append(variable_record(v.second));
+    }
+    for (auto &name : names) {
+        buffer.append(context_record(name, contexts.at(name)));
+    }
+    std::string temporary(filename + ".tmp." + std::to_string(getpid()));
+    int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror("opening the tuning cache");
+        return false;
+    }
+    bool ok = write_all(fd, buffer);
+    close(fd);
+    // readers see either the old cache or the new one
+    if (!ok || rename(temporary.c_str(), filename.c_str()) != 0) {
+        unlink(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+}
+
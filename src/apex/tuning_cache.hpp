@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2014-2021 Kevin Huck
+ * Copyright (c) 2014-2021 University of Oregon
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+#pragma once
+
+/* The binary cache of converged Kokkos tuning results.
+ *
+ * The file is a tuning_cache_header followed by records, each one a
+ * tuning_cache_record, its payload, and a checksum of the payload:
+ *   VARIABLE: uint64_t id, uint32_t type, category, quantity, then the
+ *             name (a uint32_t length and the characters)
+ *   CONTEXT:  the name, a uint32_t count, then for every tuned variable a
+ *             uint64_t id, a uint32_t type, and the value: 8 bytes for
+ *             numbers, or a string
+ * Results are appended as soon as a context converges, one record per
+ * write() while holding an exclusive lock on the file, so several ranks
+ * and runs can share one cache, and a crash loses at most the record that
+ * was being written.  A reader stops at the first incomplete or corrupt
+ * record.  Use the apex_tuning_cache utility to print caches or to merge
+ * them.
+ */
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace apex {
+
+static const char tuning_cache_magic[8] = {'A','P','E','X','T','U','N','E'};
+static const uint32_t tuning_cache_version = 1;
+
+struct tuning_cache_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+};
+
+enum class tuning_cache_record_type : uint32_t {
+    VARIABLE,
+    CONTEXT
+};
+
+struct tuning_cache_record {
+    tuning_cache_record_type type;
+    uint32_t size; // of the payload
+};
+
+enum class tuning_value_type : uint32_t {
+    DOUBLE,
+    INT64,
+    STRING
+};
+
+/* A tuning variable, with the Kokkos type, category and candidate value
+ * type, so the tuned values can be read back without declaring it again. */
+class tuning_variable {
+public:
+    uint64_t id;
+    std::string name;
+    uint32_t type;
+    uint32_t category;
+    uint32_t quantity;
+};
+
+class tuning_value {
+public:
+    uint64_t id;
+    tuning_value_type type;
+    double dvalue;
+    int64_t lvalue;
+    std::string svalue;
+    tuning_value(void) : id(0), type(tuning_value_type::INT64), dvalue(0.0),
+        lvalue(0) {}
+};
+
+class tuning_cache {
+public:
+    std::unordered_map<uint64_t, tuning_variable> variables;
+    /* The tuned values of every context, by context name */
+    std::unordered_map<std::string, std::vector<tuning_value> > contexts;
+    /* The context names, in the order they were added */
+    std::vector<std::string> names;
+    /* Is this file a binary tuning cache? */
+    static bool is_cache(const std::string &filename);
+    /* Read a cache, and add what it has.  Returns false, with the reason,
+     * if it isn't a cache.  A truncated cache is read up to the first
+     * incomplete record, and the reason is set but true is returned. */
+    bool read(const std::string &filename, std::string &error);
+    /* Add a context, unless it is known.  With several results for the
+     * same context, the first one is kept. */
+    bool add(const std::string &name, const std::vector<tuning_value>
+        &values);
+    /* Append one record to a cache file, creating it if needed */
+    static bool append(const std::string &filename,
+        const tuning_variable &variable);
+    static bool append(const std::string &filename, const std::string &name,
+        const std::vector<tuning_value> &values);
+    /* Write the whole cache to a new file, and move it in place */
+    bool write(const std::string &filename) const;
+};
+
+}
+
@@ -0,0 +1,82 @@
+#include "adaptive_sampling.hpp"
+#include "search_strategy.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <random>
+
+using namespace apex;
+using namespace apex::search;
+using namespace std;
+
+/* 32 configurations, the best one is 13.  Every other configuration is
+ * noisy (5% of its cost), the others are stable (1%). */
+long config;
+std::mt19937_64 generator(42);
+
+double measure(void) {
+    double cost = 1.0 + 0.1 * abs(config - 13);
+    double noise = (config % 2 == 0) ? 0.05 : 0.01;
+    std::normal_distribution<double> d(cost, noise * cost);
+    return d(generator);
+}
+
+/* Tune with the exhaustive search, with this many samples per
+ * configuration, and return the total number of samples */
+size_t tune(adaptive_sampler sampler, long &best) {
+    search_session session;
+    variable v(variable_type::longtype, &config);
+    for (long i = 0 ; i < 32 ; i++) { v.lvalues.push_back(i); }
+    session.add_var("config", v);
+    session.start(strategy_type::EXHAUSTIVE);
+    session.get_new_settings();
+    while (!session.converged()) {
+        if (sampler.add(measure())) {
+            session.evaluate(sampler.cost());
+            session.get_new_settings();
+        }
+    }
+    best = config;
+    return sampler.samples();
+}
+
+int main (int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    int rc = 0;
+    // without adaptive sampling, every sample is an evaluation
+    adaptive_sampler once;
+    if (once.enabled() || !once.add(3.0) || once.cost() != 3.0) {
+        printf("one sample should be a whole evaluation!\n");
+        rc = 1;
+    }
+    long fixed_best = 0;
+    size_t fixed = tune(adaptive_sampler(5, 5), fixed_best);
+    long adaptive_best = 0;
+    adaptive_sampler sampler(2, 10);
+    size_t adaptive = tune(sampler, adaptive_best);
+    printf("fixed: %lu samples, best %ld\n", fixed, fixed_best);
+    printf("adaptive: %lu samples, best %ld\n", adaptive, adaptive_best);
+    if (adaptive_best != 13) {
+        printf("the best configuration wasn't found!\n");
+        rc = 1;
+    }
+    if (adaptive >= fixed) {
+        printf("adaptive sampling should need fewer samples!\n");
+        rc = 1;
+    }
+    // a clearly worse configuration is dropped after the minimum
+    adaptive_sampler race(2, 10);
+    race.add(1.0);
+    race.add(1.01);
+    if (!race.add(1.02)) {
+        printf("a stable configuration should need 3 samples!\n");
+        rc = 1;
+    }
+    race.add(2.0);
+    if (!race.add(2.01) || race.discarded() != 1) {
+        printf("a clearly worse configuration wasn't dropped!\n");
+        rc = 1;
+    }
+    return rc;
+}
+
@@ -0,0 +1,60 @@
+#include "context_model.hpp"
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+using namespace apex;
+using namespace std;
+
+/* A kernel name and a problem size, like most Kokkos contexts */
+vector<context_input> context(const string &kernel, long size) {
+    vector<context_input> inputs;
+    inputs.push_back(context_input(1, kernel));
+    inputs.push_back(context_input(2, (double)size));
+    return inputs;
+}
+
+int main (int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    int rc = 0;
+    context_model model;
+    model.add("axpy 1000", context("axpy", 1000));
+    model.add("axpy 1000000", context("axpy", 1000000));
+    model.add("axpy 4000", context("axpy", 4000));
+    model.add("dot 1100", context("dot", 1100));
+    if (model.add("axpy 1000", context("axpy", 1000)) || model.size() != 4) {
+        printf("a context was added twice!\n");
+        rc = 1;
+    }
+    // the nearest sizes, on a log scale, and only for the same kernel
+    auto nearest = model.nearest(context("axpy", 1500), 2);
+    for (auto &n : nearest) {
+        printf("%s at %f\n", n.second.c_str(), n.first);
+    }
+    if (nearest.size() != 2 || nearest[0].second != "axpy 1000" ||
+        nearest[1].second != "axpy 4000" || nearest[0].first > 1.0) {
+        printf("wrong nearest contexts!\n");
+        rc = 1;
+    }
+    // an exact match is at distance 0
+    nearest = model.nearest(context("axpy", 1000000), 1);
+    if (nearest.size() != 1 || nearest[0].first != 0.0) {
+        printf("an exact match should be at distance 0!\n");
+        rc = 1;
+    }
+    // nothing is similar to an unknown kernel
+    if (!model.nearest(context("gemm", 1000), 2).empty()) {
+        printf("contexts of another kernel are not similar!\n");
+        rc = 1;
+    }
+    // or to a context with other inputs
+    vector<context_input> other(context("axpy", 1000));
+    other.push_back(context_input(3, 1.0));
+    if (!model.nearest(other, 2).empty()) {
+        printf("contexts with other inputs are not similar!\n");
+        rc = 1;
+    }
+    return rc;
+}
+
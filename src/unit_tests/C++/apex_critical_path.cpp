@@ -0,0 +1,76 @@
+#include "apex_api.hpp"
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <string>
+
+#define NUM_THREADS 4
+#define ITERATIONS 10
+
+using namespace apex;
+using namespace std;
+
+void worker(std::shared_ptr<task_wrapper> parent) {
+    register_thread("critical path worker");
+    std::shared_ptr<task_wrapper> task = new_task("worker", UINTMAX_MAX,
+        parent);
+    start(task);
+    for (int i = 0 ; i < ITERATIONS ; i++) {
+        profiler * p = start("nested step");
+        usleep(10000);
+        stop(p);
+    }
+    stop(task);
+    exit_thread();
+}
+
+int main (int argc, char** argv) {
+    APEX_UNUSED(argc);
+    APEX_UNUSED(argv);
+    apex_options::use_critical_path(true);
+    init("apex critical path unit test", 0, 1);
+    std::shared_ptr<task_wrapper> task = new_task("main");
+    start(task);
+    std::thread threads[NUM_THREADS];
+    for (int i = 0 ; i < NUM_THREADS ; i++) {
+        threads[i] = std::thread(worker, task);
+    }
+    // main isn't working while it waits for the workers
+    yield(task);
+    for (int i = 0 ; i < NUM_THREADS ; i++) {
+        threads[i].join();
+    }
+    resume(task);
+    stop(task);
+    string output = dump(false);
+    printf("%s", output.c_str());
+    int rc = 0;
+    size_t found = output.find("Available parallelism");
+    if (found == string::npos) {
+        printf("No critical path report!\n");
+        rc = 1;
+    } else {
+        // the workers ran side by side, so there is parallelism
+        double parallelism = atof(output.c_str() +
+            output.find(':', found) + 1);
+        if (parallelism <= 1.0) {
+            printf("Parallelism is %f, expected more than 1\n", parallelism);
+            rc = 1;
+        }
+    }
+    if (output.find("nested step") == string::npos) {
+        printf("The workers are not on the critical path!\n");
+        rc = 1;
+    }
+    finalize();
+    // yielding and resuming the task doesn't count as another call
+    apex_profile * profile = get_profile("main");
+    if (profile == nullptr || profile->calls != 1) {
+        printf("The resumed task has the wrong number of calls!\n");
+        rc = 1;
+    }
+    cleanup();
+    return rc;
+}
+
@@ -0,0 +1,82 @@
+#include "apex_api.hpp"
+#include <unistd.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <string>
+
+#define NUM_THREADS 4
+#define ITERATIONS 1000
+
+using namespace apex;
+using namespace std;
+
+apex_event_type stall_detected;
+
+void worker(void) {
+    register_thread("flight recorder worker");
+    profiler * p = start(__func__);
+    for (int i = 0 ; i < ITERATIONS ; i++) {
+        profiler * q = start("foo");
+        stop(q);
+        sample_value("bar", i);
+    }
+    stop(p);
+    exit_thread();
+}
+
+int dump_policy(apex_context const context) {
+    APEX_UNUSED(context);
+    if (!dump_flight_recorder()) {
+        printf("Flight recorder dump failed!\n");
+    }
+    return APEX_NOERROR;
+}
+
+bool check_trace(int index) {
+    char name[256];
+    snprintf(name, sizeof(name), "%s/apex_flight_recorder.0.%d.json",
+        apex_options::output_file_path(), index);
+    FILE * f = fopen(name, "r");
+    if (f == nullptr) {
+        printf("%s was not written\n", name);
+        return false;
+    }
+    char line[64] = {0};
+    bool ok = fgets(line, sizeof(line), f) != nullptr && line[0] == '{';
+    fclose(f);
+    printf("%s: %s\n", name, ok ? "OK" : "bad");
+    return ok;
+}
+
+int main (int argc, char** argv) {
+    APEX_UNUSED(argc);
+    APEX_UNUSED(argv);
+    // small buffers, so they wrap around
+    apex_options::use_flight_recorder(true);
+    apex_options::flight_recorder_size(256);
+    init("apex flight recorder unit test", 0, 1);
+    stall_detected = register_custom_event("stall detected");
+    register_policy(stall_detected, dump_policy);
+    profiler * p = start(__func__);
+    std::thread threads[NUM_THREADS];
+    for (int i = 0 ; i < NUM_THREADS ; i++) {
+        threads[i] = std::thread(worker);
+    }
+    for (int i = 0 ; i < NUM_THREADS ; i++) {
+        threads[i].join();
+    }
+    // dump from a policy
+    custom_event(stall_detected, nullptr);
+    // dump on request
+    raise(SIGUSR2);
+    sleep(1);
+    stop(p);
+    finalize();
+    int rc = 0;
+    if (!check_trace(0) || !check_trace(1)) { rc = 1; }
+    cleanup();
+    return rc;
+}
+
@@ -0,0 +1,192 @@
+#include "apex_api.hpp"
+#include <otf2/otf2.h>
+#include <stdio.h>
+#include <map>
+#include <string>
+#include <thread>
+
+#define WORKER_SAMPLES 10
+#define SAMPLER_SAMPLES 20
+
+using namespace apex;
+using namespace std;
+
+/* What we need from the archive to check where the samples went */
+struct trace_data {
+    map<OTF2_StringRef, string> strings;
+    map<OTF2_LocationRef, OTF2_StringRef> locations;
+    map<OTF2_MetricRef, OTF2_StringRef> metrics;
+    map<OTF2_LocationRef, OTF2_TimeStamp> last_stamp;
+    map<string, map<string, int> > samples; // location -> metric -> count
+    bool in_order;
+};
+
+static OTF2_CallbackCode on_string(void * user_data, OTF2_StringRef self,
+    const char * s) {
+    ((trace_data*)user_data)->strings[self] = s;
+    return OTF2_CALLBACK_SUCCESS;
+}
+
+static OTF2_CallbackCode on_location(void * user_data, OTF2_LocationRef self,
+    OTF2_StringRef name, OTF2_LocationType type, uint64_t events,
+    OTF2_LocationGroupRef group) {
+    APEX_UNUSED(type);
+    APEX_UNUSED(events);
+    APEX_UNUSED(group);
+    ((trace_data*)user_data)->locations[self] = name;
+    return OTF2_CALLBACK_SUCCESS;
+}
+
+static OTF2_CallbackCode on_metric_member(void * user_data,
+    OTF2_MetricMemberRef self, OTF2_StringRef name, OTF2_StringRef description,
+    OTF2_MetricType metric_type, OTF2_MetricMode mode, OTF2_Type value_type,
+    OTF2_Base base, int64_t exponent, OTF2_StringRef unit) {
+    APEX_UNUSED(description);
+    APEX_UNUSED(metric_type);
+    APEX_UNUSED(mode);
+    APEX_UNUSED(value_type);
+    APEX_UNUSED(base);
+    APEX_UNUSED(exponent);
+    APEX_UNUSED(unit);
+    // APEX writes one metric class per member, with the same id
+    ((trace_data*)user_data)->metrics[self] = name;
+    return OTF2_CALLBACK_SUCCESS;
+}
+
+static OTF2_CallbackCode on_metric(OTF2_LocationRef location,
+    OTF2_TimeStamp time, void * user_data, OTF2_AttributeList * attributes,
+    OTF2_MetricRef metric, uint8_t count, const OTF2_Type * types,
+    const OTF2_MetricValue * values) {
+    APEX_UNUSED(attributes);
+    APEX_UNUSED(count);
+    APEX_UNUSED(types);
+    APEX_UNUSED(values);
+    trace_data * data = (trace_data*)user_data;
+    if (time < data->last_stamp[location]) {
+        data->in_order = false;
+    }
+    data->last_stamp[location] = time;
+    string where(data->strings[data->locations[location]]);
+    string what(data->strings[data->metrics[metric]]);
+    data->samples[where][what]++;
+    return OTF2_CALLBACK_SUCCESS;
+}
+
+static bool read_trace(const string &anchor, trace_data &data) {
+    OTF2_Reader * reader = OTF2_Reader_Open(anchor.c_str());
+    if (reader == nullptr) { return false; }
+    OTF2_Reader_SetSerialCollectiveCallbacks(reader);
+    OTF2_GlobalDefReader * def_reader = OTF2_Reader_GetGlobalDefReader(reader);
+    OTF2_GlobalDefReaderCallbacks * def_callbacks =
+        OTF2_GlobalDefReaderCallbacks_New();
+    OTF2_GlobalDefReaderCallbacks_SetStringCallback(def_callbacks, on_string);
+    OTF2_GlobalDefReaderCallbacks_SetLocationCallback(def_callbacks,
+        on_location);
+    OTF2_GlobalDefReaderCallbacks_SetMetricMemberCallback(def_callbacks,
+        on_metric_member);
+    OTF2_Reader_RegisterGlobalDefCallbacks(reader, def_reader, def_callbacks,
+        &data);
+    OTF2_GlobalDefReaderCallbacks_Delete(def_callbacks);
+    uint64_t definitions = 0;
+    OTF2_Reader_ReadAllGlobalDefinitions(reader, def_reader, &definitions);
+    for (auto &l : data.locations) {
+        OTF2_Reader_SelectLocation(reader, l.first);
+    }
+    OTF2_Reader_OpenDefFiles(reader);
+    OTF2_Reader_OpenEvtFiles(reader);
+    for (auto &l : data.locations) {
+        // the local definitions map the events to the global ids
+        OTF2_DefReader * local = OTF2_Reader_GetDefReader(reader, l.first);
+        if (local != nullptr) {
+            uint64_t local_definitions = 0;
+            OTF2_Reader_ReadAllLocalDefinitions(reader, local,
+                &local_definitions);
+            OTF2_Reader_CloseDefReader(reader, local);
+        }
+        OTF2_Reader_GetEvtReader(reader, l.first);
+    }
+    OTF2_Reader_CloseDefFiles(reader);
+    OTF2_GlobalEvtReader * evt_reader = OTF2_Reader_GetGlobalEvtReader(reader);
+    OTF2_GlobalEvtReaderCallbacks * evt_callbacks =
+        OTF2_GlobalEvtReaderCallbacks_New();
+    OTF2_GlobalEvtReaderCallbacks_SetMetricCallback(evt_callbacks, on_metric);
+    OTF2_Reader_RegisterGlobalEvtCallbacks(reader, evt_reader, evt_callbacks,
+        &data);
+    OTF2_GlobalEvtReaderCallbacks_Delete(evt_callbacks);
+    uint64_t events = 0;
+    OTF2_Reader_ReadAllGlobalEvents(reader, evt_reader, &events);
+    OTF2_Reader_CloseGlobalEvtReader(reader, evt_reader);
+    OTF2_Reader_CloseEvtFiles(reader);
+    OTF2_Reader_Close(reader);
+    return true;
+}
+
+/* Not registered with APEX, like the threads APEX uses for sampling */
+void sampler(void) {
+    for (int i = 0 ; i < SAMPLER_SAMPLES ; i++) {
+        sample_value("sampler counter", i);
+    }
+}
+
+int main (int argc, char** argv) {
+    APEX_UNUSED(argc);
+    APEX_UNUSED(argv);
+    apex_options::use_otf2(true);
+    init("apex otf2 samplers unit test", 0, 1);
+    profiler * main_profiler = start(__func__);
+    for (int i = 0 ; i < WORKER_SAMPLES ; i++) {
+        sample_value("worker counter", i);
+    }
+    thread t(sampler);
+    t.join();
+    stop(main_profiler);
+    // writes the archive
+    finalize();
+    string anchor(string(apex_options::otf2_archive_path()) + "/" +
+        apex_options::otf2_archive_name() + ".otf2");
+    trace_data data;
+    data.in_order = true;
+    int rc = 0;
+    if (!read_trace(anchor, data)) {
+        printf("Could not read %s\n", anchor.c_str());
+        cleanup();
+        return 1;
+    }
+    for (auto &l : data.samples) {
+        for (auto &m : l.second) {
+            printf("%s : %s : %d\n", l.first.c_str(), m.first.c_str(),
+                m.second);
+        }
+    }
+    // the non-worker thread's samples go to the samplers location...
+    if (data.samples["APEX samplers"]["sampler counter"] != SAMPLER_SAMPLES ||
+        data.samples["APEX samplers"]["worker counter"] != 0) {
+        printf("The samplers location has the wrong samples!\n");
+        rc = 1;
+    }
+    // ...and the worker's samples to its own location
+    int worker = 0;
+    for (auto &l : data.samples) {
+        if (l.first != "APEX samplers") {
+            worker += l.second["worker counter"];
+            if (l.second["sampler counter"] != 0) {
+                printf("%s has samples from a non-worker thread!\n",
+                    l.first.c_str());
+                rc = 1;
+            }
+        }
+    }
+    if (worker != WORKER_SAMPLES) {
+        printf("Found %d of %d worker samples!\n", worker, WORKER_SAMPLES);
+        rc = 1;
+    }
+    if (!data.in_order) {
+        printf("The samples on a location are out of order!\n");
+        rc = 1;
+    }
+    if (rc == 0) {
+        printf("Test passed.\n");
+    }
+    cleanup();
+    return rc;
+}
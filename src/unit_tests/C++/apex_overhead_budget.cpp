@@ -0,0 +1,81 @@
+#include "apex_api.hpp"
+#include <stdio.h>
+#include <math.h>
+#include <chrono>
+
+#define TINY_CALLS 200000
+#define LONG_CALLS 1100
+
+using namespace apex;
+using namespace std;
+
+volatile double sink = 0.0;
+
+/* Busy work for about the given number of microseconds */
+void work(int microseconds) {
+    auto end = chrono::steady_clock::now() + chrono::microseconds(microseconds);
+    while (chrono::steady_clock::now() < end) {
+        sink = sink + 1.0;
+    }
+}
+
+/* Returns how many of the calls were measured */
+int run(const char * name, int calls, int microseconds) {
+    int measured = 0;
+    for (int i = 0 ; i < calls ; i++) {
+        profiler * p = start(name);
+        if (p != profiler::get_disabled_profiler()) {
+            measured++;
+        }
+        if (microseconds > 0) {
+            work(microseconds);
+        } else {
+            sink = sink + 1.0;
+        }
+        stop(p);
+    }
+    return measured;
+}
+
+int main (int argc, char** argv) {
+    APEX_UNUSED(argc);
+    APEX_UNUSED(argv);
+    apex_options::overhead_budget(0.01);
+    init("apex overhead budget unit test", 0, 1);
+    profiler * main_profiler = start(__func__);
+    // far shorter than measuring it, so only some calls are measured...
+    int tiny = run("tiny timer", TINY_CALLS, 0);
+    // ...and long enough that measuring every call is within the budget
+    int longer = run("long timer", LONG_CALLS, 1000);
+    stop(main_profiler);
+    finalize();
+    int rc = 0;
+    printf("tiny timer: measured %d of %d calls\n", tiny, TINY_CALLS);
+    printf("long timer: measured %d of %d calls\n", longer, LONG_CALLS);
+    if (tiny > TINY_CALLS / 4) {
+        printf("The tiny timer should have been sampled!\n");
+        rc = 1;
+    }
+    if (longer != LONG_CALLS) {
+        printf("Every call to the long timer should have been measured!\n");
+        rc = 1;
+    }
+    // each measured call counts for the calls that were skipped
+    apex_profile * profile = get_profile("tiny timer");
+    if (profile == nullptr ||
+        fabs(profile->calls - TINY_CALLS) > TINY_CALLS * 0.25) {
+        printf("The tiny timer has %f calls, not about %d!\n",
+            profile == nullptr ? 0.0 : profile->calls, TINY_CALLS);
+        rc = 1;
+    }
+    profile = get_profile("long timer");
+    if (profile == nullptr || profile->calls != LONG_CALLS) {
+        printf("The long timer has the wrong number of calls!\n");
+        rc = 1;
+    }
+    if (rc == 0) {
+        printf("Test passed.\n");
+    }
+    cleanup();
+    return rc;
+}
@@ -0,0 +1,60 @@
+#include "apex_api.hpp"
+#include <stdio.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#define NUM_THREADS 4
+#define ITERATIONS 100000
+#define REGISTRATIONS 1000
+
+using namespace apex;
+using namespace std;
+
+std::atomic<size_t> stops(0);
+
+int count_stops(apex_context const &context) {
+    APEX_UNUSED(context);
+    stops++;
+    return APEX_NOERROR;
+}
+
+int do_nothing(apex_context const &context) {
+    APEX_UNUSED(context);
+    return APEX_NOERROR;
+}
+
+void worker(void) {
+    register_thread("churn worker");
+    for (int i = 0 ; i < ITERATIONS ; i++) {
+        profiler * p = start("churn timer");
+        stop(p);
+    }
+    exit_thread();
+}
+
+int main (int argc, char** argv) {
+    APEX_UNUSED(argc);
+    APEX_UNUSED(argv);
+    init("apex policy churn unit test", 0, 1);
+    apex_policy_handle * counter = register_policy(APEX_STOP_EVENT,
+        count_stops);
+    vector<thread> threads;
+    for (int i = 0 ; i < NUM_THREADS ; i++) {
+        threads.push_back(thread(worker));
+    }
+    /* Registering and deregistering other policies while the workers run
+     * must not keep the counting policy from seeing every stop. */
+    for (int i = 0 ; i < REGISTRATIONS ; i++) {
+        apex_policy_handle * other = register_policy(APEX_STOP_EVENT,
+            do_nothing);
+        deregister_policy(other);
+    }
+    for (auto &t : threads) { t.join(); }
+    deregister_policy(counter);
+    size_t expected = (size_t)NUM_THREADS * ITERATIONS;
+    printf("%lu of %lu stops seen by the policy\n", stops.load(), expected);
+    finalize();
+    cleanup();
+    return stops == expected ? 0 : 1;
+}
@@ -0,0 +1,43 @@
+#include "apex_api.hpp"
+#include "apex_options.hpp"
+#include <stdio.h>
+#include <unistd.h>
+#include <chrono>
+#include <fstream>
+#include <string>
+
+using namespace apex;
+using namespace std;
+
+int main (int argc, char** argv) {
+    APEX_UNUSED(argc);
+    APEX_UNUSED(argv);
+    // one rule: as soon as the timer is running, cap the threads at 3
+    static char filename[] = "apex_policy_rules_test.json";
+    ofstream rules(filename);
+    rules << "{ \"rules\": [\n"
+          << "  { \"timer\": \"rules test timer\", \"metric\": \"rate\",\n"
+          << "    \"above\": 0, \"periods\": 1,\n"
+          << "    \"action\": \"set_thread_cap\", \"value\": 3 } ] }\n";
+    rules.close();
+    apex_options::policy_rules_file(filename);
+    apex_options::policy_rules_period(100000);
+    init("apex policy rules unit test", 0, 1);
+    auto begin = chrono::steady_clock::now();
+    while (chrono::steady_clock::now() - begin < chrono::milliseconds(500)) {
+        profiler * p = start("rules test timer");
+        usleep(1000);
+        stop(p);
+    }
+    int cap = get_thread_cap();
+    printf("Thread cap: %d\n", cap);
+    int rc = 0;
+    if (cap != 3) {
+        printf("The rule didn't set the thread cap!\n");
+        rc = 1;
+    }
+    finalize();
+    cleanup();
+    unlink(filename);
+    return rc;
+}
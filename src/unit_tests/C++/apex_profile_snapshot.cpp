@@ -0,0 +1,100 @@
+#include "apex_api.hpp"
+#include "profile_snapshot.hpp"
+#include <unistd.h>
+#include <string.h>
+#include <sstream>
+#include <fstream>
+#include <iterator>
+
+using namespace apex;
+using namespace std;
+
+/* Write a damaged copy of a snapshot, and make sure it is rejected. */
+bool rejected(const string &contents, const string &what) {
+  const string damaged("apex_profile_damaged.snap");
+  {
+    ofstream out(damaged, ios::binary);
+    out.write(contents.data(), contents.size());
+  }
+  snapshot_reader reader(damaged);
+  unlink(damaged.c_str());
+  if (reader.valid()) {
+    cerr << "A " << what << " snapshot was accepted!" << endl;
+    return false;
+  }
+  cout << what << ": " << reader.error() << endl;
+  return true;
+}
+
+int main (int argc, char** argv) {
+  APEX_UNUSED(argc);
+  APEX_UNUSED(argv);
+  init("apex profile snapshot unit test", 0, 1);
+  apex_options::use_profile_snapshot(true);
+  cout << "APEX Version : " << version() << endl;
+  profiler * main_profiler = start(__func__);
+  // Call "foo" 30 times
+  for(int i = 0; i < 30; ++i) {
+    profiler * p = start("foo");
+    stop(p);
+  }
+  // Sample "bar" 40 times
+  for(int i = 0; i < 40; ++i) {
+    sample_value("bar", i);
+  }
+  stop(main_profiler);
+  // writes the snapshot
+  dump(false);
+
+  stringstream filename;
+  filename << apex_options::output_file_path() << "/"
+           << snapshot_filename << "0" << snapshot_extension;
+  snapshot_reader reader(filename.str());
+  if (!reader.valid()) {
+    cerr << reader.error() << endl;
+    finalize();
+    cleanup();
+    return 1;
+  }
+  int rc = 1;
+  const double * calls = reader.column(SNAPSHOT_CALLS);
+  const double * maximum = reader.column(SNAPSHOT_MAXIMUM);
+  for (size_t i = 0 ; i < reader.size() ; i++) {
+    cout << reader.name(i) << " : " << calls[i] << endl;
+    if (strcmp(reader.name(i), "bar") == 0 &&
+        calls[i] == 40 && maximum[i] == 39) {
+      rc = 0;
+    }
+  }
+  // truncated and corrupt copies of the file
+  ifstream in(filename.str(), ios::binary);
+  string contents((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+  snapshot_header header;
+  memcpy(&header, contents.data(), sizeof(header));
+  string copy(contents.substr(0, header.strings_offset + 1));
+  header.file_size = copy.size();
+  memcpy(&copy[0], &header, sizeof(header));
+  if (!rejected(copy, "truncated")) { rc = 1; }
+  memcpy(&header, contents.data(), sizeof(header));
+  header.column_offsets[SNAPSHOT_MAXIMUM] = contents.size();
+  copy = contents;
+  memcpy(&copy[0], &header, sizeof(header));
+  if (!rejected(copy, "bad column offset")) { rc = 1; }
+  memcpy(&header, contents.data(), sizeof(header));
+  header.num_profiles = (uint64_t)1 << 60;
+  copy = contents;
+  memcpy(&copy[0], &header, sizeof(header));
+  if (!rejected(copy, "bad profile count")) { rc = 1; }
+  memcpy(&header, contents.data(), sizeof(header));
+  copy = contents;
+  uint64_t bad_name = header.strings_size;
+  memcpy(&copy[header.names_offset], &bad_name, sizeof(bad_name));
+  if (!rejected(copy, "bad name offset")) { rc = 1; }
+  if (rc == 0) {
+    std::cout << "Test passed." << std::endl;
+  }
+  finalize();
+  cleanup();
+  return rc;
+}
+
@@ -0,0 +1,57 @@
+#include "apex_api.hpp"
+#include <unistd.h>
+#include <stdio.h>
+#include <memory>
+#include <vector>
+
+#define NUM_TASKS 100
+#define WAIT_USEC 10000
+
+using namespace apex;
+using namespace std;
+
+int main (int argc, char** argv) {
+    APEX_UNUSED(argc);
+    APEX_UNUSED(argv);
+    apex_options::use_queue_wait(true);
+    init("apex queue wait unit test", 0, 1);
+    apex_options::use_screen_output(true);
+    profiler * p = start(__func__);
+    // create the tasks, and let them sit in the "queue" for a while
+    vector<std::shared_ptr<task_wrapper> > tasks;
+    for (int i = 0 ; i < NUM_TASKS ; i++) {
+        tasks.push_back(new_task("queued task"));
+    }
+    usleep(WAIT_USEC);
+    for (auto task : tasks) {
+        start(task);
+        stop(task);
+    }
+    stop(p);
+    apex_queue_wait wait = get_queue_wait("queued task");
+    printf("tasks: %.0f, mean wait: %f us, median: %f us, max: %f us\n",
+        wait.calls, wait.mean * 1.0e-3, wait.median * 1.0e-3,
+        wait.maximum * 1.0e-3);
+    int rc = 0;
+    if (wait.calls != NUM_TASKS) {
+        printf("Expected %d tasks!\n", NUM_TASKS);
+        rc = 1;
+    }
+    /* The median is the middle of a histogram bucket, and a bucket can
+     * start at 4/5 of the values in it. */
+    if (wait.mean < WAIT_USEC * 1.0e3 || wait.median < WAIT_USEC * 0.8e3 ||
+        wait.maximum < wait.p99 || wait.p99 < wait.median) {
+        printf("The queue wait is wrong!\n");
+        rc = 1;
+    }
+    // the timers that were never queued have no queue wait
+    apex_queue_wait none = get_queue_wait(__func__);
+    if (none.calls != 0) {
+        printf("%s should have no queue wait!\n", __func__);
+        rc = 1;
+    }
+    finalize();
+    cleanup();
+    return rc;
+}
+
@@ -0,0 +1,81 @@
+#include "apex_api.hpp"
+#include "event_log.hpp"
+#include <stdio.h>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define NUM_THREADS 4
+#define NUM_TASKS 1000
+
+using namespace apex;
+using namespace std;
+
+void worker(void) {
+    register_thread("record worker");
+    for (int i = 0 ; i < NUM_TASKS ; i++) {
+        std::shared_ptr<task_wrapper> task = new_task("recorded task");
+        start(task);
+        sample_value("recorded counter", (double)i);
+        stop(task);
+    }
+    exit_thread();
+}
+
+int main (int argc, char** argv) {
+    APEX_UNUSED(argc);
+    APEX_UNUSED(argv);
+    apex_options::use_record_events(true);
+    init("apex record events unit test", 0, 1);
+    profiler * p = start(__func__);
+    vector<thread> threads;
+    for (int i = 0 ; i < NUM_THREADS ; i++) {
+        threads.push_back(thread(worker));
+    }
+    for (auto &t : threads) { t.join(); }
+    // resuming by name has no task_wrapper with a profiler yet
+    profiler * r = resume("resumed by name");
+    stop(r);
+    stop(p);
+    finalize();
+    // read the log back
+    string filename(apex_options::output_file_path());
+    filename += "/apex_events.0.bin";
+    event_log_reader log(filename);
+    if (!log.ok()) {
+        printf("Error: %s\n", log.error().c_str());
+        cleanup();
+        return 1;
+    }
+    size_t starts = 0, stops = 0, samples = 0, resumes = 0;
+    for (auto &e : log.events) {
+        const string &name = log.names[e.name];
+        if (e.type == recorded_event_type::START && name == "recorded task") {
+            starts++;
+        } else if (e.type == recorded_event_type::STOP &&
+            name == "recorded task") {
+            stops++;
+        } else if (e.type == recorded_event_type::SAMPLE &&
+            name == "recorded counter") {
+            samples++;
+        } else if (e.type == recorded_event_type::RESUME &&
+            name == "resumed by name") {
+            resumes++;
+        }
+    }
+    printf("%lu events, %lu names: %lu starts, %lu stops, %lu samples\n",
+        log.events.size(), log.names.size(), starts, stops, samples);
+    int rc = 0;
+    if (starts != NUM_THREADS * NUM_TASKS || stops != starts ||
+        samples != starts) {
+        printf("Expected %d of each!\n", NUM_THREADS * NUM_TASKS);
+        rc = 1;
+    }
+    if (resumes != 1) {
+        printf("Expected one resume, not %lu!\n", resumes);
+        rc = 1;
+    }
+    cleanup();
+    return rc;
+}
@@ -0,0 +1,66 @@
+#include "apex_api.hpp"
+#include <pthread.h>
+#include <unistd.h>
+#include <iostream>
+
+using namespace apex;
+using namespace std;
+
+#define NUM_THREADS 4
+#define NUM_SAMPLES 1000
+
+apex_counter_handle counter;
+
+void* someThread(void* tmp)
+{
+  APEX_UNUSED(tmp);
+  register_thread("counter thread");
+  // less than one batch from each thread stays behind until exit_thread
+  for (int i = 1 ; i <= NUM_SAMPLES ; i++) {
+    sample_value(counter, (double)i);
+  }
+  exit_thread();
+  return NULL;
+}
+
+int main (int argc, char** argv) {
+  APEX_UNUSED(argc);
+  APEX_UNUSED(argv);
+  init("apex::register_counter unit test", 0, 1);
+  cout << "APEX Version : " << version() << endl;
+  apex_options::counter_batch_size(64);
+  counter = register_counter("counterA");
+  // registering the same name again gives the same handle
+  if (register_counter("counterA") != counter) {
+    cout << "Test failed: duplicate handle." << endl;
+    return 1;
+  }
+  apex_counter_handle counterB = register_counter("counterB");
+  profiler* p = start("main");
+  pthread_t thread[NUM_THREADS];
+  for (int i = 0 ; i < NUM_THREADS ; i++) {
+    pthread_create(&(thread[i]), NULL, someThread, NULL);
+  }
+  for (int i = 0 ; i < NUM_THREADS ; i++) {
+    pthread_join(thread[i], NULL);
+  }
+  // fewer samples than a batch, only handed over by the dump
+  sample_value(counterB, 2.0);
+  sample_value(counterB, 4.0);
+  stop(p);
+  finalize();
+  apex_profile * profileA = get_profile("counterA");
+  apex_profile * profileB = get_profile("counterB");
+  if (profileA && profileB) {
+    cout << "counterA calls : " << profileA->calls << endl;
+    cout << "counterB calls : " << profileB->calls << endl;
+    if (profileA->calls == NUM_THREADS * NUM_SAMPLES &&
+        profileA->minimum == 1.0 && profileA->maximum == NUM_SAMPLES &&
+        profileB->calls == 2 && profileB->accumulated == 6.0) {
+      cout << "Test passed." << endl;
+    }
+  }
+  cleanup();
+  return 0;
+}
+
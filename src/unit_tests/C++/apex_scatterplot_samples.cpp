@@ -0,0 +1,98 @@
+#include "apex_api.hpp"
+#include "scatterplot_samples.hpp"
+#include <stdio.h>
+#include <unistd.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define NUM_THREADS 4
+#define CAPACITY 100
+
+using namespace apex;
+using namespace std;
+
+const string filename("apex_scatterplot_test.bin");
+
+void worker(int index) {
+    // like the profiler, each thread has its own identifiers, which
+    // are kept until the program exits
+    task_identifier * foo = new task_identifier("scatter foo");
+    task_identifier * bar = new task_identifier("scatter bar");
+    for (int i = 0 ; i < 1000 ; i++) {
+        scatterplot_add(foo, (double)i, (double)index, false);
+    }
+    for (int i = 0 ; i < 10 ; i++) {
+        scatterplot_add(bar, (double)i, (double)index, false);
+    }
+}
+
+int main (int argc, char** argv) {
+    APEX_UNUSED(argc);
+    APEX_UNUSED(argv);
+    init("apex scatterplot samples unit test", 0, 1);
+    apex_options::scatterplot_reservoir_size(CAPACITY);
+    vector<thread> threads;
+    for (int i = 0 ; i < NUM_THREADS ; i++) {
+        threads.push_back(thread(worker, i));
+    }
+    for (auto &t : threads) { t.join(); }
+    int rc = 0;
+    if (!scatterplot_write(filename, false)) {
+        printf("Failed to write %s\n", filename.c_str());
+        rc = 1;
+    }
+    scatterplot_reader reader(filename);
+    unlink(filename.c_str());
+    if (!reader.valid()) {
+        printf("Error: %s\n", reader.error().c_str());
+        finalize();
+        cleanup();
+        return 1;
+    }
+    // one merged set of samples per timer, not one per thread
+    int foo = -1, bar = -1;
+    for (size_t i = 0 ; i < reader.names.size() ; i++) {
+        if (reader.names[i] == "scatter foo") {
+            if (foo >= 0) { rc = 1; }
+            foo = (int)i;
+        } else if (reader.names[i] == "scatter bar") {
+            if (bar >= 0) { rc = 1; }
+            bar = (int)i;
+        }
+    }
+    if (rc != 0 || foo < 0 || bar < 0) {
+        printf("The timers were not merged by name!\n");
+        rc = 1;
+    }
+    size_t foos = 0, bars = 0;
+    vector<size_t> per_thread(NUM_THREADS, 0);
+    for (auto &s : reader.samples) {
+        if ((int)s.id == foo) {
+            foos++;
+            per_thread[(size_t)s.value]++;
+        } else if ((int)s.id == bar) {
+            bars++;
+        }
+    }
+    // a busy timer keeps a full reservoir, a quiet one keeps every call
+    printf("%lu foo samples, %lu bar samples\n", (unsigned long)foos,
+        (unsigned long)bars);
+    if (foos != CAPACITY || bars != NUM_THREADS * 10) {
+        printf("Wrong number of samples!\n");
+        rc = 1;
+    }
+    // every thread made as many calls, so every thread should be sampled
+    for (int i = 0 ; i < NUM_THREADS ; i++) {
+        if (per_thread[i] == 0) {
+            printf("No samples from thread %d!\n", i);
+            rc = 1;
+        }
+    }
+    if (rc == 0) {
+        printf("Test passed.\n");
+    }
+    finalize();
+    cleanup();
+    return rc;
+}
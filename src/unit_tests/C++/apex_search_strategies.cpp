@@ -0,0 +1,89 @@
+#include "search_strategy.hpp"
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+
+using namespace apex::search;
+using namespace std;
+
+/* A synthetic objective, with its minimum (0) at x = 41, y = 0.3, z = "c" */
+long x;
+double y;
+const char * z;
+
+double objective(void) {
+    double cost = (x - 41) * (x - 41) / 100.0 + (y - 0.3) * (y - 0.3) * 10.0;
+    return strcmp(z, "c") == 0 ? cost : cost + 1.0;
+}
+
+void add_vars(search_session &session) {
+    variable vx(variable_type::longtype, &x);
+    for (long i = 0 ; i < 64 ; i++) { vx.lvalues.push_back(i); }
+    vx.initial = 8;
+    session.add_var("x", vx);
+    variable vy(variable_type::doubletype, &y);
+    for (int i = 0 ; i <= 20 ; i++) { vy.dvalues.push_back(i * 0.05); }
+    vy.initial = 20;
+    session.add_var("y", vy);
+    variable vz(variable_type::stringtype, &z);
+    vz.svalues = {"a", "b", "c", "d"};
+    vz.initial = 0;
+    session.add_var("z", vz);
+}
+
+/* Run one search to the end, and check how close it got */
+bool run(const char * name, strategy_type type, double tolerance,
+    size_t max_evaluations) {
+    search_session session;
+    add_vars(session);
+    session.start(type, 0, 42);
+    auto start = chrono::steady_clock::now();
+    session.get_new_settings();
+    while (!session.converged()) {
+        session.evaluate(objective());
+        session.get_new_settings();
+    }
+    // the objective is trivial, this is the time to propose the points
+    double per_point = chrono::duration<double>(chrono::steady_clock::now() -
+        start).count() / (session.get_evaluations() + 1);
+    // the best values are written back when the search is over
+    double best = objective();
+    printf("%20s : %5lu evaluations, best cost %f, x = %ld, y = %.2f, z = %s, "
+        "%.1f us per point\n", name, session.get_evaluations(), best, x, y, z,
+        per_point * 1.0e6);
+    bool ok = true;
+    if (best != session.get_best_cost() || best > tolerance) {
+        printf("%s didn't converge!\n", name);
+        ok = false;
+    }
+    if (session.get_evaluations() > max_evaluations) {
+        printf("%s took too many evaluations!\n", name);
+        ok = false;
+    }
+    if (per_point > 1.0e-3) {
+        printf("%s took too long to propose a point!\n", name);
+        ok = false;
+    }
+    return ok;
+}
+
+int main (int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    int rc = 0;
+    if (!run("exhaustive", strategy_type::EXHAUSTIVE, 1.0e-6, 64 * 21 * 4)) {
+        rc = 1;
+    }
+    if (!run("random", strategy_type::RANDOM, 1.5, 100)) { rc = 1; }
+    if (!run("nelder mead", strategy_type::NELDER_MEAD, 1.0e-6, 500)) {
+        rc = 1;
+    }
+    if (!run("coordinate descent", strategy_type::COORDINATE_DESCENT, 1.0e-6,
+        500)) {
+        rc = 1;
+    }
+    // the model should need fewer points than the random search
+    if (!run("tpe", strategy_type::TPE, 1.0e-6, 100)) { rc = 1; }
+    return rc;
+}
@@ -0,0 +1,81 @@
+#include "apex_api.hpp"
+#include "shared_profile.hpp"
+#include <stdio.h>
+#include <unistd.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define NUM_THREADS 4
+#define NUM_CALLS 1000
+
+using namespace apex;
+using namespace std;
+
+void worker(void) {
+    register_thread("shared profile worker");
+    for (int i = 0 ; i < NUM_CALLS ; i++) {
+        profiler * p = start("shared foo");
+        stop(p);
+    }
+    exit_thread();
+}
+
+int main (int argc, char** argv) {
+    APEX_UNUSED(argc);
+    APEX_UNUSED(argv);
+    apex_options::use_shared_profile(true);
+    init("apex shared profile unit test", 0, 1);
+    profiler * main_profiler = start(__func__);
+    vector<thread> threads;
+    for (int i = 0 ; i < NUM_THREADS ; i++) {
+        threads.push_back(thread(worker));
+    }
+    for (auto &t : threads) { t.join(); }
+    for (int i = 0 ; i < 40 ; i++) {
+        sample_value("shared bar", i);
+    }
+    stop(main_profiler);
+    // attach to the live profile, like apex_top does
+    shared_profile_reader reader(getpid());
+    if (!reader.valid()) {
+        printf("Error: %s\n", reader.error().c_str());
+        finalize();
+        cleanup();
+        return 1;
+    }
+    // all of the queued timers are processed by now, and a reader that
+    // is already attached still sees the final values
+    finalize();
+    vector<shared_profile_row> rows;
+    reader.read(rows);
+    int foos = 0, bars = 0;
+    int rc = 0;
+    for (auto &row : rows) {
+        printf("%s : %f\n", row.name.c_str(), row.calls);
+        if (row.name == "shared foo") {
+            foos++;
+            if (row.calls != NUM_THREADS * NUM_CALLS) {
+                printf("Wrong number of calls!\n");
+                rc = 1;
+            }
+        } else if (row.name == "shared bar") {
+            bars++;
+            if (row.calls != 40 || row.minimum != 0 || row.maximum != 39 ||
+                row.accumulated != 780) {
+                printf("Wrong counter values!\n");
+                rc = 1;
+            }
+        }
+    }
+    // each profile has exactly one entry, even when threads race for it
+    if (foos != 1 || bars != 1) {
+        printf("%d entries for the timer, %d for the counter!\n", foos, bars);
+        rc = 1;
+    }
+    if (rc == 0) {
+        printf("Test passed.\n");
+    }
+    cleanup();
+    return rc;
+}
@@ -0,0 +1,97 @@
+#include "apex_api.hpp"
+#include <stdio.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define NUM_THREADS 4
+#define ITERATIONS 100000
+
+using namespace apex;
+using namespace std;
+
+atomic<bool> done(false);
+const task_identifier counter("consistent counter");
+
+/* every sample is 2, so a consistent copy always has accumulated equal
+ * to twice the calls */
+void worker(void) {
+    register_thread("sample worker");
+    for (int i = 0 ; i < ITERATIONS ; i++) {
+        sample_value("consistent counter", 2.0);
+    }
+    exit_thread();
+}
+
+size_t reader(void) {
+    size_t torn = 0;
+    uint64_t last_version = 0;
+    while (!done) {
+        apex_profile values;
+        if (get_profile("consistent counter", values) &&
+            values.accumulated != values.calls * 2.0) {
+            torn++;
+        }
+        auto set = snapshot_profiles();
+        if (set->version < last_version) { torn++; }
+        last_version = set->version;
+        for (size_t i = 0 ; i < set->size() ; i++) {
+            if (set->ids[i] == counter &&
+                set->profiles[i].accumulated != set->profiles[i].calls * 2.0) {
+                torn++;
+            }
+        }
+    }
+    return torn;
+}
+
+int main (int argc, char** argv) {
+    APEX_UNUSED(argc);
+    APEX_UNUSED(argv);
+    init("apex snapshot profiles unit test", 0, 1);
+    size_t torn = 0;
+    thread check([&torn]() { torn = reader(); });
+    vector<thread> threads;
+    for (int i = 0 ; i < NUM_THREADS ; i++) {
+        threads.push_back(thread(worker));
+    }
+    for (auto &t : threads) { t.join(); }
+    done = true;
+    check.join();
+    int rc = 0;
+    if (torn > 0) {
+        printf("%lu inconsistent copies!\n", torn);
+        rc = 1;
+    }
+    // nothing changed, so the same set is returned again
+    auto first = snapshot_profiles();
+    auto second = snapshot_profiles();
+    if (first != second) {
+        printf("The unchanged set was copied again!\n");
+        rc = 1;
+    }
+    double calls = 0.0;
+    for (size_t i = 0 ; i < first->size() ; i++) {
+        if (first->ids[i] == counter) {
+            calls = first->profiles[i].calls;
+        }
+    }
+    printf("%lu profiles, version %lu, %f samples\n", first->size(),
+        first->version, calls);
+    if (calls != (double)NUM_THREADS * ITERATIONS) {
+        printf("Expected %d samples!\n", NUM_THREADS * ITERATIONS);
+        rc = 1;
+    }
+    bool listed = false;
+    for (auto &id : get_available_profiles_copy()) {
+        if (id == counter) { listed = true; }
+    }
+    if (!listed) {
+        printf("The counter isn't in the available profiles!\n");
+        rc = 1;
+    }
+    finalize();
+    cleanup();
+    return rc;
+}
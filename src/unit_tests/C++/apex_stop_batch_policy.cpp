@@ -0,0 +1,68 @@
+#include "apex_api.hpp"
+#include "task_identifier.hpp"
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define NUM_THREADS 4
+#define ITERATIONS 10000
+
+using namespace apex;
+using namespace std;
+
+/* only the batch thread touches these */
+size_t stops = 0;
+size_t batches = 0;
+double total_duration = 0.0;
+
+int count_stops(apex_stop_event const * events, size_t count) {
+    static const string name("batched timer");
+    for (size_t i = 0 ; i < count ; i++) {
+        task_identifier * id = (task_identifier*)(events[i].task_id);
+        if (id->get_name() == name) {
+            total_duration += events[i].duration;
+            stops++;
+        }
+    }
+    batches++;
+    return APEX_NOERROR;
+}
+
+void worker(void) {
+    register_thread("batch worker");
+    for (int i = 0 ; i < ITERATIONS ; i++) {
+        profiler * p = start("batched timer");
+        stop(p);
+    }
+    exit_thread();
+}
+
+int main (int argc, char** argv) {
+    APEX_UNUSED(argc);
+    APEX_UNUSED(argv);
+    init("apex stop batch policy unit test", 0, 1);
+    apex_policy_handle * handle = register_stop_batch_policy(count_stops);
+    vector<thread> threads;
+    for (int i = 0 ; i < NUM_THREADS ; i++) {
+        threads.push_back(thread(worker));
+    }
+    for (auto &t : threads) { t.join(); }
+    // the policy gets the rest of the stops before it is removed
+    deregister_policy(handle);
+    size_t expected = (size_t)NUM_THREADS * ITERATIONS;
+    printf("%lu stops in %lu batches, %f ns per stop\n", stops, batches,
+        stops > 0 ? total_duration / stops : 0.0);
+    int rc = 0;
+    if (stops != expected) {
+        printf("Expected %lu stops!\n", expected);
+        rc = 1;
+    }
+    if (batches == 0 || batches >= stops) {
+        printf("The stops weren't batched!\n");
+        rc = 1;
+    }
+    finalize();
+    cleanup();
+    return rc;
+}
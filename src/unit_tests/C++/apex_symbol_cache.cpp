@@ -0,0 +1,100 @@
+#include "address_resolution.hpp"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <fstream>
+#include <string>
+
+using namespace apex;
+using namespace std;
+
+const string directory("apex_symbol_cache_test");
+
+bool same(const symbol_cache_module::entry &a,
+    const symbol_cache_module::entry &b) {
+    return a.lineno == b.lineno && a.funcname == b.funcname &&
+        a.demangled == b.demangled && a.filename == b.filename;
+}
+
+symbol_cache_module::entry make_entry(int lineno, const string &funcname,
+    const string &demangled, const string &filename) {
+    symbol_cache_module::entry e;
+    e.lineno = lineno;
+    e.funcname = funcname;
+    e.demangled = demangled;
+    e.filename = filename;
+    return e;
+}
+
+int main (int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    int rc = 0;
+    mkdir(directory.c_str(), 0755);
+    apex_options::symbol_cache_path(strdup(directory.c_str()));
+
+    // write a cache, and read it back
+    symbol_cache_module written;
+    written.build_id = "0123456789abcdef";
+    written.entries[0x1040] = make_entry(12, "_Z3fooi", "foo(int)",
+        "/src/foo file.cpp");
+    written.entries[0x2080] = make_entry(0, "bar", "", "");
+    written.dirty = true;
+    unlink(written.filename().c_str());
+    written.save();
+    symbol_cache_module read;
+    read.build_id = written.build_id;
+    read.load();
+    if (read.entries.size() != written.entries.size()) {
+        printf("read %zu entries, expected %zu!\n", read.entries.size(),
+            written.entries.size());
+        rc = 1;
+    }
+    for (auto &kv : written.entries) {
+        auto found = read.entries.find(kv.first);
+        if (found == read.entries.end() || !same(found->second, kv.second)) {
+            printf("entry 0x%lx was not read back!\n",
+                (unsigned long)kv.first);
+            rc = 1;
+        }
+    }
+
+    // a missing cache has no entries
+    symbol_cache_module missing;
+    missing.build_id = "fedcba9876543210";
+    unlink(missing.filename().c_str());
+    missing.load();
+    if (!missing.loaded || missing.entries.size() != 0) {
+        printf("a missing cache has entries!\n");
+        rc = 1;
+    }
+
+    // lines with the wrong number of fields are skipped
+    symbol_cache_module invalid;
+    invalid.build_id = "00ff00ff00ff00ff";
+    {
+        ofstream out(invalid.filename());
+        out << "not a symbol cache\n";
+        out << "1040\t12\tfoo\n";
+        out << "\n";
+        out << "3000\t7\tbaz\t\tbaz.c\n";
+        out << "4000\t1\ta\tb\tc\td\n";
+    }
+    invalid.load();
+    auto found = invalid.entries.find(0x3000);
+    if (invalid.entries.size() != 1 || found == invalid.entries.end() ||
+        !same(found->second, make_entry(7, "baz", "", "baz.c"))) {
+        printf("read %zu entries from an invalid cache, expected 1!\n",
+            invalid.entries.size());
+        rc = 1;
+    }
+
+    unlink(written.filename().c_str());
+    unlink(invalid.filename().c_str());
+    rmdir(directory.c_str());
+    if (rc == 0) {
+        printf("Test passed.\n");
+    }
+    return rc;
+}
@@ -0,0 +1,44 @@
+#include "apex_api.hpp"
+#include <stdio.h>
+#include <memory>
+
+#define CHAIN_LENGTH 10000
+
+using namespace apex;
+using namespace std;
+
+int main (int argc, char** argv) {
+    APEX_UNUSED(argc);
+    APEX_UNUSED(argv);
+    apex_options::use_taskgraph_output(true);
+    init("apex task chain unit test", 0, 1);
+    profiler * p = start(__func__);
+    /* Each task only lives as long as its child needs it to, like a chain
+     * of continuations.  The ancestors must not be kept alive. */
+    std::shared_ptr<task_wrapper> first = new_task("chained task");
+    std::weak_ptr<task_wrapper> watch(first);
+    std::shared_ptr<task_wrapper> parent = first;
+    first = nullptr;
+    for (int i = 0 ; i < CHAIN_LENGTH ; i++) {
+        std::shared_ptr<task_wrapper> child =
+            new_task("chained task", UINTMAX_MAX, parent);
+        if (child->parent_guid != parent->guid) {
+            printf("The parent GUID is wrong!\n");
+            return 1;
+        }
+        start(child);
+        stop(child);
+        parent = child;
+    }
+    stop(p);
+    int rc = 0;
+    // the profilers waiting to be processed hold their tasks, so finish first
+    finalize();
+    if (!watch.expired()) {
+        printf("The first task in the chain is still alive!\n");
+        rc = 1;
+    }
+    parent = nullptr;
+    cleanup();
+    return rc;
+}
@@ -0,0 +1,79 @@
+#include "apex_api.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define NUM_THREADS 4
+#define NUM_CHILDREN 100
+
+using namespace apex;
+using namespace std;
+
+void worker(void) {
+    register_thread("taskgraph worker");
+    std::shared_ptr<task_wrapper> parent = new_task("graph parent");
+    start(parent);
+    for (int i = 0 ; i < NUM_CHILDREN ; i++) {
+        std::shared_ptr<task_wrapper> child =
+            new_task("graph child", UINTMAX_MAX, parent);
+        start(child);
+        stop(child);
+    }
+    stop(parent);
+    exit_thread();
+}
+
+int main (int argc, char** argv) {
+    APEX_UNUSED(argc);
+    APEX_UNUSED(argv);
+    apex_options::use_taskgraph_output(true);
+    init("apex taskgraph edges unit test", 0, 1);
+    profiler * main_profiler = start(__func__);
+    vector<thread> threads;
+    for (int i = 0 ; i < NUM_THREADS ; i++) {
+        threads.push_back(thread(worker));
+    }
+    for (auto &t : threads) { t.join(); }
+    stop(main_profiler);
+    // writes the task graph
+    finalize();
+    stringstream dotname;
+    dotname << apex_options::output_file_path() << "/taskgraph.0.dot";
+    ifstream dot(dotname.str());
+    if (!dot.good()) {
+        printf("Could not read %s\n", dotname.str().c_str());
+        cleanup();
+        return 1;
+    }
+    /* Every thread counted the edge with its own task identifiers, but
+     * there should be one edge, with the calls from all threads. */
+    const string edge("\"graph parent\" -> \"graph child\"");
+    const string label("count: ");
+    int edges = 0;
+    int count = 0;
+    string line;
+    while (getline(dot, line)) {
+        if (line.find(edge) == string::npos) { continue; }
+        edges++;
+        size_t start = line.find(label);
+        if (start != string::npos) {
+            count = atoi(line.c_str() + start + label.size());
+        }
+    }
+    printf("%d edges, count %d\n", edges, count);
+    int rc = 0;
+    if (edges != 1 || count != NUM_THREADS * NUM_CHILDREN) {
+        printf("Expected one edge with count %d!\n",
+            NUM_THREADS * NUM_CHILDREN);
+        rc = 1;
+    }
+    if (rc == 0) {
+        printf("Test passed.\n");
+    }
+    cleanup();
+    return rc;
+}
@@ -0,0 +1,56 @@
+#include "apex_api.hpp"
+#include <stdio.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#define ITERATIONS 100
+
+using namespace apex;
+using namespace std;
+
+void iterate(const char * name) {
+    for (int i = 0 ; i < ITERATIONS ; i++) {
+        profiler * p = start(name);
+        stop(p);
+    }
+}
+
+int main (int argc, char** argv) {
+    APEX_UNUSED(argc);
+    APEX_UNUSED(argv);
+    apex_options::use_trace_event(true);
+    apex_options::use_trace_windows(true);
+    init("apex trace window unit test", 0, 1);
+    profiler * p = start(__func__);
+    iterate("before the window");
+    // a policy would do this when something interesting happens
+    begin_trace_window();
+    iterate("inside the window");
+    end_trace_window();
+    iterate("after the window");
+    // a timed window closes by itself
+    begin_trace_window(3600.0);
+    iterate("inside the timed window");
+    stop(p);
+    finalize();
+    stringstream ss;
+    ss << apex_options::output_file_path() << "/trace_events.0.json";
+    ifstream trace(ss.str());
+    string contents((istreambuf_iterator<char>(trace)),
+        istreambuf_iterator<char>());
+    int rc = 0;
+    if (contents.find("inside the window") == string::npos ||
+        contents.find("inside the timed window") == string::npos) {
+        printf("The window was not traced!\n");
+        rc = 1;
+    }
+    if (contents.find("before the window") != string::npos ||
+        contents.find("after the window") != string::npos) {
+        printf("Events outside the window were traced!\n");
+        rc = 1;
+    }
+    cleanup();
+    return rc;
+}
+
@@ -0,0 +1,132 @@
+#include "tuning_cache.hpp"
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace apex;
+using namespace std;
+
+const string filename("apex_tuning_cache_test.cache");
+const string merged_filename("apex_tuning_cache_merged.cache");
+
+/* A block size, a schedule and a chunk fraction */
+vector<tuning_value> tuning(long block, const string &schedule, double chunk) {
+    vector<tuning_value> values(3);
+    values[0].id = 1;
+    values[0].type = tuning_value_type::INT64;
+    values[0].lvalue = block;
+    values[1].id = 2;
+    values[1].type = tuning_value_type::STRING;
+    values[1].svalue = schedule;
+    values[2].id = 3;
+    values[2].type = tuning_value_type::DOUBLE;
+    values[2].dvalue = chunk;
+    return values;
+}
+
+bool same(const vector<tuning_value> &a, const vector<tuning_value> &b) {
+    if (a.size() != b.size()) { return false; }
+    for (size_t i = 0 ; i < a.size() ; i++) {
+        if (a[i].id != b[i].id || a[i].type != b[i].type ||
+            a[i].lvalue != b[i].lvalue || a[i].svalue != b[i].svalue ||
+            a[i].dvalue != b[i].dvalue) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main (int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    int rc = 0;
+    unlink(filename.c_str());
+    unlink(merged_filename.c_str());
+    tuning_variable variable;
+    variable.id = 1;
+    variable.name = "block_size";
+    variable.type = 1;
+    variable.category = 1;
+    variable.quantity = 0;
+    tuning_cache::append(filename, variable);
+    tuning_cache::append(filename, "[0:axpy,1:1000]", tuning(128, "static", 0.5));
+    tuning_cache::append(filename, "[0:axpy,1:2000]", tuning(256, "dynamic", 0.25));
+    if (!tuning_cache::is_cache(filename)) {
+        printf("the cache has no header!\n");
+        rc = 1;
+    }
+    tuning_cache cache;
+    string error;
+    if (!cache.read(filename, error) || !error.empty() ||
+        cache.variables.size() != 1 || cache.names.size() != 2 ||
+        cache.variables[1].name != "block_size" ||
+        !same(cache.contexts["[0:axpy,1:2000]"], tuning(256, "dynamic", 0.25))) {
+        printf("the cache was not read back! %s\n", error.c_str());
+        rc = 1;
+    }
+    // a crash while appending leaves part of a record
+    struct stat sb;
+    tuning_cache::append(filename, "[0:axpy,1:4000]", tuning(512, "static", 1.0));
+    stat(filename.c_str(), &sb);
+    if (truncate(filename.c_str(), sb.st_size - 5) != 0) {
+        perror("truncate");
+        return 1;
+    }
+    tuning_cache truncated;
+    if (!truncated.read(filename, error) || error.empty() ||
+        truncated.names.size() != 2) {
+        printf("a truncated cache should have its whole records!\n");
+        rc = 1;
+    }
+    // which are kept when the next result is appended
+    tuning_cache::append(filename, "[0:axpy,1:8000]", tuning(512, "static", 1.0));
+    tuning_cache repaired;
+    error.clear();
+    if (!repaired.read(filename, error) || !error.empty() ||
+        repaired.names.size() != 3 || repaired.names[2] != "[0:axpy,1:8000]") {
+        printf("the cache was not repaired! %s\n", error.c_str());
+        rc = 1;
+    }
+    // several writers at once
+    vector<thread> writers;
+    for (int t = 0 ; t < 4 ; t++) {
+        writers.push_back(thread([t]() {
+            for (int i = 0 ; i < 50 ; i++) {
+                tuning_cache::append(filename, "[0:dot,1:" +
+                    to_string(t * 1000 + i) + "]", tuning(t, "static", i));
+            }
+        }));
+    }
+    for (auto &w : writers) { w.join(); }
+    tuning_cache concurrent;
+    if (!concurrent.read(filename, error) || concurrent.names.size() != 203) {
+        printf("results of concurrent writers were lost! %lu contexts\n",
+            (unsigned long)concurrent.names.size());
+        rc = 1;
+    }
+    // merging keeps the first result for a context
+    tuning_cache merged;
+    merged.read(filename, error);
+    tuning_cache other;
+    other.variables[2] = variable;
+    other.variables[2].id = 2;
+    other.variables[2].name = "schedule";
+    other.add("[0:axpy,1:1000]", tuning(64, "guided", 0.1));
+    other.add("[0:gemm,1:1000]", tuning(32, "static", 1.0));
+    other.write(merged_filename);
+    merged.read(merged_filename, error);
+    merged.write(merged_filename);
+    tuning_cache result;
+    if (!result.read(merged_filename, error) || result.names.size() != 204 ||
+        result.variables.size() != 2 ||
+        !same(result.contexts["[0:axpy,1:1000]"], tuning(128, "static", 0.5))) {
+        printf("the caches were not merged!\n");
+        rc = 1;
+    }
+    unlink(filename.c_str());
+    unlink(merged_filename.c_str());
+    return rc;
+}
@@ -0,0 +1,17 @@
+#include "apex.h"
+#include <unistd.h>
+#include <stdio.h>
+
+int main (int argc, char** argv) {
+  apex_init("apex_sample_counter unit test", 0, 1);
+  apex_set_use_screen_output(1);
+  apex_counter_handle counterA = apex_register_counter("counterA");
+  apex_counter_handle counterB = apex_register_counter("counterB");
+  apex_sample_counter(counterA, 1);
+  apex_sample_counter(counterB, 1);
+  apex_sample_counter(counterA, 1);
+  apex_finalize();
+  apex_cleanup();
+  return 0;
+}
+
@@ -0,0 +1,471 @@
+/*
+ * Copyright (c) 2014-2021 Kevin Huck
+ * Copyright (c) 2014-2021 University of Oregon
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+/* Measures the cost of the instrumentation API:
+ *   apex_microbench [-n iterations] [-t max_threads] [-c configuration]
+ *                   [-o output.json]
+ * Every operation is timed with 1, 2, 4... up to max_threads threads, for
+ * every listener configuration.  The listeners are chosen when APEX is
+ * initialized, so each configuration runs in its own child process with
+ * the right environment.  The results are written as JSON, to stdout or
+ * to the -o file, so they can be compared between releases.  The growth
+ * of the resident memory during each run is included, which shows the
+ * memory held by live tasks (see task_chain).  The kokkos_* operations
+ * call the Kokkos profiling hooks the way Kokkos does, for the cost of a
+ * kernel launch, region or deep copy as the application sees it.
+ */
+
+#include "apex_api.hpp"
+#include "apex_config.h"
+#include "apex_kokkos.hpp"
+#include "utils.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+struct configuration {
+    const char * name;
+    const char * variable; // the option that enables it, if any
+    bool policies;
+};
+
+/* Each one adds to the plain profile. */
+static const configuration configurations[] = {
+    {"profile",      nullptr, false},
+    {"trace_event",  "APEX_TRACE_EVENT", false},
+#ifdef APEX_HAVE_OTF2
+    // without OTF2 support, this would measure the plain profile again
+    {"otf2",         "APEX_OTF2", false},
+#endif
+    {"policies",     "APEX_POLICY", true},
+    {"taskgraph",    "APEX_TASKGRAPH_OUTPUT", false},
+    {"tasktree",     "APEX_TASKTREE_OUTPUT", false},
+    {"critical_path", "APEX_CRITICAL_PATH", false},
+    {"track_memory", "APEX_TRACK_MEMORY", false}
+};
+static const size_t num_configurations =
+    sizeof(configurations) / sizeof(configurations[0]);
+
+static void bench_address(void) {}
+
+/* One thread doing one operation, iterations times.  Returns the elapsed
+ * time in nanoseconds. */
+typedef uint64_t (*operation_function)(size_t iterations);
+
+static uint64_t now(void) {
+    return chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint64_t start_stop_name(size_t iterations) {
+    const string name("microbench timer");
+    uint64_t begin = now();
+    for (size_t i = 0 ; i < iterations ; i++) {
+        apex::profiler * p = apex::start(name);
+        apex::stop(p);
+    }
+    return now() - begin;
+}
+
+static uint64_t start_stop_address(size_t iterations) {
+    uint64_t begin = now();
+    for (size_t i = 0 ; i < iterations ; i++) {
+        apex::profiler * p =
+            apex::start((apex_function_address)(&bench_address));
+        apex::stop(p);
+    }
+    return now() - begin;
+}
+
+static uint64_t start_stop_task_wrapper(size_t iterations) {
+    const string name("microbench task");
+    // create the tasks first, so only the start and stop are timed
+    vector<shared_ptr<apex::task_wrapper> > tasks;
+    tasks.reserve(iterations);
+    for (size_t i = 0 ; i < iterations ; i++) {
+        tasks.push_back(apex::new_task(name));
+    }
+    uint64_t begin = now();
+    for (auto &task : tasks) {
+        apex::start(task);
+        apex::stop(task);
+    }
+    return now() - begin;
+}
+
+static uint64_t yield_resume(size_t iterations) {
+    shared_ptr<apex::task_wrapper> task =
+        apex::new_task("microbench yielding task");
+    apex::start(task);
+    uint64_t begin = now();
+    for (size_t i = 0 ; i < iterations ; i++) {
+        apex::yield(task);
+        apex::resume(task);
+    }
+    uint64_t elapsed = now() - begin;
+    apex::stop(task);
+    return elapsed;
+}
+
+static uint64_t sample_value(size_t iterations) {
+    const string name("microbench counter");
+    uint64_t begin = now();
+    for (size_t i = 0 ; i < iterations ; i++) {
+        apex::sample_value(name, (double)i);
+    }
+    return now() - begin;
+}
+
+static uint64_t new_task(size_t iterations) {
+    const string name("microbench new task");
+    uint64_t begin = now();
+    for (size_t i = 0 ; i < iterations ; i++) {
+        shared_ptr<apex::task_wrapper> task = apex::new_task(name);
+    }
+    return now() - begin;
+}
+
+static uint64_t update_task(size_t iterations) {
+    const string names[2] = {string("microbench task A"),
+        string("microbench task B")};
+    shared_ptr<apex::task_wrapper> task = apex::new_task(names[0]);
+    uint64_t begin = now();
+    for (size_t i = 0 ; i < iterations ; i++) {
+        task = apex::update_task(task, names[(i + 1) & 1]);
+    }
+    return now() - begin;
+}
+
+/* Every task is the child of the one before, and the one before is
+ * released as soon as its child exists, like a chain of continuations. */
+static uint64_t task_chain(size_t iterations) {
+    const string name("microbench chained task");
+    shared_ptr<apex::task_wrapper> parent = apex::new_task(name);
+    uint64_t begin = now();
+    for (size_t i = 0 ; i < iterations ; i++) {
+        shared_ptr<apex::task_wrapper> child =
+            apex::new_task(name, UINTMAX_MAX, parent);
+        apex::start(child);
+        apex::stop(child);
+        parent = child;
+    }
+    return now() - begin;
+}
+
+/* The Kokkos profiling hooks in libapex */
+extern "C" {
+void kokkosp_begin_parallel_for(const char* name, uint32_t devid,
+    uint64_t* kernid);
+void kokkosp_end_parallel_for(uint64_t kernid);
+void kokkosp_push_profile_region(const char* name);
+void kokkosp_pop_profile_region();
+void kokkosp_begin_deep_copy(SpaceHandle dst_handle, const char* dst_name,
+    const void* dst_ptr, SpaceHandle src_handle, const char* src_name,
+    const void* src_ptr, uint64_t size);
+void kokkosp_end_deep_copy();
+}
+
+/* An application launches a few kernels over and over.  Kokkos passes the
+ * name from a std::string, and unnamed kernels get the (long) type name of
+ * the functor, so the names are long strings here too. */
+static const size_t num_kernels = 8;
+
+static vector<string> kernel_names(const char * prefix) {
+    vector<string> names;
+    for (size_t k = 0 ; k < num_kernels ; k++) {
+        names.push_back(string(prefix) + " " + to_string(k) +
+            " Kokkos::Impl::ViewValueFunctor<Kokkos::HostSpace, double>");
+    }
+    return names;
+}
+
+static uint64_t kokkos_parallel_for(size_t iterations) {
+    const vector<string> names(kernel_names("microbench kernel"));
+    uint64_t begin = now();
+    for (size_t i = 0 ; i < iterations ; i++) {
+        uint64_t kernid = 0;
+        kokkosp_begin_parallel_for(names[i % num_kernels].c_str(), 0, &kernid);
+        kokkosp_end_parallel_for(kernid);
+    }
+    return now() - begin;
+}
+
+static uint64_t kokkos_region(size_t iterations) {
+    const vector<string> names(kernel_names("microbench region"));
+    uint64_t begin = now();
+    for (size_t i = 0 ; i < iterations ; i++) {
+        kokkosp_push_profile_region(names[i % num_kernels].c_str());
+        kokkosp_pop_profile_region();
+    }
+    return now() - begin;
+}
+
+static uint64_t kokkos_deep_copy(size_t iterations) {
+    const vector<string> names(kernel_names("microbench view"));
+    SpaceHandle host;
+    memset(&host, 0, sizeof(host));
+    strcpy(host.name, "Host");
+    uint64_t begin = now();
+    for (size_t i = 0 ; i < iterations ; i++) {
+        const char * name = names[i % num_kernels].c_str();
+        kokkosp_begin_deep_copy(host, name, nullptr, host, name, nullptr,
+            4096);
+        kokkosp_end_deep_copy();
+    }
+    return now() - begin;
+}
+
+static apex_event_type bench_event;
+
+static uint64_t custom_event(size_t iterations) {
+    uint64_t begin = now();
+    for (size_t i = 0 ; i < iterations ; i++) {
+        apex::custom_event(bench_event, nullptr);
+    }
+    return now() - begin;
+}
+
+struct operation {
+    const char * name;
+    operation_function function;
+};
+
+static const operation operations[] = {
+    {"start_stop_name", start_stop_name},
+    {"start_stop_address", start_stop_address},
+    {"start_stop_task_wrapper", start_stop_task_wrapper},
+    {"yield_resume", yield_resume},
+    {"sample_value", sample_value},
+    {"new_task", new_task},
+    {"update_task", update_task},
+    {"task_chain", task_chain},
+    {"custom_event", custom_event},
+    {"kokkos_parallel_for", kokkos_parallel_for},
+    {"kokkos_region", kokkos_region},
+    {"kokkos_deep_copy", kokkos_deep_copy}
+};
+static const size_t num_operations = sizeof(operations) / sizeof(operations[0]);
+
+/* The resident set size of this process, in kilobytes. */
+static long resident_kb(void) {
+    long pages = 0, resident = 0;
+    FILE * f = fopen("/proc/self/statm", "r");
+    if (f == nullptr) { return 0; }
+    if (fscanf(f, "%ld %ld", &pages, &resident) != 2) { resident = 0; }
+    fclose(f);
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static int noop_policy(apex_context const &context) {
+    APEX_UNUSED(context);
+    return APEX_NOERROR;
+}
+
+/* Run the operation on num_threads threads at once.  They all wait for
+ * each other before starting, and the slowest one gives the time. */
+static uint64_t run_threads(operation_function function, size_t num_threads,
+    size_t iterations) {
+    atomic<size_t> ready(0);
+    atomic<bool> go(false);
+    vector<uint64_t> elapsed(num_threads, 0);
+    vector<thread> threads;
+    for (size_t t = 0 ; t < num_threads ; t++) {
+        threads.push_back(thread([&, t]() {
+            apex::register_thread("microbench worker");
+            ready++;
+            while (!go) { }
+            elapsed[t] = function(iterations);
+            apex::exit_thread();
+        }));
+    }
+    while (ready < num_threads) { }
+    go = true;
+    uint64_t slowest = 0;
+    for (size_t t = 0 ; t < num_threads ; t++) {
+        threads[t].join();
+        slowest = max(slowest, elapsed[t]);
+    }
+    return slowest;
+}
+
+/* Run all of the operations in this process, with the listeners that
+ * were configured in the environment. */
+static int run_configuration(const configuration &config, size_t iterations,
+    size_t max_threads, ostream &out) {
+    apex::init("apex_microbench", 0, 1);
+    if (config.policies) {
+        apex::register_policy(APEX_START_EVENT, noop_policy);
+        apex::register_policy(APEX_STOP_EVENT, noop_policy);
+        apex::register_policy(APEX_SAMPLE_VALUE, noop_policy);
+    }
+    bench_event = apex::register_custom_event("microbench event");
+    // 1, 2, 4... and max_threads
+    vector<size_t> thread_counts;
+    for (size_t threads = 1 ; threads < max_threads ; threads *= 2) {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(max_threads);
+    bool first = true;
+    for (size_t o = 0 ; o < num_operations ; o++) {
+        for (size_t threads : thread_counts) {
+            long rss_before = resident_kb();
+            uint64_t elapsed = run_threads(operations[o].function, threads,
+                iterations);
+            long rss_growth = resident_kb() - rss_before;
+            double ns_per_op = (double)elapsed / iterations;
+            double ops_per_sec = elapsed > 0 ?
+                (threads * iterations) / (elapsed * 1.0e-9) : 0.0;
+            out << (first ? "" : ",\n")
+                << "    {\"configuration\": \"" << config.name
+                << "\", \"operation\": \"" << operations[o].name
+                << "\", \"threads\": " << threads
+                << ", \"ns_per_op\": " << ns_per_op
+                << ", \"ops_per_sec\": " << ops_per_sec
+                << ", \"rss_growth_kb\": " << rss_growth << "}";
+            first = false;
+        }
+    }
+    out << flush;
+    apex::finalize();
+    apex::cleanup();
+    return 0;
+}
+
+/* Run one configuration in a child process, and read back its results. */
+static bool run_child(const configuration &config,
+    size_t iterations, size_t max_threads, string &results) {
+    char filename[] = "/tmp/apex_microbench.XXXXXX";
+    int fd = mkstemp(filename);
+    if (fd < 0) {
+        perror("creating a temporary file");
+        return false;
+    }
+    close(fd);
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return false;
+    }
+    if (pid == 0) {
+        if (config.variable != nullptr) {
+            setenv(config.variable, "1", 1);
+        }
+        string n(to_string(iterations));
+        string t(to_string(max_threads));
+        execl("/proc/self/exe", "apex_microbench", "--child", "-n", n.c_str(),
+            "-t", t.c_str(), "-c", config.name, "-o", filename,
+            (char*)nullptr);
+        perror("exec");
+        _exit(1);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    ifstream in(filename);
+    stringstream ss;
+    ss << in.rdbuf();
+    results = ss.str();
+    unlink(filename);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        cerr << "Configuration " << config.name << " failed." << endl;
+        return false;
+    }
+    return true;
+}
+
+static void usage(const char * progname) {
+    cerr << "Usage: " << progname << " [-n iterations] [-t max_threads]"
+         << " [-c configuration] [-o output.json]" << endl;
+    cerr << "Configurations:";
+    for (size_t c = 0 ; c < num_configurations ; c++) {
+        cerr << " " << configurations[c].name;
+    }
+    cerr << endl;
+}
+
+int main (int argc, char** argv) {
+    size_t iterations = 100000;
+    size_t max_threads = apex::hardware_concurrency();
+    const char * only = nullptr;
+    const char * output = nullptr;
+    bool child = false;
+    for (int i = 1 ; i < argc ; i++) {
+        if (strcmp(argv[i], "--child") == 0) {
+            child = true;
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            iterations = strtoul(argv[++i], nullptr, 0);
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            max_threads = strtoul(argv[++i], nullptr, 0);
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            only = argv[++i];
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (iterations == 0 || max_threads == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    // a child process runs exactly one configuration
+    if (child && only != nullptr && output != nullptr) {
+        for (size_t c = 0 ; c < num_configurations ; c++) {
+            if (strcmp(configurations[c].name, only) == 0) {
+                ofstream out(output);
+                return run_configuration(configurations[c], iterations,
+                    max_threads, out);
+            }
+        }
+        usage(argv[0]);
+        return 1;
+    }
+    stringstream json;
+    json << "{\n  \"apex_version\": \"" << APEX_VERSION_MAJOR << "."
+         << APEX_VERSION_MINOR << "\""
+         << ",\n  \"git_commit\": \"" << GIT_COMMIT_HASH << "\""
+         << ",\n  \"hardware_threads\": " << apex::hardware_concurrency()
+         << ",\n  \"iterations\": " << iterations
+         << ",\n  \"results\": [\n";
+    bool first = true;
+    int rc = 0;
+    for (size_t c = 0 ; c < num_configurations ; c++) {
+        if (only != nullptr && strcmp(configurations[c].name, only) != 0) {
+            continue;
+        }
+        cerr << "Running " << configurations[c].name << "..." << endl;
+        string results;
+        if (!run_child(configurations[c], iterations, max_threads, results)) {
+            rc = 1;
+        }
+        if (results.size() == 0) { continue; }
+        json << (first ? "" : ",\n") << results;
+        first = false;
+    }
+    json << "\n  ]\n}\n";
+    if (output != nullptr) {
+        ofstream out(output);
+        out << json.str();
+    } else {
+        cout << json.str();
+    }
+    return rc;
+}
+
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2014-2021 Kevin Huck
+ * Copyright (c) 2014-2021 University of Oregon
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+/* Replays an event log written with APEX_RECORD_EVENTS:
+ *   apex_replay [-r repeats] apex_events.0.bin
+ * Every recorded thread gets a replay thread, which issues the events of
+ * that thread in their recorded order, as fast as it can.  The listeners
+ * are configured with the usual environment variables, so the same log can
+ * be used to compare listener configurations, or releases, without the
+ * application that produced it.  The events between threads are not
+ * ordered, only the events within each thread are.
+ */
+
+#include "apex_api.hpp"
+#include "event_log.hpp"
+#include "utils.hpp"
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+using apex::recorded_event;
+using apex::recorded_event_type;
+
+static uint64_t now(void) {
+    return chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* The tasks are created before the replay starts, in the order they were
+ * first started or resumed, so that parents exist before their children.
+ * A task whose start wasn't recorded may only be resumed. */
+typedef unordered_map<uint64_t, shared_ptr<apex::task_wrapper> > task_map;
+
+static void create_tasks(const apex::event_log_reader &log, task_map &tasks) {
+    vector<const recorded_event*> starts;
+    for (auto &e : log.events) {
+        if (e.type == recorded_event_type::START ||
+            e.type == recorded_event_type::RESUME) {
+            starts.push_back(&e);
+        }
+    }
+    stable_sort(starts.begin(), starts.end(),
+        [](const recorded_event * a, const recorded_event * b) {
+            return a->timestamp < b->timestamp; });
+    for (auto e : starts) {
+        if (tasks.find(e->guid) != tasks.end()) { continue; }
+        auto parent = tasks.find(e->parent_guid);
+        tasks[e->guid] = apex::new_task(log.names[e->name], e->guid,
+            parent == tasks.end() ? nullptr : parent->second);
+    }
+}
+
+static shared_ptr<apex::task_wrapper> find_task(const task_map &tasks,
+    uint64_t guid) {
+    auto task = tasks.find(guid);
+    return task == tasks.end() ? nullptr : task->second;
+}
+
+static void replay_thread(const apex::event_log_reader &log,
+    const vector<const recorded_event*> &events, const task_map &tasks) {
+    for (auto e : events) {
+        shared_ptr<apex::task_wrapper> task;
+        switch (e->type) {
+            case recorded_event_type::START:
+            case recorded_event_type::RESUME:
+            case recorded_event_type::STOP:
+            case recorded_event_type::YIELD:
+                task = find_task(tasks, e->guid);
+                if (task == nullptr) { continue; }
+                break;
+            default:
+                break;
+        }
+        switch (e->type) {
+            case recorded_event_type::START:
+                apex::start(task);
+                break;
+            case recorded_event_type::RESUME:
+                apex::resume(task);
+                break;
+            case recorded_event_type::STOP:
+                apex::stop(task);
+                break;
+            case recorded_event_type::YIELD:
+                apex::yield(task);
+                break;
+            case recorded_event_type::SAMPLE:
+                apex::sample_value(log.names[e->name], e->value);
+                break;
+            case recorded_event_type::SEND:
+                apex::send(e->guid, e->parent_guid, e->rank);
+                break;
+            case recorded_event_type::RECV:
+                apex::recv(e->guid, e->parent_guid, e->rank, e->name);
+                break;
+        }
+    }
+}
+
+int main (int argc, char** argv) {
+    const char * filename = nullptr;
+    size_t repeats = 1;
+    for (int i = 1 ; i < argc ; i++) {
+        if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            repeats = strtoul(argv[++i], nullptr, 0);
+        } else if (filename == nullptr && argv[i][0] != '-') {
+            filename = argv[i];
+        } else {
+            filename = nullptr;
+            break;
+        }
+    }
+    if (filename == nullptr || repeats == 0) {
+        cerr << "Usage: " << argv[0] << " [-r repeats] apex_events.N.bin"
+             << endl;
+        return 1;
+    }
+    apex::event_log_reader log(filename);
+    if (!log.ok()) {
+        cerr << "Error: " << log.error() << endl;
+        return 1;
+    }
+    // the events of each thread, in order
+    map<uint32_t, vector<const recorded_event*> > threads;
+    for (auto &e : log.events) {
+        threads[e.thread].push_back(&e);
+    }
+    apex::init("apex_replay", 0, 1);
+    uint64_t total = 0;
+    for (size_t r = 0 ; r < repeats ; r++) {
+        // every repeat gets new tasks, as the application would
+        task_map tasks;
+        create_tasks(log, tasks);
+        atomic<size_t> ready(0);
+        atomic<bool> go(false);
+        vector<thread> workers;
+        for (auto &events : threads) {
+            workers.push_back(thread([&, &events = events.second]() {
+                apex::register_thread("replay worker");
+                ready++;
+                while (!go) { }
+                replay_thread(log, events, tasks);
+                apex::exit_thread();
+            }));
+        }
+        while (ready < workers.size()) { }
+        uint64_t begin = now();
+        go = true;
+        for (auto &w : workers) { w.join(); }
+        total += now() - begin;
+    }
+    double seconds = total * 1.0e-9;
+    size_t events = log.events.size() * repeats;
+    cout << "{\n  \"file\": \"" << filename << "\""
+         << ",\n  \"threads\": " << threads.size()
+         << ",\n  \"names\": " << log.names.size()
+         << ",\n  \"events\": " << events
+         << ",\n  \"seconds\": " << seconds
+         << ",\n  \"ns_per_event\": "
+         << (events > 0 ? (double)total / events : 0.0)
+         << ",\n  \"events_per_sec\": "
+         << (total > 0 ? events / seconds : 0.0) << "\n}" << endl;
+    apex::finalize();
+    apex::cleanup();
+    return 0;
+}
+
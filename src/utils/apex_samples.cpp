@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2014-2021 Kevin Huck
+ * Copyright (c) 2014-2021 University of Oregon
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+/* Convert binary scatterplot samples (apex_task_samples.N.bin and
+ * apex_counter_samples.N.bin) to the CSV files read by task_scatterplot.py
+ * and counter_scatterplot.py:
+ *   apex_samples <file.bin> [file.bin...]
+ * Each file is written next to its input, with a .csv extension.
+ */
+
+#include "scatterplot_samples.hpp"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+
+using namespace apex;
+using namespace std;
+
+static int convert(const string &filename) {
+    scatterplot_reader reader(filename);
+    if (!reader.valid()) {
+        cerr << reader.error() << endl;
+        return 1;
+    }
+    string output(filename);
+    string extension(scatterplot_extension);
+    if (output.size() > extension.size() &&
+        output.compare(output.size() - extension.size(),
+            extension.size(), extension) == 0) {
+        output.resize(output.size() - extension.size());
+    }
+    output += ".csv";
+    ofstream csv(output);
+    if (!csv.is_open()) {
+        cerr << "Failed to open " << output << endl;
+        return 1;
+    }
+    csv << setprecision(15);
+    for (auto &s : reader.samples) {
+        csv << s.timestamp << " " << s.value << " '"
+            << reader.names[s.id] << "'" << endl;
+    }
+    cout << filename << " -> " << output << ": " << reader.samples.size()
+         << " samples of " << reader.names.size() << " timers" << endl;
+    return 0;
+}
+
+int main (int argc, char** argv) {
+    if (argc < 2) {
+        cerr << "Usage: " << argv[0] << " <file.bin> [file.bin...]" << endl;
+        return 1;
+    }
+    int rc = 0;
+    for (int i = 1 ; i < argc ; i++) {
+        rc |= convert(string(argv[i]));
+    }
+    return rc;
+}
+
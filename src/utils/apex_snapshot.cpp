@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2014-2021 Kevin Huck
+ * Copyright (c) 2014-2021 University of Oregon
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+/* Command line tool for binary profile snapshots (apex_profile.N.snap):
+ *   apex_snapshot print <file>
+ *   apex_snapshot merge [-j threads] <output> <input> [input...]
+ *   apex_snapshot diff <before> <after>
+ */
+
+#include "profile_snapshot.hpp"
+#include "utils.hpp"
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <iomanip>
+#include <unordered_map>
+
+using namespace apex;
+using namespace std;
+
+static void usage(const char * progname) {
+    cerr << "Usage:" << endl;
+    cerr << "  " << progname << " print <file>" << endl;
+    cerr << "  " << progname
+         << " merge [-j threads] <output> <input> [input...]" << endl;
+    cerr << "  " << progname << " diff <before> <after>" << endl;
+}
+
+static void print_row(const char * name, uint64_t type, const double * values) {
+    double calls = values[SNAPSHOT_CALLS];
+    double mean = calls > 0.0 ? values[SNAPSHOT_ACCUMULATED] / calls : 0.0;
+    cout << (type == APEX_TIMER ? "timer   " : "counter ")
+         << setw(12) << calls << " "
+         << setw(14) << values[SNAPSHOT_ACCUMULATED] << " "
+         << setw(14) << mean << " "
+         << setw(14) << values[SNAPSHOT_MINIMUM] << " "
+         << setw(14) << values[SNAPSHOT_MAXIMUM] << " "
+         << setw(14) << values[SNAPSHOT_BYTES_ALLOCATED] << " "
+         << name << endl;
+}
+
+static void print_header(void) {
+    cout << "type    " << setw(12) << "calls" << " "
+         << setw(14) << "accumulated" << " " << setw(14) << "mean" << " "
+         << setw(14) << "minimum" << " " << setw(14) << "maximum" << " "
+         << setw(14) << "bytes_alloc" << " name" << endl;
+}
+
+static int print(const string &filename) {
+    snapshot_reader reader(filename);
+    if (!reader.valid()) {
+        cerr << reader.error() << endl;
+        return 1;
+    }
+    cout << "node " << reader.node_id() << ", " << reader.size()
+         << " profiles" << endl;
+    print_header();
+    double values[SNAPSHOT_NUM_COLUMNS];
+    for (size_t i = 0 ; i < reader.size() ; i++) {
+        for (int c = 0 ; c < SNAPSHOT_NUM_COLUMNS ; c++) {
+            values[c] = reader.column((snapshot_column)c)[i];
+        }
+        print_row(reader.name(i), reader.type(i), values);
+    }
+    return 0;
+}
+
+static int merge(int argc, char ** argv) {
+    unsigned int threads = hardware_concurrency();
+    int first = 0;
+    if (argc > 1 && strcmp(argv[0], "-j") == 0) {
+        threads = atoi(argv[1]);
+        first = 2;
+    }
+    if (argc - first < 2) {
+        return -1;
+    }
+    string output(argv[first]);
+    vector<string> inputs;
+    for (int i = first + 1 ; i < argc ; i++) {
+        inputs.push_back(string(argv[i]));
+    }
+    profile_snapshot merged = merge_snapshots(inputs, threads);
+    if (!merged.write(output)) {
+        cerr << "Failed to write " << output << endl;
+        return 1;
+    }
+    cout << "Merged " << inputs.size() << " snapshots, " << merged.size()
+         << " profiles" << endl;
+    return 0;
+}
+
+/* Print the change in each column, for every profile in either file. */
+static int diff(const string &before_file, const string &after_file) {
+    snapshot_reader before(before_file);
+    snapshot_reader after(after_file);
+    if (!before.valid() || !after.valid()) {
+        cerr << (before.valid() ? after.error() : before.error()) << endl;
+        return 1;
+    }
+    unordered_map<string, size_t> index;
+    for (size_t i = 0 ; i < before.size() ; i++) {
+        index[before.name(i)] = i;
+    }
+    print_header();
+    double values[SNAPSHOT_NUM_COLUMNS];
+    for (size_t i = 0 ; i < after.size() ; i++) {
+        auto it = index.find(after.name(i));
+        for (int c = 0 ; c < SNAPSHOT_NUM_COLUMNS ; c++) {
+            values[c] = after.column((snapshot_column)c)[i];
+            if (it != index.end()) {
+                values[c] -= before.column((snapshot_column)c)[it->second];
+            }
+        }
+        if (it != index.end()) {
+            index.erase(it);
+        }
+        print_row(after.name(i), after.type(i), values);
+    }
+    // anything left only existed before
+    for (auto &kv : index) {
+        for (int c = 0 ; c < SNAPSHOT_NUM_COLUMNS ; c++) {
+            values[c] = -before.column((snapshot_column)c)[kv.second];
+        }
+        print_row(kv.first.c_str(), before.type(kv.second), values);
+    }
+    return 0;
+}
+
+int main (int argc, char** argv) {
+    int rc = -1;
+    if (argc > 2 && strcmp(argv[1], "print") == 0) {
+        rc = print(string(argv[2]));
+    } else if (argc > 3 && strcmp(argv[1], "merge") == 0) {
+        rc = merge(argc - 2, argv + 2);
+    } else if (argc > 3 && strcmp(argv[1], "diff") == 0) {
+        rc = diff(string(argv[2]), string(argv[3]));
+    }
+    if (rc < 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    return rc;
+}
+
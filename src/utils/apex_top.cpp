@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2014-2021 Kevin Huck
+ * Copyright (c) 2014-2021 University of Oregon
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+/* Live view of a running APEX process, which must have been started
+ * with APEX_SHARED_PROFILE=1:
+ *   apex_top <pid> [-i seconds] [-n rows] [-c]
+ * -c writes CSV (one block of rows per interval) instead of a table.
+ */
+
+#include "shared_profile.hpp"
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <unordered_map>
+#include <chrono>
+#include <thread>
+
+using namespace apex;
+using namespace std;
+
+struct rate {
+    const shared_profile_row * row;
+    double calls;
+    double accumulated;
+};
+
+static void usage(const char * progname) {
+    cerr << "Usage: " << progname << " <pid> [-i seconds] [-n rows] [-c]"
+         << endl;
+}
+
+int main (int argc, char** argv) {
+    if (argc < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+    uint32_t pid = atoi(argv[1]);
+    double interval = 1.0;
+    size_t max_rows = 20;
+    bool csv = false;
+    for (int i = 2 ; i < argc ; i++) {
+        if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            interval = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            max_rows = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-c") == 0) {
+            csv = true;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    shared_profile_reader reader(pid);
+    if (!reader.valid()) {
+        cerr << reader.error() << endl;
+        return 1;
+    }
+    if (csv) {
+        cout << "\"elapsed\",\"name\",\"type\",\"calls\",\"accumulated\","
+             << "\"calls/s\",\"time/s\"" << endl;
+    }
+    vector<shared_profile_row> previous;
+    vector<shared_profile_row> current;
+    unordered_map<string, size_t> index;
+    auto last = chrono::steady_clock::now();
+    auto start = last;
+    // keep going until the process goes away
+    while (kill(pid, 0) == 0) {
+        this_thread::sleep_for(chrono::duration<double>(interval));
+        auto now = chrono::steady_clock::now();
+        double seconds = chrono::duration<double>(now - last).count();
+        double elapsed = chrono::duration<double>(now - start).count();
+        last = now;
+        reader.read(current);
+        vector<rate> rates;
+        for (auto &row : current) {
+            rate r = { &row, row.calls, row.accumulated };
+            auto it = index.find(row.name);
+            if (it != index.end()) {
+                r.calls -= previous[it->second].calls;
+                r.accumulated -= previous[it->second].accumulated;
+            }
+            rates.push_back(r);
+        }
+        sort(rates.begin(), rates.end(), [](const rate &a, const rate &b) {
+            return a.accumulated > b.accumulated;
+        });
+        if (csv) {
+            for (auto &r : rates) {
+                cout << elapsed << ",\"" << r.row->name << "\","
+                     << (r.row->type == APEX_TIMER ? "timer" : "counter") << ","
+                     << r.row->calls << "," << r.row->accumulated << ","
+                     << r.calls / seconds << "," << r.accumulated / seconds
+                     << endl;
+            }
+        } else {
+            // clear the screen and go home
+            cout << "\033[2J\033[H";
+            cout << "APEX process " << pid << ", " << current.size()
+                 << " timers and counters" << endl << endl;
+            cout << setw(14) << "calls/s" << setw(14) << "% of 1 core"
+                 << setw(14) << "mean (us)" << "  name" << endl;
+            size_t n = 0;
+            for (auto &r : rates) {
+                if (n++ >= max_rows) { break; }
+                double mean = r.row->calls > 0.0 ?
+                    r.row->accumulated / r.row->calls : 0.0;
+                cout << setw(14) << fixed << setprecision(1)
+                     << r.calls / seconds;
+                if (r.row->type == APEX_TIMER) {
+                    // timers are accumulated in nanoseconds
+                    cout << setw(14) << (r.accumulated * 1.0e-7) / seconds
+                         << setw(14) << mean * 1.0e-3;
+                } else {
+                    cout << setw(14) << "" << setw(14) << mean;
+                }
+                cout << "  " << r.row->name << endl;
+            }
+        }
+        cout.flush();
+        previous.swap(current);
+        index.clear();
+        for (size_t i = 0 ; i < previous.size() ; i++) {
+            index[previous[i].name] = i;
+        }
+    }
+    return 0;
+}
+
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2014-2021 Kevin Huck
+ * Copyright (c) 2014-2021 University of Oregon
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See accompanying
+ * file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+/* Command line tool for binary Kokkos tuning caches
+ * (apex_converged_tuning.cache):
+ *   apex_tuning_cache print <file>
+ *   apex_tuning_cache merge <output> <input> [input...]
+ * Merging keeps the first result for every context, so list the inputs
+ * you trust most first.  The output can be one of the inputs.
+ */
+
+#include "tuning_cache.hpp"
+#include <string.h>
+#include <iostream>
+
+using namespace apex;
+using namespace std;
+
+static void usage(const char * progname) {
+    cerr << "Usage:" << endl;
+    cerr << "  " << progname << " print <file>" << endl;
+    cerr << "  " << progname << " merge <output> <input> [input...]" << endl;
+}
+
+static int print(const string &filename) {
+    tuning_cache cache;
+    string error;
+    bool ok = cache.read(filename, error);
+    if (!error.empty()) {
+        cerr << error << endl;
+    }
+    if (!ok) {
+        return 1;
+    }
+    cout << cache.variables.size() << " variables, " << cache.names.size()
+         << " contexts" << endl;
+    for (auto &v : cache.variables) {
+        cout << "variable " << v.first << ": " << v.second.name << endl;
+    }
+    for (auto &name : cache.names) {
+        cout << name << endl;
+        for (auto &value : cache.contexts[name]) {
+            auto variable = cache.variables.find(value.id);
+            cout << "  " << (variable == cache.variables.end() ?
+                to_string(value.id) : variable->second.name) << ": ";
+            switch (value.type) {
+                case tuning_value_type::DOUBLE:
+                    cout << value.dvalue << endl;
+                    break;
+                case tuning_value_type::INT64:
+                    cout << value.lvalue << endl;
+                    break;
+                case tuning_value_type::STRING:
+                    cout << value.svalue << endl;
+                    break;
+            }
+        }
+    }
+    return 0;
+}
+
+static int merge(int argc, char ** argv) {
+    string output(argv[0]);
+    tuning_cache merged;
+    size_t contexts = 0;
+    for (int i = 1 ; i < argc ; i++) {
+        tuning_cache cache;
+        string error;
+        bool ok = cache.read(string(argv[i]), error);
+        if (!error.empty()) {
+            cerr << error << endl;
+        }
+        if (!ok) {
+            return 1;
+        }
+        for (auto &v : cache.variables) {
+            auto known = merged.variables.find(v.first);
+            if (known != merged.variables.end() &&
+                known->second.name != v.second.name) {
+                cerr << argv[i] << ": variable " << v.first << " is "
+                     << v.second.name << ", not " << known->second.name
+                     << endl;
+                return 1;
+            }
+            merged.variables.insert(v);
+        }
+        for (auto &name : cache.names) {
+            merged.add(name, cache.contexts[name]);
+        }
+        contexts += cache.names.size();
+    }
+    if (!merged.write(output)) {
+        cerr << "Failed to write " << output << endl;
+        return 1;
+    }
+    cout << "Merged " << argc - 1 << " caches, " << merged.names.size()
+         << " of " << contexts << " contexts" << endl;
+    return 0;
+}
+
+int main (int argc, char** argv) {
+    int rc = -1;
+    if (argc > 2 && strcmp(argv[1], "print") == 0) {
+        rc = print(string(argv[2]));
+    } else if (argc > 3 && strcmp(argv[1], "merge") == 0) {
+        rc = merge(argc - 2, argv + 2);
+    }
+    if (rc < 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    return rc;
+}
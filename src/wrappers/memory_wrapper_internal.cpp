@@ -122,10 +122,27 @@ inline void printBacktrace() {
   }
 }
 
+/* Look the counter names up once, these are sampled on every allocation. */
+struct memory_counters {
+    apex_counter_handle allocated;
+    apex_counter_handle freed;
+    apex_counter_handle occupied;
+    memory_counters() :
+        allocated(apex::register_counter("Memory: Bytes Allocated")),
+        freed(apex::register_counter("Memory: Bytes Freed")),
+        occupied(apex::register_counter("Memory: Total Bytes Occupied")) {}
+};
+
+memory_counters& getCounters() {
+    static memory_counters counters;
+    return counters;
+}
+
 void record_alloc(size_t bytes, void* ptr, allocator_t alloc) {
     static book_t& book = getBook();
+    static memory_counters& counters = getCounters();
     double value = (double)(bytes);
-    apex::sample_value("Memory: Bytes Allocated", value, true);
+    apex::sample_value(counters.allocated, value);
     apex::profiler * p = apex::thread_instance::instance().get_current_profiler();
     record_t tmp(value, apex::thread_instance::instance().get_id(), alloc);
     if (p != nullptr) { tmp.id = p->get_task_id(); }
@@ -138,7 +155,7 @@ void record_alloc(size_t bytes, void* ptr, allocator_t alloc) {
     book.mapMutex.unlock();
     book.totalAllocated.fetch_add(bytes, std::memory_order_relaxed);
     value = (double)(book.totalAllocated);
-    apex::sample_value("Memory: Total Bytes Occupied", value);
+    apex::sample_value(counters.occupied, value);
     if (p == nullptr) {
         auto i = apex::apex::instance();
         // might be after finalization, so double-check!
@@ -153,6 +170,7 @@ void record_alloc(size_t bytes, void* ptr, allocator_t alloc) {
 
 void record_free(void* ptr) {
     static book_t& book = getBook();
+    static memory_counters& counters = getCounters();
     size_t bytes;
     book.mapMutex.lock();
     if (book.memoryMap.count(ptr) > 0) {
@@ -167,10 +185,10 @@ void record_free(void* ptr) {
     }
     book.mapMutex.unlock();
     double value = (double)(bytes);
-    apex::sample_value("Memory: Bytes Freed", value, true);
+    apex::sample_value(counters.freed, value);
     book.totalAllocated.fetch_sub(bytes, std::memory_order_relaxed);
     value = (double)(book.totalAllocated);
-    apex::sample_value("Memory: Total Bytes Occupied", value);
+    apex::sample_value(counters.occupied, value);
     apex::profiler * p = apex::thread_instance::instance().get_current_profiler();
     if (p == nullptr) {
         auto i = apex::apex::instance();